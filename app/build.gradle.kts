@@ -4,6 +4,10 @@ plugins {
     alias(libs.plugins.kotlin.compose)
 }
 
+// Link OpenCV core/imgproc into libedgevision instead of shipping libopencv_java4.so
+// (see EDGEVISION_OPENCV_STATIC in src/main/cpp/CMakeLists.txt)
+val opencvStatic = (findProperty("edgevision.opencvStatic") as String?)?.toBoolean() ?: false
+
 android {
     namespace = "com.example.edgevision"
     compileSdk = 36
@@ -24,7 +28,10 @@ android {
         externalNativeBuild {
             cmake {
                 cppFlags += "-std=c++17"
-                arguments += listOf("-DANDROID_STL=c++_shared")
+                arguments += listOf(
+                    "-DANDROID_STL=c++_shared",
+                    "-DEDGEVISION_OPENCV_STATIC=${if (opencvStatic) "ON" else "OFF"}"
+                )
             }
         }
     }
@@ -48,6 +55,14 @@ android {
     buildFeatures {
         compose = true
     }
+    packaging {
+        jniLibs {
+            // Nothing loads it when OpenCV is linked statically; it is most of the APK
+            if (opencvStatic) {
+                excludes += "**/libopencv_java4.so"
+            }
+        }
+    }
 
     externalNativeBuild {
         cmake {
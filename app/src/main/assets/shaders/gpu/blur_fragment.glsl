@@ -0,0 +1,16 @@
+precision mediump float;
+
+varying vec2 vTexCoord;
+uniform sampler2D uTexture;
+// One texel along the blur axis: (1/w, 0) for horizontal, (0, 1/h) for vertical
+uniform vec2 uTexelStep;
+
+void main() {
+    // 5-tap Gaussian, sigma 1.5 (same weights as the CPU path)
+    float sum = texture2D(uTexture, vTexCoord).r * 0.2921;
+    sum += (texture2D(uTexture, vTexCoord - uTexelStep).r +
+            texture2D(uTexture, vTexCoord + uTexelStep).r) * 0.2339;
+    sum += (texture2D(uTexture, vTexCoord - 2.0 * uTexelStep).r +
+            texture2D(uTexture, vTexCoord + 2.0 * uTexelStep).r) * 0.1201;
+    gl_FragColor = vec4(sum, sum, sum, 1.0);
+}
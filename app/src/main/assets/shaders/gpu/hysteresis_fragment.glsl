@@ -0,0 +1,31 @@
+precision mediump float;
+
+varying vec2 vTexCoord;
+uniform sampler2D uTexture;
+uniform vec2 uTexelSize;
+// 1.0 on the last pass: write the binary edge map instead of the classification
+uniform float uFinalPass;
+
+float classAt(vec2 offset) {
+    return texture2D(uTexture, vTexCoord + offset * uTexelSize).r;
+}
+
+void main() {
+    float center = classAt(vec2(0.0));
+
+    // One hysteresis step: a weak pixel with a strong 8-neighbour becomes strong
+    float strongestNeighbour = max(
+        max(max(classAt(vec2(-1.0, -1.0)), classAt(vec2(0.0, -1.0))),
+            max(classAt(vec2(1.0, -1.0)), classAt(vec2(-1.0, 0.0)))),
+        max(max(classAt(vec2(1.0, 0.0)), classAt(vec2(-1.0, 1.0))),
+            max(classAt(vec2(0.0, 1.0)), classAt(vec2(1.0, 1.0)))));
+
+    float classification = center;
+    if (center > 0.25 && strongestNeighbour > 0.75) {
+        classification = 1.0;
+    }
+
+    float edge = classification > 0.75 ? 1.0 : 0.0;
+    float value = uFinalPass > 0.5 ? edge : classification;
+    gl_FragColor = vec4(value, value, value, 1.0);
+}
@@ -0,0 +1,12 @@
+#extension GL_OES_EGL_image_external : require
+precision mediump float;
+
+varying vec2 vTexCoord;
+uniform samplerExternalOES uTexture;
+
+void main() {
+    // BT.601 luma, matching the Y plane the CPU path reads
+    vec3 rgb = texture2D(uTexture, vTexCoord).rgb;
+    float luma = dot(rgb, vec3(0.299, 0.587, 0.114));
+    gl_FragColor = vec4(luma, luma, luma, 1.0);
+}
@@ -0,0 +1,43 @@
+precision mediump float;
+
+varying vec2 vTexCoord;
+uniform sampler2D uTexture;
+uniform vec2 uTexelSize;
+// Canny thresholds in the Sobel pass's [0, 1] magnitude scale
+uniform float uLowThreshold;
+uniform float uHighThreshold;
+
+float magnitudeAt(vec2 offset) {
+    return texture2D(uTexture, vTexCoord + offset * uTexelSize).r;
+}
+
+void main() {
+    vec4 center = texture2D(uTexture, vTexCoord);
+    float magnitude = center.r;
+    int bin = int(center.g * 3.0 + 0.5);
+
+    vec2 offset;
+    if (bin == 0) {
+        offset = vec2(1.0, 0.0);
+    } else if (bin == 1) {
+        offset = vec2(1.0, 1.0);
+    } else if (bin == 2) {
+        offset = vec2(0.0, 1.0);
+    } else {
+        offset = vec2(1.0, -1.0);
+    }
+
+    // Same ties as cv::Canny: horizontal and vertical keep the earlier of two equal
+    // maxima, diagonals must beat both neighbours
+    float before = magnitudeAt(-offset);
+    float after = magnitudeAt(offset);
+    bool diagonal = bin == 1 || bin == 3;
+    bool isMaximum = magnitude > before && (diagonal ? magnitude > after : magnitude >= after);
+
+    // 1.0 = strong, 0.5 = weak, 0.0 = suppressed
+    float classification = 0.0;
+    if (isMaximum && magnitude > uLowThreshold) {
+        classification = magnitude > uHighThreshold ? 1.0 : 0.5;
+    }
+    gl_FragColor = vec4(classification, 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,12 @@
+attribute vec4 aPosition;
+attribute vec2 aTexCoord;
+
+// Identity for offscreen passes, SurfaceTexture transform for the camera pass
+uniform mat4 uTexMatrix;
+
+varying vec2 vTexCoord;
+
+void main() {
+    gl_Position = aPosition;
+    vTexCoord = (uTexMatrix * vec4(aTexCoord, 0.0, 1.0)).xy;
+}
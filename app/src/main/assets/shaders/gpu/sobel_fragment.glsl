@@ -0,0 +1,41 @@
+precision mediump float;
+
+varying vec2 vTexCoord;
+uniform sampler2D uTexture;
+uniform vec2 uTexelSize;
+
+float luma(vec2 offset) {
+    return texture2D(uTexture, vTexCoord + offset * uTexelSize).r;
+}
+
+void main() {
+    float tl = luma(vec2(-1.0, -1.0));
+    float t  = luma(vec2( 0.0, -1.0));
+    float tr = luma(vec2( 1.0, -1.0));
+    float l  = luma(vec2(-1.0,  0.0));
+    float r  = luma(vec2( 1.0,  0.0));
+    float bl = luma(vec2(-1.0,  1.0));
+    float b  = luma(vec2( 0.0,  1.0));
+    float br = luma(vec2( 1.0,  1.0));
+
+    float gx = (tr + 2.0 * r + br) - (tl + 2.0 * l + bl);
+    float gy = (bl + 2.0 * b + br) - (tl + 2.0 * t + tr);
+
+    // L1 magnitude (max 8) scaled into [0, 1]
+    float magnitude = (abs(gx) + abs(gy)) / 8.0;
+
+    // Direction bin as in cv::Canny: 0 = horizontal, 1/3 = diagonal (same sign),
+    // 2/3 = vertical, 1 = anti-diagonal
+    float ax = abs(gx);
+    float ay = abs(gy);
+    float direction;
+    if (ay < ax * 0.41421356) {
+        direction = 0.0;
+    } else if (ay > ax * 2.41421356) {
+        direction = 2.0 / 3.0;
+    } else {
+        direction = gx * gy > 0.0 ? 1.0 / 3.0 : 1.0;
+    }
+
+    gl_FragColor = vec4(magnitude, direction, 0.0, 1.0);
+}
@@ -0,0 +1,73 @@
+#include "auto_threshold.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace edgevision {
+
+AutoThreshold::AutoThreshold()
+    : sampleCount(0)
+    , lowThreshold(50.0)
+    , highThreshold(150.0)
+    , initialized(false)
+{
+    histogram.fill(0);
+}
+
+void AutoThreshold::accumulateRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, int width) {
+    uint32_t samples = 0;
+    for (int x = 1; x + 1 < width; x += kPixelStep) {
+        // 3x3 Sobel, as in cv::Canny with apertureSize 3
+        const int dx = (above[x + 1] - above[x - 1]) + 2 * (row[x + 1] - row[x - 1]) + (below[x + 1] - below[x - 1]);
+        const int dy = (below[x - 1] + 2 * below[x] + below[x + 1]) - (above[x - 1] + 2 * above[x] + above[x + 1]);
+        const int magnitude = std::abs(dx) + std::abs(dy);
+        ++histogram[std::min(magnitude / kBinWidth, static_cast<int>(histogram.size()) - 1)];
+        ++samples;
+    }
+    sampleCount += samples;
+}
+
+void AutoThreshold::accumulate(const cv::Mat& gray) {
+    for (int y = 1; y + 1 < gray.rows; y += kRowStep) {
+        accumulateRow(gray.ptr<uint8_t>(y - 1), gray.ptr<uint8_t>(y), gray.ptr<uint8_t>(y + 1), gray.cols);
+    }
+}
+
+void AutoThreshold::endFrame() {
+    if (sampleCount == 0) {
+        return;
+    }
+
+    // Median: first bin where the running count reaches half the samples, at its centre
+    const uint32_t half = (sampleCount + 1) / 2;
+    uint32_t running = 0;
+    int bin = 0;
+    for (; bin + 1 < static_cast<int>(histogram.size()); ++bin) {
+        running += histogram[bin];
+        if (running >= half) {
+            break;
+        }
+    }
+    const double median = (bin + 0.5) * kBinWidth;
+
+    const double targetHigh = std::min(kMaxHigh, std::max(kMinHigh, kHighScale * median));
+    const double targetLow = std::max(kMinLow, kLowRatio * targetHigh);
+    if (initialized) {
+        lowThreshold += kSmoothing * (targetLow - lowThreshold);
+        highThreshold += kSmoothing * (targetHigh - highThreshold);
+    } else {
+        lowThreshold = targetLow;
+        highThreshold = targetHigh;
+        initialized = true;
+    }
+
+    histogram.fill(0);
+    sampleCount = 0;
+}
+
+void AutoThreshold::reset() {
+    histogram.fill(0);
+    sampleCount = 0;
+    initialized = false;
+}
+
+} // namespace edgevision
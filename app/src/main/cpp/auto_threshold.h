@@ -0,0 +1,78 @@
+#ifndef EDGEVISION_AUTO_THRESHOLD_H
+#define EDGEVISION_AUTO_THRESHOLD_H
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <cstdint>
+
+namespace edgevision {
+
+/**
+ * Canny thresholds that follow the scene instead of fixed 50/150.
+ *
+ * Canny compares L1 gradient magnitudes (|dx| + |dy| of its 3x3 Sobel, 0..2040 for 8-bit
+ * input), so the statistic is taken in the same units: a histogram of that magnitude at
+ * sampled pixels, filled while the frame is copied anyway (accumulateRow on rows that
+ * were just written, so they are still in cache) or from a sparse grid when the frame is
+ * used in place. It is measured before the blur Canny runs after, so it errs high. Flat
+ * and noisy areas dominate the median gradient m, so at endFrame the
+ * high threshold targets kHighScale * m and the low one a third of it, never below the
+ * fixed 50/150: dark or low-contrast frames keep the default sensitivity and only noisy
+ * or busy scenes raise it. The thresholds move towards the targets by kSmoothing per
+ * frame so the output (and the encoded size) does not flicker. Not thread-safe.
+ */
+class AutoThreshold {
+public:
+    static constexpr double kHighScale = 3.0;
+    static constexpr double kLowRatio = 1.0 / 3.0;  // Same ratio as the fixed 50/150
+    static constexpr double kSmoothing = 0.2;       // EMA weight of the newest frame
+    static constexpr double kMinLow = 50.0;
+    static constexpr double kMinHigh = 150.0;
+    static constexpr double kMaxHigh = 2040.0;      // Largest L1 magnitude of 8-bit input
+    static constexpr int kBinWidth = 8;             // Gradient units per histogram bin
+    static constexpr int kRowStep = 2;              // Sample every 2nd row...
+    static constexpr int kPixelStep = 4;            // ...and every 4th pixel in it
+
+    AutoThreshold();
+
+    /**
+     * Whether row y of the frame should be passed to accumulateRow
+     */
+    static bool sampleRow(int y) { return y % kRowStep == 0; }
+
+    /**
+     * Add the gradient at every kPixelStep-th interior pixel of row to the current frame's
+     * histogram; above and below are the neighbouring rows
+     */
+    void accumulateRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, int width);
+
+    /**
+     * Sample a frame that was not copied (kRowStep x kPixelStep grid, no full pass)
+     */
+    void accumulate(const cv::Mat& gray);
+
+    /**
+     * Fold the current histogram into the smoothed thresholds and start a new frame.
+     * Frames without samples leave the thresholds unchanged.
+     */
+    void endFrame();
+
+    /**
+     * Forget the smoothing history (the next frame sets the thresholds directly)
+     */
+    void reset();
+
+    double low() const { return lowThreshold; }
+    double high() const { return highThreshold; }
+
+private:
+    std::array<uint32_t, 256> histogram;
+    uint32_t sampleCount;
+    double lowThreshold;
+    double highThreshold;
+    bool initialized;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_AUTO_THRESHOLD_H
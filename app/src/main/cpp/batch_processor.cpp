@@ -0,0 +1,72 @@
+#include "batch_processor.h"
+#include "metrics.h"
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "BatchProcessor"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+BatchProcessor::BatchProcessor()
+    : workerCount(0)
+{
+}
+
+void BatchProcessor::setWorkerCount(int workers) {
+    workerCount = std::max(0, workers);
+}
+
+void BatchProcessor::process(const std::vector<const uint8_t*>& frames, int rowStride, int width, int height,
+                             int mode, const EdgeProcessor& settings, uint8_t* output) {
+    const int frameCount = static_cast<int>(frames.size());
+    if (frameCount == 0) {
+        return;
+    }
+
+    const int runs = std::min(frameCount, workerCount > 0 ? workerCount : std::max(1, cv::getNumThreads()));
+    while (static_cast<int>(workers.size()) < runs) {
+        workers.push_back(std::make_unique<EdgeProcessor>());
+    }
+
+    const int executionMode = settings.getExecutionMode() == EXECUTION_TILED ? EXECUTION_OPENCV
+                                                                             : settings.getExecutionMode();
+    for (int r = 0; r < runs; ++r) {
+        workers[r]->setCannyThresholds(settings.getCannyThreshold1(), settings.getCannyThreshold2());
+        workers[r]->setExecutionMode(executionMode);
+        workers[r]->setAutoThreshold(settings.isAutoThreshold());
+    }
+
+    const size_t frameBytes = static_cast<size_t>(width) * height;
+    auto processRun = [&](int run) {
+        EdgeProcessor& processor = *workers[run];
+        const int first = frameCount * run / runs;
+        const int last = frameCount * (run + 1) / runs;
+
+        for (int i = first; i < last; ++i) {
+            metrics::ScopedTimer timer(metrics::STAGE_TOTAL);
+            metrics::MetricsRegistry::get().countFrame();
+
+            // No smoothing across frames: a run's history would depend on how the batch was split
+            processor.resetAutoThreshold();
+            cv::Mat gray = processor.wrapPlane(frames[i], width, height, rowStride, 1);
+            cv::Mat dst(height, width, CV_8UC1, output + frameBytes * i);
+            processor.process(gray, dst, mode);
+        }
+    };
+
+    if (runs == 1) {
+        processRun(0);
+    } else {
+        // One stripe per run, so every run maps to exactly one EdgeProcessor
+        cv::parallel_for_(cv::Range(0, runs), [&](const cv::Range& range) {
+            for (int run = range.start; run < range.end; ++run) {
+                processRun(run);
+            }
+        }, runs);
+    }
+
+    LOGD("Batch of %d frames (%dx%d) on %d runs", frameCount, width, height, runs);
+}
+
+} // namespace edgevision
@@ -0,0 +1,46 @@
+#ifndef EDGEVISION_BATCH_PROCESSOR_H
+#define EDGEVISION_BATCH_PROCESSOR_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "edge_processor.h"
+
+namespace edgevision {
+
+/**
+ * Runs a batch of frames (e.g. a recorded clip) in one call, one frame per task.
+ *
+ * The batch is split into contiguous runs scheduled on OpenCV's thread pool; each run
+ * owns an EdgeProcessor so its scratch buffers are reused frame to frame without
+ * sharing. Results land back to back in a caller-owned arena.
+ */
+class BatchProcessor {
+public:
+    BatchProcessor();
+
+    /**
+     * Parallel runs per batch (0 = cv::getNumThreads())
+     */
+    void setWorkerCount(int workers);
+
+    /**
+     * Process frames[i] (width x height Y planes with rowStride) into
+     * output + i * width * height in a ProcessingMode EdgeProcessor::supportsMode accepts.
+     * Thresholds (fixed or automatic) and execution mode are taken from settings;
+     * automatic thresholds are derived from each frame alone, so results do not depend on
+     * the run a frame lands in. Tiled execution runs single-band because the batch already
+     * fills every core.
+     */
+    void process(const std::vector<const uint8_t*>& frames, int rowStride, int width, int height,
+                 int mode, const EdgeProcessor& settings, uint8_t* output);
+
+private:
+    std::vector<std::unique_ptr<EdgeProcessor>> workers;
+    int workerCount;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_BATCH_PROCESSOR_H
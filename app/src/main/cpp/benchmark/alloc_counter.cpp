@@ -0,0 +1,161 @@
+#include "alloc_counter.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+namespace edgevision {
+namespace bench {
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocatedBytes{0};
+
+inline void countAllocation(size_t bytes) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+#if !defined(__GLIBC__)
+// Forwards to OpenCV's default allocator, counting every Mat buffer it hands out
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    explicit CountingMatAllocator(cv::MatAllocator* base)
+        : base(base)
+    {
+    }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        cv::UMatData* u = base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        if (u != nullptr && data == nullptr) {
+            countAllocation(u->size);
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return base->allocate(data, accessFlags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        base->deallocate(data);
+    }
+
+private:
+    cv::MatAllocator* base;
+};
+#endif
+
+} // namespace
+
+AllocationCounts allocationCounts() {
+    AllocationCounts counts;
+    counts.count = g_allocations.load(std::memory_order_relaxed);
+    counts.bytes = g_allocatedBytes.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void installAllocationCounter() {
+#if !defined(__GLIBC__)
+    static CountingMatAllocator allocator(cv::Mat::getStdAllocator());
+    cv::Mat::setDefaultAllocator(&allocator);
+#endif
+}
+
+const char* allocationCounterScope() {
+#if defined(__GLIBC__)
+    return "all malloc-family calls";
+#else
+    return "operator new and cv::Mat buffers";
+#endif
+}
+
+} // namespace bench
+} // namespace edgevision
+
+#if defined(__GLIBC__)
+
+// glibc exports its allocator under __libc_* names, so the public entry points can be
+// replaced here without dlsym (which itself allocates)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    edgevision::bench::countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    edgevision::bench::countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    edgevision::bench::countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    edgevision::bench::countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    edgevision::bench::countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+    edgevision::bench::countAllocation(size);
+    void* memory = __libc_memalign(alignment, size);
+    if (memory == nullptr) {
+        return ENOMEM;
+    }
+    *ptr = memory;
+    return 0;
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+} // extern "C"
+
+#else
+
+// Without a libc hook, count C++ allocations (std::vector growth, etc.) at operator new
+void* operator new(size_t size) {
+    edgevision::bench::countAllocation(size);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef EDGEVISION_ALLOC_COUNTER_H
+#define EDGEVISION_ALLOC_COUNTER_H
+
+#include <cstdint>
+
+namespace edgevision {
+namespace bench {
+
+struct AllocationCounts {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * Allocations made by any thread since process start
+ */
+AllocationCounts allocationCounts();
+
+/**
+ * Start counting. On glibc every malloc-family call is interposed, which also covers
+ * OpenCV's fastMalloc; elsewhere (bionic) operator new and cv::Mat buffers are counted.
+ */
+void installAllocationCounter();
+
+/**
+ * Human-readable description of what installAllocationCounter() can see
+ */
+const char* allocationCounterScope();
+
+} // namespace bench
+} // namespace edgevision
+
+#endif // EDGEVISION_ALLOC_COUNTER_H
@@ -0,0 +1,463 @@
+/**
+ * Host / on-device benchmark for EdgeProcessor and the streaming encoders.
+ *
+ * Replays field recordings (FrameRecorder .evr containers), raw I420 frames or synthetic
+ * moving scenes at several resolutions and
+ * reports throughput, per-frame latency percentiles and heap allocations per frame.
+ * Run with --help for options.
+ */
+
+#include "alloc_counter.h"
+#include "../edge_processor.h"
+#include "../frame_encoder.h"
+#include "../frame_recording.h"
+#include "../metrics.h"
+#include "../output_pyramid.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+using edgevision::EdgeProcessor;
+using Clock = std::chrono::steady_clock;
+
+struct Resolution {
+    std::string name;
+    int width;
+    int height;
+};
+
+struct Options {
+    std::vector<Resolution> resolutions;
+    std::vector<std::string> cases;
+    std::string inputPath;
+    int inputWidth = 0;
+    int inputHeight = 0;
+    int frames = 300;
+    int warmup = 30;
+    int threads = 0;
+    bool csv = false;
+    bool stages = false;
+    bool arena = true;
+};
+
+// Camera planes usually pad rows; replaying with a stride keeps wrapPlane honest
+constexpr int kRowAlignment = 64;
+constexpr int kSyntheticFrames = 16;
+constexpr int kMaxRecordedFrames = 120;
+
+const char* const kAllCases[] = {
+    "gray", "canny", "canny-tiled", "canny-fused", "canny-opencl", "sobel", "laplacian", "threshold",
+    "encode-raw", "encode-bitpack", "encode-rle", "encode-delta", "encode-contours", "pyramid"
+};
+
+/**
+ * Y planes stored with a padded row stride, replayed cyclically
+ */
+struct FrameSet {
+    int width = 0;
+    int height = 0;
+    int rowStride = 0;
+    std::vector<std::vector<uint8_t>> planes;
+
+    const uint8_t* plane(int index) const { return planes[index % planes.size()].data(); }
+};
+
+void printUsage(const char* program) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --resolutions LIST  Comma-separated 480p,720p,1080p,1440p,4k or WxH (default: 480p,720p,1080p,4k)\n"
+        "  --cases LIST        Comma-separated cases (default: all):\n"
+        "                      gray canny canny-tiled canny-fused canny-opencl sobel laplacian threshold\n"
+        "                      encode-raw encode-bitpack encode-rle encode-delta encode-contours\n"
+        "                      pyramid (1/2 and 1/4 output levels of an edge map)\n"
+        "  --input FILE        Replay FILE instead of synthetic scenes: a NativeProcessor.recordingStart\n"
+        "                      container (.evr), or raw I420 frames with --size\n"
+        "  --size WxH          Frame size of a raw I420 --input\n"
+        "  --frames N          Timed frames per case (default: 300)\n"
+        "  --warmup N          Untimed frames per case (default: 30)\n"
+        "  --threads N         Worker threads for canny-tiled (default: one per CPU)\n"
+        "  --stages            Also print the native per-stage histograms (MetricsRegistry)\n"
+        "  --no-arena          Give OpenCV's per-call scratch Mats to the heap instead of the FrameArena\n"
+        "  --csv               Machine-readable output\n",
+        program);
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        const size_t end = std::min(list.find(',', start), list.size());
+        if (end > start) {
+            items.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return items;
+}
+
+bool parseSize(const std::string& text, int& width, int& height) {
+    return std::sscanf(text.c_str(), "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+}
+
+bool parseResolution(const std::string& text, Resolution& resolution) {
+    static const Resolution kNamed[] = {
+        {"480p", 640, 480}, {"720p", 1280, 720}, {"1080p", 1920, 1080},
+        {"1440p", 2560, 1440}, {"4k", 3840, 2160}
+    };
+    for (const Resolution& named : kNamed) {
+        if (text == named.name) {
+            resolution = named;
+            return true;
+        }
+    }
+    resolution.name = text;
+    return parseSize(text, resolution.width, resolution.height);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else if (arg == "--no-arena") {
+            options.arena = false;
+        } else if (arg == "--stages") {
+            options.stages = true;
+        } else if (arg == "--resolutions" && hasValue) {
+            options.resolutions.clear();
+            for (const std::string& item : splitList(argv[++i])) {
+                Resolution resolution;
+                if (!parseResolution(item, resolution)) {
+                    std::fprintf(stderr, "Invalid resolution: %s\n", item.c_str());
+                    return false;
+                }
+                options.resolutions.push_back(resolution);
+            }
+        } else if (arg == "--cases" && hasValue) {
+            options.cases = splitList(argv[++i]);
+        } else if (arg == "--input" && hasValue) {
+            options.inputPath = argv[++i];
+        } else if (arg == "--size" && hasValue) {
+            if (!parseSize(argv[++i], options.inputWidth, options.inputHeight)) {
+                std::fprintf(stderr, "Invalid --size: %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::max(0, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Unknown or incomplete option: %s\n", arg.c_str());
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    if (options.resolutions.empty()) {
+        for (const char* name : {"480p", "720p", "1080p", "4k"}) {
+            Resolution resolution;
+            parseResolution(name, resolution);
+            options.resolutions.push_back(resolution);
+        }
+    }
+    if (options.cases.empty()) {
+        options.cases.assign(std::begin(kAllCases), std::end(kAllCases));
+    }
+    for (const std::string& name : options.cases) {
+        if (std::find(std::begin(kAllCases), std::end(kAllCases), name) == std::end(kAllCases)) {
+            std::fprintf(stderr, "Unknown case: %s\n", name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Luma planes of a recording: a FrameRecorder container (size from its header), else a
+ * raw I420 file (Y, then U and V at quarter size, per frame) of --size
+ */
+std::vector<cv::Mat> loadRecording(const Options& options) {
+    std::vector<cv::Mat> frames;
+    edgevision::FrameReplay replay;
+    if (replay.open(options.inputPath)) {
+        cv::Mat frame;
+        int64_t timestampNs = 0;
+        while (static_cast<int>(frames.size()) < kMaxRecordedFrames && replay.next(frame, timestampNs)) {
+            frames.push_back(frame.clone());
+        }
+        return frames;
+    }
+
+    if (options.inputWidth == 0) {
+        std::fprintf(stderr, "%s is not a recording container; raw I420 input needs --size WxH\n",
+                     options.inputPath.c_str());
+        return frames;
+    }
+    std::ifstream file(options.inputPath, std::ios::binary);
+    if (!file) {
+        std::fprintf(stderr, "Cannot open %s\n", options.inputPath.c_str());
+        return frames;
+    }
+
+    const size_t lumaBytes = static_cast<size_t>(options.inputWidth) * options.inputHeight;
+    const size_t chromaBytes = 2 * (static_cast<size_t>((options.inputWidth + 1) / 2) * ((options.inputHeight + 1) / 2));
+    while (static_cast<int>(frames.size()) < kMaxRecordedFrames) {
+        cv::Mat luma(options.inputHeight, options.inputWidth, CV_8UC1);
+        if (!file.read(reinterpret_cast<char*>(luma.data), static_cast<std::streamsize>(lumaBytes))) {
+            break;
+        }
+        file.ignore(static_cast<std::streamsize>(chromaBytes));
+        frames.push_back(luma);
+    }
+    return frames;
+}
+
+/**
+ * Deterministic scene with moving shapes and sensor-like noise, so edges change per frame
+ */
+std::vector<cv::Mat> syntheticFrames(int width, int height) {
+    std::vector<cv::Mat> frames;
+    cv::RNG rng(0x45564631);
+    const int size = std::min(width, height);
+
+    for (int i = 0; i < kSyntheticFrames; ++i) {
+        cv::Mat frame(height, width, CV_8UC1);
+        for (int y = 0; y < height; ++y) {
+            std::memset(frame.ptr<uint8_t>(y), 40 + (160 * y) / height, width);
+        }
+
+        const double phase = static_cast<double>(i) / kSyntheticFrames;
+        for (int shape = 0; shape < 12; ++shape) {
+            const int x = static_cast<int>((0.1 + 0.07 * shape + 0.2 * phase) * width) % width;
+            const int y = static_cast<int>((0.15 + 0.06 * shape) * height) % height;
+            const int radius = size / 20 + shape * size / 120;
+            if (shape % 2 == 0) {
+                cv::circle(frame, cv::Point(x, y), radius, cv::Scalar(230 - shape * 10), -1);
+            } else {
+                cv::rectangle(frame, cv::Rect(x, y, radius * 2, radius), cv::Scalar(20 + shape * 8), -1);
+            }
+        }
+
+        // Signed noise, added with saturation back into 8 bits
+        cv::Mat noise(height, width, CV_16SC1);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(6));
+        cv::add(frame, noise, frame, cv::noArray(), CV_8UC1);
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+FrameSet makeFrameSet(const std::vector<cv::Mat>& sources, const Resolution& resolution) {
+    FrameSet set;
+    set.width = resolution.width;
+    set.height = resolution.height;
+    set.rowStride = (resolution.width + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+
+    cv::Mat resized;
+    for (const cv::Mat& source : sources) {
+        const cv::Mat* frame = &source;
+        if (source.cols != set.width || source.rows != set.height) {
+            cv::resize(source, resized, cv::Size(set.width, set.height), 0, 0, cv::INTER_AREA);
+            frame = &resized;
+        }
+
+        std::vector<uint8_t> plane(static_cast<size_t>(set.rowStride) * set.height, 0);
+        for (int y = 0; y < set.height; ++y) {
+            std::memcpy(plane.data() + static_cast<size_t>(y) * set.rowStride, frame->ptr<uint8_t>(y), set.width);
+        }
+        set.planes.push_back(std::move(plane));
+    }
+    return set;
+}
+
+struct Result {
+    std::vector<double> latenciesMs;
+    double elapsedMs = 0.0;
+    edgevision::bench::AllocationCounts allocations;
+};
+
+/**
+ * Time one case; step(i) processes frame i
+ */
+Result runCase(const Options& options, const std::function<void(int)>& step) {
+    for (int i = 0; i < options.warmup; ++i) {
+        step(i);
+    }
+
+    Result result;
+    result.latenciesMs.resize(options.frames);
+    edgevision::metrics::MetricsRegistry::get().reset();
+
+    const edgevision::bench::AllocationCounts before = edgevision::bench::allocationCounts();
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < options.frames; ++i) {
+        const Clock::time_point frameStart = Clock::now();
+        step(options.warmup + i);
+        result.latenciesMs[i] = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+    }
+    result.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    const edgevision::bench::AllocationCounts after = edgevision::bench::allocationCounts();
+
+    result.allocations.count = after.count - before.count;
+    result.allocations.bytes = after.bytes - before.bytes;
+    return result;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    const size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void report(const Options& options, const std::string& name, const FrameSet& set, Result& result) {
+    std::vector<double>& latencies = result.latenciesMs;
+    std::sort(latencies.begin(), latencies.end());
+
+    double sum = 0.0;
+    for (double latency : latencies) {
+        sum += latency;
+    }
+    const double frames = static_cast<double>(latencies.size());
+    const double fps = frames * 1000.0 / result.elapsedMs;
+    const double megapixels = fps * set.width * set.height / 1e6;
+    const double allocsPerFrame = result.allocations.count / frames;
+    const double kbPerFrame = result.allocations.bytes / frames / 1024.0;
+
+    if (options.csv) {
+        std::printf("%s,%dx%d,%d,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.1f\n",
+                    name.c_str(), set.width, set.height, static_cast<int>(frames), fps, megapixels,
+                    sum / frames, percentile(latencies, 50), percentile(latencies, 95),
+                    percentile(latencies, 99), latencies.back(), allocsPerFrame, kbPerFrame);
+    } else {
+        std::printf("%-15s %5dx%-5d %8.1f %8.1f %8.3f %8.3f %8.3f %8.3f %8.3f %9.2f %9.1f\n",
+                    name.c_str(), set.width, set.height, fps, megapixels,
+                    sum / frames, percentile(latencies, 50), percentile(latencies, 95),
+                    percentile(latencies, 99), latencies.back(), allocsPerFrame, kbPerFrame);
+    }
+
+    if (options.stages) {
+        std::printf("  stages: %s\n", edgevision::metrics::MetricsRegistry::get().toJson().c_str());
+    }
+}
+
+uint8_t encodingFor(const std::string& name) {
+    using namespace edgevision::protocol;
+    if (name == "encode-bitpack") {
+        return ENCODING_BITPACK;
+    }
+    if (name == "encode-rle") {
+        return ENCODING_BITPACK_RLE;
+    }
+    if (name == "encode-delta") {
+        return ENCODING_TILE_DELTA;
+    }
+    if (name == "encode-contours") {
+        return ENCODING_CONTOURS;
+    }
+    return ENCODING_RAW;
+}
+
+void benchmarkResolution(const Options& options, const std::vector<cv::Mat>& sources, const Resolution& resolution) {
+    const FrameSet set = makeFrameSet(sources, resolution);
+
+    for (const std::string& name : options.cases) {
+        EdgeProcessor processor;
+        processor.setThreadCount(options.threads);
+        processor.setArenaEnabled(options.arena);
+        cv::Mat output(set.height, set.width, CV_8UC1);
+        auto wrap = [&](int i) {
+            return processor.wrapPlane(set.plane(i), set.width, set.height, set.rowStride, 1);
+        };
+
+        Result result;
+        if (name == "gray") {
+            result = runCase(options, [&](int i) { processor.processGrayscale(wrap(i), output); });
+        } else if (name.compare(0, 5, "canny") == 0) {
+            processor.setExecutionMode(name == "canny-tiled" ? edgevision::EXECUTION_TILED
+                                       : name == "canny-fused" ? edgevision::EXECUTION_FUSED
+                                       : name == "canny-opencl" ? edgevision::EXECUTION_OPENCL
+                                                                : edgevision::EXECUTION_OPENCV);
+            result = runCase(options, [&](int i) { processor.processCanny(wrap(i), output); });
+        } else if (name == "sobel" || name == "laplacian" || name == "threshold") {
+            const int mode = name == "sobel" ? edgevision::MODE_SOBEL
+                           : name == "laplacian" ? edgevision::MODE_LAPLACIAN
+                                                 : edgevision::MODE_THRESHOLD;
+            result = runCase(options, [&](int i) { processor.process(wrap(i), output, mode); });
+        } else {
+            // Encoders see real edge maps, produced up front so only encoding is timed
+            std::vector<cv::Mat> edges;
+            for (size_t i = 0; i < set.planes.size(); ++i) {
+                edges.push_back(processor.processCanny(wrap(static_cast<int>(i))).clone());
+            }
+
+            if (name == "pyramid") {
+                edgevision::OutputPyramid pyramid;
+                result = runCase(options, [&](int i) {
+                    pyramid.setFrame(edges[i % edges.size()], i, true);
+                    pyramid.level(edgevision::OutputPyramid::kLevels - 1);
+                });
+            } else {
+                edgevision::protocol::FrameEncoder encoder;
+                edgevision::protocol::FrameHeader header;
+                header.encoding = encodingFor(name);
+                std::vector<uint8_t> packet(edgevision::protocol::maxFrameSize(set.width, set.height, header.encoding));
+                result = runCase(options, [&](int i) {
+                    encoder.encode(edges[i % edges.size()], header, packet.data(), packet.size());
+                });
+            }
+        }
+        report(options, name, set, result);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    edgevision::bench::installAllocationCounter();
+
+    std::vector<cv::Mat> recording;
+    if (!options.inputPath.empty()) {
+        recording = loadRecording(options);
+        if (recording.empty()) {
+            std::fprintf(stderr, "No frames in %s\n", options.inputPath.c_str());
+            return 1;
+        }
+    }
+
+    if (options.csv) {
+        std::printf("case,resolution,frames,fps,mpix_per_s,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,allocs_per_frame,kb_per_frame\n");
+    } else {
+        std::printf("EdgeVision benchmark: %s, %d frames (+%d warm-up), allocations counted for %s\n",
+                    recording.empty() ? "synthetic scenes" : options.inputPath.c_str(),
+                    options.frames, options.warmup, edgevision::bench::allocationCounterScope());
+        std::printf("%-15s %11s %8s %8s %8s %8s %8s %8s %8s %9s %9s\n",
+                    "case", "resolution", "fps", "MP/s", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms",
+                    "allocs/f", "KB/f");
+    }
+
+    for (const Resolution& resolution : options.resolutions) {
+        const std::vector<cv::Mat> sources = recording.empty()
+                ? syntheticFrames(resolution.width, resolution.height) : recording;
+        benchmarkResolution(options, sources, resolution);
+    }
+    return 0;
+}
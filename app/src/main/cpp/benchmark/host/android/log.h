@@ -0,0 +1,35 @@
+#ifndef EDGEVISION_HOST_ANDROID_LOG_H
+#define EDGEVISION_HOST_ANDROID_LOG_H
+
+// Minimal stand-in for <android/log.h> so the native sources build for the host
+// benchmark. Warnings and errors go to stderr, everything else is dropped.
+
+#include <cstdarg>
+#include <cstdio>
+
+enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT
+};
+
+inline int __android_log_print(int priority, const char* tag, const char* format, ...) {
+    if (priority < ANDROID_LOG_WARN) {
+        return 0;
+    }
+    std::fprintf(stderr, "%s: ", tag);
+    va_list args;
+    va_start(args, format);
+    const int written = std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    return written;
+}
+
+#endif // EDGEVISION_HOST_ANDROID_LOG_H
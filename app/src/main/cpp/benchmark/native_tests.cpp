@@ -0,0 +1,218 @@
+/**
+ * Host regression tests for the native processing code, built alongside the benchmark:
+ *   cmake --build build-bench && ctest --test-dir build-bench --output-on-failure
+ * Each check prints one line; the exit status is the number of failures.
+ */
+
+#include "auto_threshold.h"
+#include "edge_processor.h"
+#include "frame_encoder.h"
+#include "yuv_convert.h"
+
+#include <opencv2/core.hpp>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool passed, const std::string& name) {
+    std::printf("%s %s\n", passed ? "PASS" : "FAIL", name.c_str());
+    if (!passed) {
+        ++g_failures;
+    }
+}
+
+cv::Mat noiseFrame(int width, int height, uint64_t seed) {
+    cv::Mat frame(height, width, CV_8UC1);
+    cv::RNG rng(seed);
+    rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+    return frame;
+}
+
+bool equalMats(const cv::Mat& a, const cv::Mat& b) {
+    return a.size() == b.size() && a.type() == b.type() && cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+/**
+ * A frame processed after a larger one must match a cold run: the stage scratch is sized
+ * for the large frame, and nothing left in it may leak into the small frame's borders.
+ */
+void testSmallFrameAfterLarge() {
+    const int modes[] = {edgevision::MODE_CANNY, edgevision::MODE_SOBEL, edgevision::MODE_LAPLACIAN,
+                         edgevision::MODE_THRESHOLD};
+    const char* names[] = {"canny", "sobel", "laplacian", "threshold"};
+    const cv::Mat large = noiseFrame(640, 480, 1);
+    const cv::Mat small = noiseFrame(160, 120, 2);
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+        edgevision::EdgeProcessor warm;
+        warm.process(large, modes[i]);
+        const cv::Mat warmResult = warm.process(small, modes[i]).clone();
+
+        edgevision::EdgeProcessor cold;
+        const cv::Mat coldResult = cold.process(small, modes[i]).clone();
+
+        check(equalMats(warmResult, coldResult), std::string("small frame after large, ") + names[i]);
+    }
+}
+
+/**
+ * length bytes that end exactly at an inaccessible page, so any read past the end faults
+ */
+class GuardedBuffer {
+public:
+    explicit GuardedBuffer(size_t length) {
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        mappedBytes = (length + page - 1) / page * page + page;
+        void* mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            return;
+        }
+        base = static_cast<uint8_t*>(mapped);
+        mprotect(base + mappedBytes - page, page, PROT_NONE);
+        bytes = base + mappedBytes - page - length;
+    }
+
+    ~GuardedBuffer() {
+        if (base != nullptr) {
+            munmap(base, mappedBytes);
+        }
+    }
+
+    GuardedBuffer(const GuardedBuffer&) = delete;
+    GuardedBuffer& operator=(const GuardedBuffer&) = delete;
+
+    uint8_t* data() const { return bytes; }
+
+private:
+    uint8_t* base = nullptr;
+    uint8_t* bytes = nullptr;
+    size_t mappedBytes = 0;
+};
+
+/**
+ * The last row of a plane needs (width-1)*pixelStride + 1 bytes: an exactly-sized buffer
+ * is accepted and read without touching the byte after it, one byte less is rejected.
+ */
+void testPlaneCapacity() {
+    struct Layout {
+        int width;
+        int height;
+        int rowStride;
+        int pixelStride;
+    };
+    const Layout layouts[] = {{37, 5, 40, 1}, {37, 5, 80, 2}, {37, 5, 74, 2}, {21, 4, 64, 3}};
+
+    for (const Layout& layout : layouts) {
+        const std::string name = std::to_string(layout.width) + "x" + std::to_string(layout.height) +
+                ", rowStride " + std::to_string(layout.rowStride) +
+                ", pixelStride " + std::to_string(layout.pixelStride);
+        const size_t lastSample = static_cast<size_t>(layout.rowStride) * (layout.height - 1) +
+                static_cast<size_t>(layout.width - 1) * layout.pixelStride;
+        const size_t required = edgevision::minimumPlaneBytes(layout.width, layout.height,
+                                                              layout.rowStride, layout.pixelStride);
+        check(required == lastSample + 1 &&
+              edgevision::planeFits(required, layout.width, layout.height, layout.rowStride, layout.pixelStride),
+              "exactly-sized plane accepted, " + name);
+        check(!edgevision::planeFits(required - 1, layout.width, layout.height, layout.rowStride,
+                                     layout.pixelStride),
+              "plane 1 byte short rejected, " + name);
+
+        GuardedBuffer buffer(required);
+        if (buffer.data() == nullptr) {
+            check(false, "guarded plane mapped, " + name);
+            continue;
+        }
+        for (size_t i = 0; i < required; ++i) {
+            buffer.data()[i] = static_cast<uint8_t>(i * 7 + 3);
+        }
+
+        edgevision::EdgeProcessor processor;
+        const cv::Mat gray = processor.wrapPlane(buffer.data(), layout.width, layout.height,
+                                                 layout.rowStride, layout.pixelStride);
+        bool matches = gray.rows == layout.height && gray.cols == layout.width;
+        for (int y = 0; matches && y < layout.height; ++y) {
+            for (int x = 0; x < layout.width; ++x) {
+                const size_t offset = static_cast<size_t>(y) * layout.rowStride +
+                        static_cast<size_t>(x) * layout.pixelStride;
+                if (gray.at<uint8_t>(y, x) != buffer.data()[offset]) {
+                    matches = false;
+                    break;
+                }
+            }
+        }
+        check(matches, "exactly-sized plane gathered, " + name);
+    }
+
+    check(edgevision::minimumPlaneBytes(37, 5, 73, 2) == 0, "rowStride below width*pixelStride rejected");
+    check(edgevision::minimumPlaneBytes(0, 5, 40, 1) == 0, "empty plane rejected");
+}
+
+/**
+ * Automatic thresholds stay at the 50/150 defaults on dark and flat frames and only rise
+ * where the gradient statistics call for it
+ */
+void testAutoThresholdFloor() {
+    cv::Mat dark(240, 320, CV_8UC1);
+    cv::RNG rng(3);
+    rng.fill(dark, cv::RNG::UNIFORM, 0, 12);
+    edgevision::AutoThreshold darkThreshold;
+    darkThreshold.accumulate(dark);
+    darkThreshold.endFrame();
+    check(darkThreshold.low() >= edgevision::AutoThreshold::kMinLow &&
+          darkThreshold.high() >= edgevision::AutoThreshold::kMinHigh, "dark frame keeps default thresholds");
+
+    edgevision::AutoThreshold noisyThreshold;
+    noisyThreshold.accumulate(noiseFrame(320, 240, 4));
+    noisyThreshold.endFrame();
+    check(noisyThreshold.high() > edgevision::AutoThreshold::kMinHigh &&
+          noisyThreshold.high() <= edgevision::AutoThreshold::kMaxHigh &&
+          noisyThreshold.low() < noisyThreshold.high(), "noisy frame raises thresholds");
+}
+
+/**
+ * Contours never cost more than the bit-packed frame: a frame too busy for them is sent
+ * bit-packed, complete, instead of with polylines missing
+ */
+void testContourFallback() {
+    namespace protocol = edgevision::protocol;
+    const int width = 320;
+    const int height = 240;
+    // Separate 3x3 blobs: each is a 4-point polyline (20 bytes) for 2 bytes of raster
+    cv::Mat edges(height, width, CV_8UC1, cv::Scalar(0));
+    for (int y = 0; y + 3 <= height; y += 4) {
+        for (int x = 0; x + 3 <= width; x += 4) {
+            edges(cv::Rect(x, y, 3, 3)).setTo(cv::Scalar(255));
+        }
+    }
+
+    std::vector<uint8_t> packet(protocol::maxFrameSize(width, height, protocol::ENCODING_CONTOURS));
+    protocol::FrameHeader header;
+    header.encoding = protocol::ENCODING_CONTOURS;
+    protocol::FrameEncoder encoder;
+    const size_t written = encoder.encode(edges, header, packet.data(), packet.size());
+    check(written == protocol::kHeaderSize + edgevision::codec::packedRowBytes(width) * height &&
+          packet[7] == protocol::ENCODING_BITPACK, "busy contour frame falls back to bitpack");
+
+    cv::Mat sparse(height, width, CV_8UC1, cv::Scalar(0));
+    cv::rectangle(sparse, cv::Rect(40, 40, 100, 80), cv::Scalar(255));
+    const size_t sparseWritten = encoder.encode(sparse, header, packet.data(), packet.size());
+    check(sparseWritten > protocol::kHeaderSize && packet[7] == protocol::ENCODING_CONTOURS,
+          "sparse frame stays contours");
+}
+
+} // namespace
+
+int main() {
+    testSmallFrameAfterLarge();
+    testPlaneCapacity();
+    testAutoThresholdFloor();
+    testContourFallback();
+    return g_failures;
+}
@@ -0,0 +1,79 @@
+#include "bitmap_writer.h"
+#include "metrics.h"
+#include <android/bitmap.h>
+#include <android/log.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define LOG_TAG "BitmapWriter"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+void grayToRgba(const cv::Mat& gray, cv::Mat& rgba) {
+    metrics::ScopedTimer timer(metrics::STAGE_COPY_OUT);
+
+    for (int row = 0; row < gray.rows; ++row) {
+        const uint8_t* in = gray.ptr<uint8_t>(row);
+        uint8_t* out = rgba.ptr<uint8_t>(row);
+
+        int x = 0;
+#if defined(__ARM_NEON)
+        const uint8x16_t opaque = vdupq_n_u8(255);
+        for (; x + 16 <= gray.cols; x += 16) {
+            const uint8x16_t value = vld1q_u8(in + x);
+            uint8x16x4_t pixels;
+            pixels.val[0] = value;
+            pixels.val[1] = value;
+            pixels.val[2] = value;
+            pixels.val[3] = opaque;
+            vst4q_u8(out + x * 4, pixels);
+        }
+#endif
+        for (; x < gray.cols; ++x) {
+            out[x * 4 + 0] = in[x];
+            out[x * 4 + 1] = in[x];
+            out[x * 4 + 2] = in[x];
+            out[x * 4 + 3] = 255;
+        }
+    }
+}
+
+BitmapLock::BitmapLock(JNIEnv* jniEnv, jobject target, int width, int height)
+    : env(jniEnv)
+    , bitmap(target)
+{
+    AndroidBitmapInfo info;
+    if (bitmap == nullptr || AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("Not a valid Bitmap");
+        return;
+    }
+
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("Bitmap must be ARGB_8888, format is %d", info.format);
+        return;
+    }
+    if (static_cast<int>(info.width) != width || static_cast<int>(info.height) != height) {
+        LOGE("Bitmap is %ux%u, frame is %dx%d", info.width, info.height, width, height);
+        return;
+    }
+
+    void* address = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &address) != ANDROID_BITMAP_RESULT_SUCCESS || address == nullptr) {
+        LOGE("Failed to lock Bitmap pixels");
+        return;
+    }
+
+    mat = cv::Mat(height, width, CV_8UC4, address, info.stride);
+}
+
+BitmapLock::~BitmapLock() {
+    if (isLocked()) {
+        AndroidBitmap_unlockPixels(env, bitmap);
+    }
+}
+
+} // namespace edgevision
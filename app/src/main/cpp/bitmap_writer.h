@@ -0,0 +1,39 @@
+#ifndef EDGEVISION_BITMAP_WRITER_H
+#define EDGEVISION_BITMAP_WRITER_H
+
+#include <jni.h>
+#include <opencv2/opencv.hpp>
+
+namespace edgevision {
+
+/**
+ * Expand an 8-bit gray Mat into opaque RGBA of the same size (NEON where available)
+ */
+void grayToRgba(const cv::Mat& gray, cv::Mat& rgba);
+
+/**
+ * Locks the pixels of an ARGB_8888 android.graphics.Bitmap for its lifetime and exposes
+ * them as a CV_8UC4 Mat (RGBA byte order, the bitmap's own row stride), so results are
+ * written straight into the caller's Bitmap. The bitmap must be exactly width x height.
+ */
+class BitmapLock {
+public:
+    BitmapLock(JNIEnv* env, jobject bitmap, int width, int height);
+    ~BitmapLock();
+
+    BitmapLock(const BitmapLock&) = delete;
+    BitmapLock& operator=(const BitmapLock&) = delete;
+
+    bool isLocked() const { return !mat.empty(); }
+
+    cv::Mat& pixels() { return mat; }
+
+private:
+    JNIEnv* env;
+    jobject bitmap;
+    cv::Mat mat;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_BITMAP_WRITER_H
@@ -0,0 +1,198 @@
+#include "canny_kernels.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#define LOG_TAG "CannyKernels"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+namespace canny {
+
+namespace {
+
+// tan(22.5 deg) in Q15, as used by cv::Canny for direction binning
+constexpr int kTan22Q15 = 13573;
+
+// Halo rows: 2 for the 5x5 blur feeding Sobel of the neighbour rows, 1 for Sobel, 1 for NMS
+constexpr int kBlurHalo = 2;
+constexpr int kMagnitudeHalo = 1;
+
+} // namespace
+
+void suppressRow(const int* magPrev, const int* magCur, const int* magNext,
+                 const int16_t* dx, const int16_t* dy, int width,
+                 int lowThreshold, int highThreshold, uint8_t* classRow) {
+    for (int x = 0; x < width; ++x) {
+        const int m = magCur[x];
+        if (m <= lowThreshold) {
+            classRow[x] = EDGE_NONE;
+            continue;
+        }
+
+        const int xs = dx[x];
+        const int ys = dy[x];
+        const int ax = std::abs(xs);
+        const int ay = std::abs(ys) << 15;
+        const int tg22x = ax * kTan22Q15;
+
+        bool isMaximum;
+        if (ay < tg22x) {
+            // Mostly horizontal gradient: compare left/right
+            const int left = x > 0 ? magCur[x - 1] : 0;
+            const int right = x + 1 < width ? magCur[x + 1] : 0;
+            isMaximum = m > left && m >= right;
+        } else if (ay > tg22x + (ax << 16)) {
+            // Mostly vertical gradient: compare up/down
+            isMaximum = m > magPrev[x] && m >= magNext[x];
+        } else {
+            // Diagonal: neighbours along the gradient depend on the sign of dx*dy
+            const int s = (xs ^ ys) < 0 ? -1 : 1;
+            const int xPrev = x - s;
+            const int xNext = x + s;
+            const int prev = (xPrev >= 0 && xPrev < width) ? magPrev[xPrev] : 0;
+            const int next = (xNext >= 0 && xNext < width) ? magNext[xNext] : 0;
+            isMaximum = m > prev && m > next;
+        }
+
+        if (!isMaximum) {
+            classRow[x] = EDGE_NONE;
+        } else {
+            classRow[x] = m > highThreshold ? EDGE_STRONG : EDGE_WEAK;
+        }
+    }
+}
+
+void hysteresis(cv::Mat& classMap, cv::Mat& edges, std::vector<int>& stack) {
+    // classMap carries a one-pixel EDGE_NONE border, so neighbours never need bounds checks
+    const int rows = classMap.rows - 2;
+    const int cols = classMap.cols - 2;
+    const int step = static_cast<int>(classMap.step);
+    uint8_t* base = classMap.data;
+    const int offsets[8] = {-step - 1, -step, -step + 1, -1, 1, step - 1, step, step + 1};
+
+    stack.clear();
+    for (int y = 1; y <= rows; ++y) {
+        const uint8_t* row = classMap.ptr<uint8_t>(y);
+        for (int x = 1; x <= cols; ++x) {
+            if (row[x] == EDGE_STRONG) {
+                stack.push_back(y * step + x);
+            }
+        }
+    }
+
+    while (!stack.empty()) {
+        const int index = stack.back();
+        stack.pop_back();
+        for (int offset : offsets) {
+            uint8_t& neighbour = base[index + offset];
+            if (neighbour == EDGE_WEAK) {
+                neighbour = EDGE_STRONG;
+                stack.push_back(index + offset);
+            }
+        }
+    }
+
+    edges.create(rows, cols, CV_8UC1);
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t* classRow = classMap.ptr<uint8_t>(y + 1) + 1;
+        uint8_t* out = edges.ptr<uint8_t>(y);
+        for (int x = 0; x < cols; ++x) {
+            // EDGE_STRONG (2) -> 0xFF, EDGE_WEAK/EDGE_NONE -> 0, branch-free so it vectorizes
+            out[x] = static_cast<uint8_t>(-(classRow[x] >> 1));
+        }
+    }
+}
+
+} // namespace canny
+
+TiledCanny::TiledCanny()
+    : threadCount(0)
+{
+}
+
+void TiledCanny::setThreadCount(int threads) {
+    threadCount = std::max(0, threads);
+    LOGD("Tiled Canny thread count: %d", threadCount);
+}
+
+void TiledCanny::run(const cv::Mat& gray, cv::Mat& edges, double lowThreshold, double highThreshold) {
+    const int width = gray.cols;
+    const int height = gray.rows;
+
+    int bandCount = threadCount > 0 ? threadCount : cv::getNumberOfCPUs();
+    // Bands thinner than the halo would mostly recompute their neighbours
+    bandCount = std::max(1, std::min(bandCount, height / (4 * canny::kBlurHalo)));
+
+    if (classMap.rows != height + 2 || classMap.cols != width + 2) {
+        classMap.create(height + 2, width + 2, CV_8UC1);
+        classMap.setTo(cv::Scalar(canny::EDGE_NONE));
+        zeroRow.assign(width, 0);
+    }
+    if (static_cast<int>(scratch.size()) < bandCount) {
+        scratch.resize(bandCount);
+    }
+
+    // Integer thresholds, matching cv::Canny's L1 path (which swaps a reversed pair)
+    if (lowThreshold > highThreshold) {
+        std::swap(lowThreshold, highThreshold);
+    }
+    const int low = static_cast<int>(std::floor(lowThreshold));
+    const int high = static_cast<int>(std::floor(highThreshold));
+
+    if (bandCount == 1) {
+        processBand(gray, 0, 1, low, high);
+    } else {
+        cv::parallel_for_(cv::Range(0, bandCount), [&](const cv::Range& range) {
+            for (int band = range.start; band < range.end; ++band) {
+                processBand(gray, band, bandCount, low, high);
+            }
+        }, bandCount);
+    }
+
+    canny::hysteresis(classMap, edges, stack);
+}
+
+void TiledCanny::processBand(const cv::Mat& gray, int band, int bandCount, int low, int high) {
+    const int width = gray.cols;
+    const int height = gray.rows;
+
+    // Rows owned by this band, plus the halo each earlier stage needs
+    const int y0 = height * band / bandCount;
+    const int y1 = height * (band + 1) / bandCount;
+    const int blur0 = std::max(0, y0 - canny::kBlurHalo);
+    const int blur1 = std::min(height, y1 + canny::kBlurHalo);
+    const int mag0 = std::max(0, y0 - canny::kMagnitudeHalo);
+    const int mag1 = std::min(height, y1 + canny::kMagnitudeHalo);
+
+    BandScratch& s = scratch[band];
+
+    // Blurring a row range of the full frame reads real pixels beyond the range,
+    // so the band's blur is identical to the full-frame result
+    cv::GaussianBlur(gray.rowRange(blur0, blur1), s.blurred, cv::Size(5, 5), 1.5);
+    cv::Sobel(s.blurred, s.dx, CV_16S, 1, 0, 3, 1, 0, cv::BORDER_REPLICATE);
+    cv::Sobel(s.blurred, s.dy, CV_16S, 0, 1, 3, 1, 0, cv::BORDER_REPLICATE);
+
+    s.magnitude.create(mag1 - mag0, width, CV_32SC1);
+    for (int y = mag0; y < mag1; ++y) {
+        const int16_t* dxRow = s.dx.ptr<int16_t>(y - blur0);
+        const int16_t* dyRow = s.dy.ptr<int16_t>(y - blur0);
+        int* magRow = s.magnitude.ptr<int>(y - mag0);
+        for (int x = 0; x < width; ++x) {
+            magRow[x] = std::abs(dxRow[x]) + std::abs(dyRow[x]);
+        }
+    }
+
+    for (int y = y0; y < y1; ++y) {
+        const int* magPrev = y > 0 ? s.magnitude.ptr<int>(y - 1 - mag0) : zeroRow.data();
+        const int* magNext = y + 1 < height ? s.magnitude.ptr<int>(y + 1 - mag0) : zeroRow.data();
+        canny::suppressRow(magPrev, s.magnitude.ptr<int>(y - mag0), magNext,
+                           s.dx.ptr<int16_t>(y - blur0), s.dy.ptr<int16_t>(y - blur0),
+                           width, low, high, classMap.ptr<uint8_t>(y + 1) + 1);
+    }
+}
+
+} // namespace edgevision
@@ -0,0 +1,73 @@
+#ifndef EDGEVISION_CANNY_KERNELS_H
+#define EDGEVISION_CANNY_KERNELS_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace edgevision {
+namespace canny {
+
+// Per-pixel classification produced by non-maximum suppression
+enum : uint8_t {
+    EDGE_NONE = 0,
+    EDGE_WEAK = 1,
+    EDGE_STRONG = 2
+};
+
+/**
+ * Non-maximum suppression for one row using L1 magnitudes (same rule as cv::Canny).
+ * magPrev/magNext may point at a zero row at the image border.
+ */
+void suppressRow(const int* magPrev, const int* magCur, const int* magNext,
+                 const int16_t* dx, const int16_t* dy, int width,
+                 int lowThreshold, int highThreshold, uint8_t* classRow);
+
+/**
+ * Hysteresis over a whole classification map: strong pixels grow through 8-connected
+ * weak pixels. Writes 0/255 into edges; stack is reusable scratch.
+ */
+void hysteresis(cv::Mat& classMap, cv::Mat& edges, std::vector<int>& stack);
+
+} // namespace canny
+
+/**
+ * Canny split into horizontal bands with halo rows. Blur, Sobel and NMS run per band
+ * on OpenCV's thread pool; hysteresis runs once over the stitched map so edges that
+ * cross band boundaries are traced exactly as in a full-frame pass.
+ */
+class TiledCanny {
+public:
+    TiledCanny();
+
+    /**
+     * Number of bands/threads (0 = one per CPU)
+     */
+    void setThreadCount(int threads);
+    int getThreadCount() const { return threadCount; }
+
+    /**
+     * 5x5 Gaussian (sigma 1.5) followed by Canny with a 3x3 Sobel aperture
+     */
+    void run(const cv::Mat& gray, cv::Mat& edges, double lowThreshold, double highThreshold);
+
+private:
+    struct BandScratch {
+        cv::Mat blurred;
+        cv::Mat dx;
+        cv::Mat dy;
+        cv::Mat magnitude;
+    };
+
+    void processBand(const cv::Mat& gray, int band, int bandCount, int low, int high);
+
+    int threadCount;
+    cv::Mat classMap;
+    std::vector<int> zeroRow;
+    std::vector<BandScratch> scratch;
+    std::vector<int> stack;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_CANNY_KERNELS_H
@@ -0,0 +1,98 @@
+#include "contour_codec.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "ContourCodec"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+namespace codec {
+
+namespace {
+
+constexpr size_t kPayloadHeaderSize = 4;
+constexpr size_t kPolylineHeaderSize = 4;
+constexpr size_t kPointSize = 4;
+
+inline void putU16(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline void putU32(uint8_t* out, uint32_t value) {
+    putU16(out, value);
+    putU16(out + 2, value >> 16);
+}
+
+} // namespace
+
+size_t ContourEncoder::encode(const cv::Mat& edges, uint8_t* out, size_t capacity) {
+    if (capacity < kPayloadHeaderSize) {
+        return 0;
+    }
+
+    // CHAIN_APPROX_SIMPLE already collapses straight runs, so approxPolyDP sees fewer points
+    cv::findContours(edges, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    size_t offset = kPayloadHeaderSize;
+    uint32_t written = 0;
+    for (const std::vector<cv::Point>& contour : contours) {
+        const double length = cv::arcLength(contour, true);
+        if (length < kMinLength) {
+            continue;
+        }
+
+        cv::approxPolyDP(contour, polyline, kEpsilon, true);
+        // A there-and-back trace of an open edge encloses (almost) nothing
+        const bool closed = std::abs(cv::contourArea(polyline)) > 0.5 * length;
+        const size_t count = polyline.size();
+        if (count <= UINT16_MAX) {
+            if (!putPolyline(0, count, closed, out, capacity, offset)) {
+                return tooLarge(capacity);
+            }
+            ++written;
+            continue;
+        }
+
+        // Too long for one count: open pieces that overlap by a point, walking back to the
+        // start at the end of a closed outline
+        const size_t total = closed ? count + 1 : count;
+        for (size_t first = 0; first + 1 < total; first += UINT16_MAX - 1) {
+            const size_t points = std::min<size_t>(UINT16_MAX, total - first);
+            if (!putPolyline(first, points, false, out, capacity, offset)) {
+                return tooLarge(capacity);
+            }
+            ++written;
+        }
+    }
+
+    putU32(out, written);
+    return offset;
+}
+
+bool ContourEncoder::putPolyline(size_t first, size_t points, bool closed, uint8_t* out, size_t capacity,
+                                 size_t& offset) const {
+    if (offset + kPolylineHeaderSize + points * kPointSize > capacity) {
+        return false;
+    }
+
+    putU16(out + offset, static_cast<uint32_t>(points));
+    putU16(out + offset + 2, closed ? FLAG_CLOSED : 0);
+    offset += kPolylineHeaderSize;
+    for (size_t i = first; i < first + points; ++i) {
+        const cv::Point& point = polyline[i % polyline.size()];
+        putU16(out + offset, static_cast<uint32_t>(point.x));
+        putU16(out + offset + 2, static_cast<uint32_t>(point.y));
+        offset += kPointSize;
+    }
+    return true;
+}
+
+size_t ContourEncoder::tooLarge(size_t capacity) {
+    LOGD("Polylines exceed %zu bytes", capacity);
+    return 0;
+}
+
+} // namespace codec
+} // namespace edgevision
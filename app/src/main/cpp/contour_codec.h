@@ -0,0 +1,64 @@
+#ifndef EDGEVISION_CONTOUR_CODEC_H
+#define EDGEVISION_CONTOUR_CODEC_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "edge_codec.h"
+
+namespace edgevision {
+namespace codec {
+
+/**
+ * Vector output for binary edge maps: cv::findContours traces the edges, approxPolyDP
+ * reduces each trace to a polyline within kEpsilon pixels, and traces shorter than
+ * kMinLength (isolated noise pixels) are dropped. A typical 1080p edge map becomes a few
+ * tens of KB instead of width * height bytes, and clients draw it as canvas paths.
+ *
+ * Payload layout (little-endian):
+ *   0  uint32  polyline count
+ *   4  polylines: uint16 point count, uint16 flags (FLAG_CLOSED),
+ *                 then point count x (uint16 x, uint16 y)
+ *
+ * findContours follows both sides of a one-pixel line, so an open edge comes out as a
+ * polyline that runs to its end and back; such traces enclose no area and are not flagged
+ * closed. A polyline of more than UINT16_MAX points is split into open pieces that share
+ * their end points (a closed one repeats its first point at the end). A busy frame whose
+ * polylines would not all fit yields nothing rather than a partial drawing: FrameEncoder
+ * then sends it bit-packed.
+ */
+class ContourEncoder {
+public:
+    static constexpr double kEpsilon = 1.0;
+    static constexpr double kMinLength = 6.0;
+    static constexpr uint16_t FLAG_CLOSED = 0x01;
+
+    /**
+     * Payload budget: never more than the bit-packed frame it replaces (and falls back to)
+     */
+    static size_t maxPayloadSize(int width, int height) {
+        return packedRowBytes(width) * height;
+    }
+
+    /**
+     * Encode a binary CV_8UC1 edge map; returns bytes written, or 0 if every polyline
+     * does not fit capacity
+     */
+    size_t encode(const cv::Mat& edges, uint8_t* out, size_t capacity);
+
+private:
+    // points entries of polyline from first on (wrapping to its start) at out + offset
+    bool putPolyline(size_t first, size_t points, bool closed, uint8_t* out, size_t capacity,
+                     size_t& offset) const;
+    static size_t tooLarge(size_t capacity);
+
+    // Reused across frames; findContours and approxPolyDP refill them
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Point> polyline;
+};
+
+} // namespace codec
+} // namespace edgevision
+
+#endif // EDGEVISION_CONTOUR_CODEC_H
@@ -0,0 +1,100 @@
+#include "cpu_topology.h"
+#include <android/log.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#define LOG_TAG "CpuTopology"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+long readMaxFrequency(int cpu) {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return -1;
+    }
+
+    long frequency = -1;
+    if (fscanf(file, "%ld", &frequency) != 1) {
+        frequency = -1;
+    }
+    fclose(file);
+    return frequency;
+}
+
+} // namespace
+
+const CpuTopology& CpuTopology::get() {
+    static const CpuTopology topology;
+    return topology;
+}
+
+CpuTopology::CpuTopology() {
+    const long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+
+    std::vector<std::pair<int, long>> frequencies;
+    long maxFrequency = 0;
+    for (int cpu = 0; cpu < cpuCount; ++cpu) {
+        const long frequency = readMaxFrequency(cpu);
+        frequencies.emplace_back(cpu, frequency);
+        if (frequency > maxFrequency) {
+            maxFrequency = frequency;
+        }
+    }
+
+    // Anything clocked well below the fastest cluster counts as a little core
+    for (const auto& entry : frequencies) {
+        if (maxFrequency <= 0 || entry.second < 0 || entry.second * 10 >= maxFrequency * 8) {
+            big.push_back(entry.first);
+        } else {
+            little.push_back(entry.first);
+        }
+    }
+
+    LOGD("Detected %zu big and %zu little cores", big.size(), little.size());
+}
+
+bool CpuTopology::pinCurrentThread(const std::vector<int>& cores) {
+    if (cores.empty()) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : cores) {
+        CPU_SET(core, &set);
+    }
+
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        LOGE("sched_setaffinity failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool CpuTopology::saveCurrentThread(cpu_set_t& mask) {
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+        LOGE("sched_getaffinity failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void CpuTopology::restoreCurrentThread(const cpu_set_t& mask) {
+    if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+        LOGE("sched_setaffinity failed: %s", strerror(errno));
+    }
+}
+
+} // namespace edgevision
@@ -0,0 +1,44 @@
+#ifndef EDGEVISION_CPU_TOPOLOGY_H
+#define EDGEVISION_CPU_TOPOLOGY_H
+
+#include <sched.h>
+#include <vector>
+
+namespace edgevision {
+
+/**
+ * big.LITTLE core classification read from cpufreq limits in sysfs
+ */
+class CpuTopology {
+public:
+    /**
+     * Probe /sys/devices/system/cpu once; homogeneous SoCs report every core as big
+     */
+    static const CpuTopology& get();
+
+    const std::vector<int>& bigCores() const { return big; }
+    const std::vector<int>& littleCores() const { return little; }
+    int coreCount() const { return static_cast<int>(big.size() + little.size()); }
+
+    /**
+     * Restrict the calling thread to the given cores (no-op for an empty set)
+     */
+    static bool pinCurrentThread(const std::vector<int>& cores);
+
+    /**
+     * Read the calling thread's affinity mask, for restoreCurrentThread
+     */
+    static bool saveCurrentThread(cpu_set_t& mask);
+
+    static void restoreCurrentThread(const cpu_set_t& mask);
+
+private:
+    CpuTopology();
+
+    std::vector<int> big;
+    std::vector<int> little;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_CPU_TOPOLOGY_H
@@ -0,0 +1,111 @@
+#include "edge_codec.h"
+#include <android/log.h>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define LOG_TAG "EdgeCodec"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+namespace codec {
+
+namespace {
+
+constexpr size_t kMaxLiteral = 128;
+constexpr size_t kMinRun = 3;
+constexpr size_t kMaxRun = 130;
+
+void packRow(const uint8_t* src, uint8_t* dst, int width) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    // 64 pixels -> 8 bytes: mask each lane to its bit weight, then a pairwise-add tree
+    // sums (= ORs) every group of 8 lanes into one byte
+    static const uint8_t kWeights[8] = {128, 64, 32, 16, 8, 4, 2, 1};
+    const uint8x8_t weights = vld1_u8(kWeights);
+    for (; x + 64 <= width; x += 64) {
+        uint8x8_t m[8];
+        for (int i = 0; i < 8; ++i) {
+            const uint8x8_t v = vld1_u8(src + x + i * 8);
+            m[i] = vand_u8(vtst_u8(v, v), weights);
+        }
+        const uint8x8_t p0 = vpadd_u8(m[0], m[1]);
+        const uint8x8_t p1 = vpadd_u8(m[2], m[3]);
+        const uint8x8_t p2 = vpadd_u8(m[4], m[5]);
+        const uint8x8_t p3 = vpadd_u8(m[6], m[7]);
+        const uint8x8_t q0 = vpadd_u8(p0, p1);
+        const uint8x8_t q1 = vpadd_u8(p2, p3);
+        vst1_u8(dst + x / 8, vpadd_u8(q0, q1));
+    }
+#endif
+    for (; x + 8 <= width; x += 8) {
+        const uint8_t* p = src + x;
+        dst[x / 8] = static_cast<uint8_t>(
+                (p[0] ? 0x80 : 0) | (p[1] ? 0x40 : 0) | (p[2] ? 0x20 : 0) | (p[3] ? 0x10 : 0) |
+                (p[4] ? 0x08 : 0) | (p[5] ? 0x04 : 0) | (p[6] ? 0x02 : 0) | (p[7] ? 0x01 : 0));
+    }
+    if (x < width) {
+        uint8_t last = 0;
+        for (int bit = 0; x < width; ++x, ++bit) {
+            last |= src[x] ? static_cast<uint8_t>(0x80 >> bit) : 0;
+        }
+        dst[width / 8] = last;
+    }
+}
+
+} // namespace
+
+size_t bitPack(const cv::Mat& edges, uint8_t* out) {
+    const size_t rowBytes = packedRowBytes(edges.cols);
+    for (int y = 0; y < edges.rows; ++y) {
+        packRow(edges.ptr<uint8_t>(y), out + y * rowBytes, edges.cols);
+    }
+    return rowBytes * edges.rows;
+}
+
+size_t runLengthEncode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < length) {
+        size_t run = 1;
+        while (i + run < length && run < kMaxRun && in[i + run] == in[i]) {
+            ++run;
+        }
+
+        if (run >= kMinRun) {
+            if (o + 2 > capacity) {
+                return 0;
+            }
+            out[o++] = static_cast<uint8_t>(128 + run - kMinRun);
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+
+        // Literals until the next run worth encoding starts
+        const size_t start = i;
+        while (i < length && i - start < kMaxLiteral) {
+            if (i + 2 < length && in[i] == in[i + 1] && in[i] == in[i + 2]) {
+                break;
+            }
+            ++i;
+        }
+
+        const size_t count = i - start;
+        if (o + 1 + count > capacity) {
+            return 0;
+        }
+        out[o++] = static_cast<uint8_t>(count - 1);
+        std::memcpy(out + o, in + start, count);
+        o += count;
+    }
+
+    return o;
+}
+
+} // namespace codec
+} // namespace edgevision
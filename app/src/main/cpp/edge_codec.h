@@ -0,0 +1,41 @@
+#ifndef EDGEVISION_EDGE_CODEC_H
+#define EDGEVISION_EDGE_CODEC_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace edgevision {
+namespace codec {
+
+/**
+ * Bytes per bit-packed row (8 pixels per byte, rows padded to a whole byte)
+ */
+inline size_t packedRowBytes(int width) {
+    return (static_cast<size_t>(width) + 7) / 8;
+}
+
+/**
+ * Worst-case PackBits output for n input bytes (one control byte per 128 literals)
+ */
+inline size_t maxRunLengthBytes(size_t n) {
+    return n + (n + 127) / 128;
+}
+
+/**
+ * Bit-pack a binary CV_8UC1 edge map: any non-zero pixel becomes a 1 bit, MSB first.
+ * out must hold packedRowBytes(width) * height bytes. Returns bytes written.
+ */
+size_t bitPack(const cv::Mat& edges, uint8_t* out);
+
+/**
+ * PackBits run-length encoding: control byte c < 128 copies c + 1 literals,
+ * c >= 128 repeats the next byte c - 125 times (3..130).
+ * Returns bytes written, or 0 if capacity is too small.
+ */
+size_t runLengthEncode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity);
+
+} // namespace codec
+} // namespace edgevision
+
+#endif // EDGEVISION_EDGE_CODEC_H
@@ -1,5 +1,10 @@
 #include "edge_processor.h"
+#include "frame_governor.h"
+#include "metrics.h"
+#include "yuv_convert.h"
 #include <android/log.h>
+#include <algorithm>
+#include <chrono>
 
 #define LOG_TAG "EdgeProcessor"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
@@ -7,10 +12,39 @@
 
 namespace edgevision {
 
+namespace {
+
+// The supported stage combinations; kernel sizes are fixed at compile time per instantiation
+using CannyPipeline = stages::Pipeline<stages::Blur<5>, stages::Canny<3>>;
+using SobelPipeline = stages::Pipeline<stages::Blur<3>, stages::Sobel<3>>;
+using LaplacianPipeline = stages::Pipeline<stages::Blur<3>, stages::Laplacian<3>>;
+using ThresholdPipeline = stages::Pipeline<stages::Blur<5>, stages::Threshold>;
+
+// Pipeline for a filter mode, or nullptr (Canny and grayscale have their own paths)
+stages::PipelineFn filterPipelineFor(int mode) {
+    switch (mode) {
+        case MODE_SOBEL:
+            return &SobelPipeline::run;
+        case MODE_LAPLACIAN:
+            return &LaplacianPipeline::run;
+        case MODE_THRESHOLD:
+            return &ThresholdPipeline::run;
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace
+
 EdgeProcessor::EdgeProcessor()
     : cannyThreshold1(50.0)
     , cannyThreshold2(150.0)
-    , cannyApertureSize(3)
+    , binaryThreshold(128.0)
+    , autoThresholdEnabled(false)
+    , executionMode(EXECUTION_OPENCV)
+    , compactRegionOutput(false)
+    , filterMode(-1)
+    , filterPipeline(nullptr)
     , lastWidth(0)
     , lastHeight(0)
 {
@@ -26,7 +60,167 @@ void EdgeProcessor::setCannyThresholds(double threshold1, double threshold2) {
     cannyThreshold2 = threshold2;
 }
 
-cv::Mat EdgeProcessor::yuv420ToGray(const uint8_t* yuvData, int width, int height) {
+void EdgeProcessor::setAutoThreshold(bool enabled) {
+    if (enabled && !autoThresholdEnabled) {
+        // Start from the current scene rather than from a stale history
+        autoThreshold.reset();
+    }
+    autoThresholdEnabled = enabled;
+    LOGD("Automatic Canny thresholds: %s", enabled ? "on" : "off");
+}
+
+void EdgeProcessor::setExecutionMode(int mode) {
+    if (mode != EXECUTION_OPENCV && mode != EXECUTION_TILED && mode != EXECUTION_FUSED
+            && mode != EXECUTION_OPENCL) {
+        LOGE("Unknown execution mode %d, keeping %d", mode, executionMode);
+        return;
+    }
+    if (mode == EXECUTION_OPENCL && !OpenClCanny::available()) {
+        LOGD("No OpenCL device, EXECUTION_OPENCL runs on the CPU");
+    }
+    executionMode = mode;
+    LOGD("Execution mode: %d", executionMode);
+}
+
+void EdgeProcessor::setThreadCount(int threads) {
+    tiledCanny.setThreadCount(threads);
+}
+
+BackendProbe EdgeProcessor::probeBackends(int width, int height, int cpuMode) {
+    constexpr int kWarmupFrames = 3;
+    constexpr int kTimedFrames = 15;
+    // OpenCL must beat the CPU by this much, so noise does not flip the choice per launch
+    constexpr double kOpenClMargin = 0.9;
+
+    BackendProbe probe;
+    probe.width = width;
+    probe.height = height;
+    probe.cpuMode = cpuMode == EXECUTION_OPENCL ? EXECUTION_OPENCV : cpuMode;
+    probe.openClAvailable = OpenClCanny::available();
+    probe.device = OpenClCanny::deviceName();
+
+    // Noise blurred into blobs gives Canny a realistic amount of edges to trace
+    cv::Mat gray(height, width, CV_8UC1);
+    cv::randn(gray, cv::Scalar(128), cv::Scalar(48));
+    cv::GaussianBlur(gray, gray, cv::Size(9, 9), 3.0);
+    cv::Mat edges(height, width, CV_8UC1);
+
+    metrics::UnrecordedScope unrecorded;
+    EdgeProcessor processor;
+    auto medianUs = [&](int mode) {
+        processor.setExecutionMode(mode);
+        for (int i = 0; i < kWarmupFrames; ++i) {
+            processor.processCanny(gray, edges);
+        }
+        std::vector<double> samples;
+        for (int i = 0; i < kTimedFrames; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            processor.processCanny(gray, edges);
+            samples.push_back(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+        std::nth_element(samples.begin(), samples.begin() + kTimedFrames / 2, samples.end());
+        return samples[kTimedFrames / 2];
+    };
+
+    probe.cpuUs = medianUs(probe.cpuMode);
+    if (probe.openClAvailable) {
+        probe.openClUs = medianUs(EXECUTION_OPENCL);
+    }
+    probe.selectedMode = probe.openClAvailable && probe.openClUs < probe.cpuUs * kOpenClMargin
+            ? EXECUTION_OPENCL : probe.cpuMode;
+
+    LOGD("Backend probe %dx%d: CPU mode %d %.0f us, OpenCL %.0f us (%s) -> mode %d",
+         width, height, probe.cpuMode, probe.cpuUs, probe.openClUs,
+         probe.openClAvailable ? probe.device.c_str() : "unavailable", probe.selectedMode);
+    return probe;
+}
+
+bool EdgeProcessor::prepare(int width, int height, int mode) {
+    if (width <= 0 || height <= 0 || !supportsMode(mode)) {
+        LOGE("Cannot prepare mode %d at %dx%d", mode, width, height);
+        return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    metrics::UnrecordedScope unrecorded;
+
+    grayBuffer.create(height, width, CV_8UC1);
+    edgesBuffer.create(height, width, CV_8UC1);
+    lastWidth = width;
+    lastHeight = height;
+    stageScratch.prepare(width, height);
+    reserveArena(width, height);
+
+    // Dense noise drives Canny's edge tracing to its worst case, so its stacks are grown
+    // here rather than on the first busy camera frame; writing also faults the pages in
+    cv::randu(grayBuffer, cv::Scalar(0), cv::Scalar(256));
+    edgesBuffer.setTo(cv::Scalar(0));
+
+    // OpenCV creates its worker threads on the first parallel region
+    cv::parallel_for_(cv::Range(0, cv::getNumThreads()), [](const cv::Range&) {});
+
+    process(grayBuffer, edgesBuffer, mode);
+    if (mode == MODE_CANNY) {
+        for (int level = 1; level <= FrameGovernor::kMaxPyramidLevel; ++level) {
+            processCanny(grayBuffer, edgesBuffer, level);
+        }
+    }
+
+    LOGD("Prepared mode %d at %dx%d (execution mode %d) in %.1f ms", mode, width, height, executionMode,
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+void EdgeProcessor::setRegions(const std::vector<cv::Rect>& newRegions) {
+    regions.clear();
+    for (const cv::Rect& region : newRegions) {
+        if (region.width > 0 && region.height > 0) {
+            regions.push_back(region);
+        }
+    }
+    LOGD("Regions of interest: %zu", regions.size());
+}
+
+void EdgeProcessor::setCompactRegionOutput(bool compact) {
+    compactRegionOutput = compact;
+}
+
+size_t EdgeProcessor::cannyOutputBytes(int width, int height) const {
+    const size_t frameBytes = static_cast<size_t>(width) * height;
+    if (regions.empty() || !compactRegionOutput) {
+        return frameBytes;
+    }
+
+    size_t total = 0;
+    for (const cv::Rect& region : regions) {
+        total += static_cast<size_t>((region & cv::Rect(0, 0, width, height)).area());
+    }
+    // processRegions falls back to full frame output when the ROIs overlap this much
+    return total <= frameBytes ? total : frameBytes;
+}
+
+cv::Range EdgeProcessor::regionRows(int width, int height) const {
+    if (regions.empty()) {
+        return cv::Range(0, height);
+    }
+
+    // The blur and Canny's Sobel read this many rows past each ROI edge
+    constexpr int kHalo = CannyPipeline::kHalo;
+    int first = height;
+    int last = 0;
+    for (const cv::Rect& region : regions) {
+        const cv::Rect clipped = region & cv::Rect(0, 0, width, height);
+        if (clipped.area() > 0) {
+            first = std::min(first, clipped.y - kHalo);
+            last = std::max(last, clipped.y + clipped.height + kHalo);
+        }
+    }
+    first = std::max(first, 0);
+    last = std::min(last, height);
+    return first < last ? cv::Range(first, last) : cv::Range(0, 0);
+}
+
+cv::Mat EdgeProcessor::yuv420ToGray(const uint8_t* yuvData, int width, int height, bool regionRowsOnly) {
     // YUV_420_888 format: Y plane is already grayscale
     // Reuse buffer if dimensions match
     if (grayBuffer.cols != width || grayBuffer.rows != height) {
@@ -35,20 +229,67 @@ cv::Mat EdgeProcessor::yuv420ToGray(const uint8_t* yuvData, int width, int heigh
         lastHeight = height;
     }
 
-    // Copy Y plane directly
-    memcpy(grayBuffer.data, yuvData, width * height);
+    // Copy Y plane directly, only the rows the ROIs can see
+    metrics::ScopedTimer timer(metrics::STAGE_COPY_IN);
+    const cv::Range rows = regionRowsOnly ? regionRows(width, height) : cv::Range(0, height);
+    if (!autoThresholdEnabled) {
+        const size_t offset = static_cast<size_t>(rows.start) * width;
+        memcpy(grayBuffer.data + offset, yuvData + offset, static_cast<size_t>(rows.size()) * width);
+        return grayBuffer;
+    }
+
+    // Row by row so the gradient sample of row y-1 reads its neighbours while they are in cache
+    for (int y = rows.start; y < rows.end; ++y) {
+        const size_t offset = static_cast<size_t>(y) * width;
+        memcpy(grayBuffer.data + offset, yuvData + offset, width);
+        if (y >= rows.start + 2 && AutoThreshold::sampleRow(y - 1)) {
+            autoThreshold.accumulateRow(grayBuffer.data + offset - 2 * width, grayBuffer.data + offset - width,
+                                        grayBuffer.data + offset, width);
+        }
+    }
+    autoThreshold.endFrame();
     return grayBuffer;
 }
 
-cv::Mat EdgeProcessor::yuv420ToBGR(const uint8_t* yuvData, int width, int height) {
-    // Create Mat from YUV data
-    // YUV_420_888: Y plane (width*height), U plane (width*height/4), V plane (width*height/4)
-    cv::Mat yuvMat(height + height / 2, width, CV_8UC1, (void*)yuvData);
+cv::Mat EdgeProcessor::wrapPlane(const uint8_t* plane, int width, int height, int rowStride, int pixelStride) {
+    if (pixelStride == 1) {
+        // Header only: OpenCV honours the step, so padded rows are skipped for free
+        cv::Mat wrapped(height, width, CV_8UC1, const_cast<uint8_t*>(plane), static_cast<size_t>(rowStride));
+        if (autoThresholdEnabled) {
+            // No copy to piggyback on, so sample a sparse grid instead of a full pass
+            autoThreshold.accumulate(wrapped);
+            autoThreshold.endFrame();
+        }
+        return wrapped;
+    }
+
+    // Interleaved luma is legal in YUV_420_888; gather every pixelStride-th byte
+    if (grayBuffer.cols != width || grayBuffer.rows != height) {
+        grayBuffer.create(height, width, CV_8UC1);
+        lastWidth = width;
+        lastHeight = height;
+    }
+
+    metrics::ScopedTimer timer(metrics::STAGE_COPY_IN);
+    gatherPlane(plane, rowStride, pixelStride, grayBuffer);
+    if (autoThresholdEnabled) {
+        autoThreshold.accumulate(grayBuffer);
+        autoThreshold.endFrame();
+    }
+    return grayBuffer;
+}
 
-    cv::Mat bgrMat;
-    cv::cvtColor(yuvMat, bgrMat, cv::COLOR_YUV2BGR_I420);
+cv::Mat EdgeProcessor::yuv420ToRgba(const uint8_t* yuvData, size_t length, int width, int height) {
+    YuvPlanes planes;
+    if (!packedYuvPlanes(yuvData, length, width, height, planes)) {
+        LOGE("Unrecognized YUV layout: %zu bytes for %dx%d", length, width, height);
+        return cv::Mat();
+    }
 
-    return bgrMat;
+    // Reused across calls like the other buffers; callers copy before the next frame
+    rgbaBuffer.create(height, width, CV_8UC4);
+    yuvToRgba(planes, width, height, rgbaBuffer);
+    return rgbaBuffer;
 }
 
 cv::Mat EdgeProcessor::processGrayscale(const uint8_t* yuvData, int width, int height) {
@@ -57,39 +298,223 @@ cv::Mat EdgeProcessor::processGrayscale(const uint8_t* yuvData, int width, int h
 
 cv::Mat EdgeProcessor::processCanny(const uint8_t* yuvData, int width, int height) {
     // Convert to grayscale first (reuses grayBuffer)
-    cv::Mat grayMat = yuv420ToGray(yuvData, width, height);
+    return processCanny(yuv420ToGray(yuvData, width, height, true));
+}
 
-    // Ensure blur buffer exists with correct dimensions
-    if (blurredBuffer.cols != width || blurredBuffer.rows != height) {
-        blurredBuffer.create(height, width, CV_8UC1);
-    }
+cv::Mat EdgeProcessor::processGrayscale(const cv::Mat& grayMat) {
+    return grayMat;
+}
 
+cv::Mat EdgeProcessor::processCanny(const cv::Mat& grayMat) {
     // Ensure edges buffer exists with correct dimensions
-    if (edgesBuffer.cols != width || edgesBuffer.rows != height) {
-        edgesBuffer.create(height, width, CV_8UC1);
+    if (edgesBuffer.cols != grayMat.cols || edgesBuffer.rows != grayMat.rows) {
+        edgesBuffer.create(grayMat.rows, grayMat.cols, CV_8UC1);
     }
 
-    // Apply Gaussian blur to reduce noise (in-place operation)
-    cv::GaussianBlur(grayMat, blurredBuffer, cv::Size(5, 5), 1.5);
-
-    // Apply Canny edge detection (in-place operation)
-    cv::Canny(blurredBuffer, edgesBuffer, cannyThreshold1, cannyThreshold2, cannyApertureSize);
-
+    if (regions.empty()) {
+        cannyFrame(grayMat, edgesBuffer);
+    } else {
+        processRegions(grayMat, edgesBuffer, false);
+    }
     return edgesBuffer;
 }
 
-std::vector<uint8_t> EdgeProcessor::matToByteArray(const cv::Mat& mat) {
-    std::vector<uint8_t> byteArray;
+void EdgeProcessor::processGrayscale(const cv::Mat& grayMat, cv::Mat& dst) {
+    metrics::ScopedTimer timer(metrics::STAGE_COPY_OUT);
+    grayMat.copyTo(dst);
+}
 
-    if (mat.isContinuous()) {
-        byteArray.assign(mat.data, mat.data + mat.total() * mat.elemSize());
+void EdgeProcessor::processCanny(const cv::Mat& grayMat, cv::Mat& dst) {
+    if (regions.empty()) {
+        cannyFrame(grayMat, dst);
     } else {
-        for (int i = 0; i < mat.rows; ++i) {
-            byteArray.insert(byteArray.end(), mat.ptr<uint8_t>(i), mat.ptr<uint8_t>(i) + mat.cols * mat.elemSize());
+        processRegions(grayMat, dst, compactRegionOutput);
+    }
+}
+
+void EdgeProcessor::cannyFrame(const cv::Mat& grayMat, cv::Mat& dst) {
+    if (executionMode == EXECUTION_TILED) {
+        // Blur is fused into the per-band work, so it is timed as part of Canny
+        metrics::ScopedTimer timer(metrics::STAGE_CANNY);
+        tiledCanny.run(grayMat, dst, lowThreshold(), highThreshold());
+        return;
+    }
+
+    if (executionMode == EXECUTION_FUSED && FusedCanny::supports(grayMat.cols, grayMat.rows)) {
+        metrics::ScopedTimer timer(metrics::STAGE_CANNY);
+        fusedCanny.run(grayMat, dst, lowThreshold(), highThreshold());
+        return;
+    }
+
+    if (executionMode == EXECUTION_OPENCL && OpenClCanny::available()) {
+        // Upload, both kernels and the blocking download; the GPU work cannot be split per stage
+        metrics::ScopedTimer timer(metrics::STAGE_CANNY);
+        openClCanny.run(grayMat, dst, lowThreshold(), highThreshold());
+        return;
+    }
+
+    const int width = grayMat.cols;
+    const int height = grayMat.rows;
+
+    // Intermediates are sized before the arena scope, which would otherwise own them
+    if (stageScratch.buffers[0].cols < width || stageScratch.buffers[0].rows < height) {
+        stageScratch.prepare(width, height);
+        reserveArena(width, height);
+    }
+
+    // OpenCV's own scratch Mats (edge map, gradients) come from the arena from here on
+    FrameArena::Scope arenaScope(arena);
+
+    // dst already has the right size/type so OpenCV writes in place
+    CannyPipeline::run(grayMat, dst, cannyParams(), stageScratch);
+}
+
+void EdgeProcessor::reserveArena(int width, int height) {
+    // cv::Canny's edge map ((w+2) x (h+2)) plus CV_16S dx/dy for the stripe run on this
+    // thread; the arena still grows on its own if OpenCV needs more
+    const size_t pixels = static_cast<size_t>(width + 2) * (height + 2);
+    arena.reserve(pixels * 5);
+}
+
+void EdgeProcessor::cannyRegion(const cv::Mat& grayRegion, cv::Mat& dst) {
+    FrameArena::Scope arenaScope(arena);
+
+    // A ROI header keeps its parent, so the blur reads real pixels past the ROI edge;
+    // intermediates are headers into the shared scratch, so ROIs never reallocate
+    CannyPipeline::run(grayRegion, dst, cannyParams(), stageScratch);
+}
+
+void EdgeProcessor::processRegions(const cv::Mat& grayMat, cv::Mat& dst, bool compact) {
+    const cv::Rect frame(0, 0, grayMat.cols, grayMat.rows);
+
+    int maxWidth = 0;
+    int maxHeight = 0;
+    size_t totalArea = 0;
+    for (const cv::Rect& region : regions) {
+        const cv::Rect clipped = region & frame;
+        maxWidth = std::max(maxWidth, clipped.width);
+        maxHeight = std::max(maxHeight, clipped.height);
+        totalArea += static_cast<size_t>(clipped.area());
+    }
+    if (stageScratch.buffers[0].cols < maxWidth || stageScratch.buffers[0].rows < maxHeight) {
+        stageScratch.prepare(maxWidth, maxHeight);
+        reserveArena(maxWidth, maxHeight);
+    }
+
+    if (compact && (!dst.isContinuous() || totalArea > dst.total())) {
+        LOGE("Compact ROI output needs %zu contiguous bytes, writing the full frame", totalArea);
+        compact = false;
+    }
+
+    if (compact) {
+        uint8_t* out = dst.data;
+        for (const cv::Rect& region : regions) {
+            const cv::Rect clipped = region & frame;
+            if (clipped.area() == 0) {
+                continue;
+            }
+            cv::Mat packed(clipped.height, clipped.width, CV_8UC1, out);
+            cannyRegion(grayMat(clipped), packed);
+            out += clipped.area();
         }
+        return;
+    }
+
+    {
+        metrics::ScopedTimer timer(metrics::STAGE_COPY_OUT);
+        dst.setTo(cv::Scalar(0));
+    }
+    for (const cv::Rect& region : regions) {
+        const cv::Rect clipped = region & frame;
+        if (clipped.area() > 0) {
+            cv::Mat target = dst(clipped);
+            cannyRegion(grayMat(clipped), target);
+        }
+    }
+}
+
+bool EdgeProcessor::supportsMode(int mode) {
+    return mode == MODE_CANNY || mode == MODE_GRAYSCALE || filterPipelineFor(mode) != nullptr;
+}
+
+bool EdgeProcessor::process(const cv::Mat& grayMat, cv::Mat& dst, int mode, int pyramidLevel) {
+    if (mode == MODE_CANNY) {
+        processCanny(grayMat, dst, pyramidLevel);
+        return true;
+    }
+    if (mode == MODE_GRAYSCALE) {
+        processGrayscale(grayMat, dst);
+        return true;
+    }
+
+    if (mode != filterMode) {
+        filterPipeline = filterPipelineFor(mode);
+        filterMode = mode;
+        LOGD("Filter pipeline for mode %d: %s", mode, filterPipeline != nullptr ? "ready" : "none");
+    }
+    if (filterPipeline == nullptr) {
+        LOGE("Unsupported processing mode: %d", mode);
+        return false;
+    }
+
+    if (stageScratch.buffers[0].cols < grayMat.cols || stageScratch.buffers[0].rows < grayMat.rows) {
+        stageScratch.prepare(grayMat.cols, grayMat.rows);
+        reserveArena(grayMat.cols, grayMat.rows);
     }
 
-    return byteArray;
+    FrameArena::Scope arenaScope(arena);
+    const stages::StageParams params{binaryThreshold, cannyThreshold2};
+    filterPipeline(grayMat, dst, params, stageScratch);
+    return true;
+}
+
+cv::Mat EdgeProcessor::process(const cv::Mat& grayMat, int mode) {
+    if (mode == MODE_GRAYSCALE) {
+        return processGrayscale(grayMat);
+    }
+    if (mode == MODE_CANNY) {
+        return processCanny(grayMat);
+    }
+
+    // Sized outside process()'s arena scope so the buffer persists
+    if (edgesBuffer.cols != grayMat.cols || edgesBuffer.rows != grayMat.rows) {
+        edgesBuffer.create(grayMat.rows, grayMat.cols, CV_8UC1);
+    }
+    return process(grayMat, edgesBuffer, mode) ? edgesBuffer : cv::Mat();
+}
+
+void EdgeProcessor::processCanny(const cv::Mat& grayMat, cv::Mat& dst, int pyramidLevel) {
+    // ROIs are already cheap; the governor's frame skipping still applies to them
+    if (pyramidLevel <= 0 || !regions.empty()) {
+        processCanny(grayMat, dst);
+        return;
+    }
+
+    // Ping-pong between two buffers so every level after the first reuses memory; they
+    // are sized up front because anything created inside the arena scope is scratch
+    cv::Size levelSize(grayMat.cols, grayMat.rows);
+    for (int level = 0; level < pyramidLevel; ++level) {
+        levelSize = cv::Size((levelSize.width + 1) / 2, (levelSize.height + 1) / 2);
+        pyramidBuffers[level % 2].create(levelSize.height, levelSize.width, CV_8UC1);
+    }
+
+    const cv::Mat* source = &grayMat;
+    {
+        FrameArena::Scope arenaScope(arena);
+        metrics::ScopedTimer timer(metrics::STAGE_BLUR);
+        for (int level = 0; level < pyramidLevel; ++level) {
+            cv::Mat& reduced = pyramidBuffers[level % 2];
+            cv::pyrDown(*source, reduced);
+            source = &reduced;
+        }
+    }
+
+    scaledEdgesBuffer.create(source->rows, source->cols, CV_8UC1);
+    processCanny(*source, scaledEdgesBuffer);
+
+    FrameArena::Scope arenaScope(arena);
+    metrics::ScopedTimer timer(metrics::STAGE_COPY_OUT);
+    cv::resize(scaledEdgesBuffer, dst, dst.size(), 0, 0, cv::INTER_NEAREST);
 }
 
 } // namespace edgevision
@@ -3,9 +3,44 @@
 
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include "auto_threshold.h"
+#include "canny_kernels.h"
+#include "frame_arena.h"
+#include "neon_canny.h"
+#include "opencl_canny.h"
+#include "stage_pipeline.h"
 
 namespace edgevision {
 
+/**
+ * Canny execution strategy (mirrors NativeProcessor.EXECUTION_MODE_*)
+ */
+enum ExecutionMode : int {
+    EXECUTION_OPENCV = 0,   // cv::GaussianBlur + cv::Canny on the full frame
+    EXECUTION_TILED = 1,    // Horizontal bands on OpenCV's thread pool (TiledCanny)
+    EXECUTION_FUSED = 2,    // Single-pass NEON blur+Sobel+NMS (FusedCanny)
+    EXECUTION_OPENCL = 3    // Blur + Canny on persistent cv::UMat buffers (OpenClCanny)
+};
+
+/**
+ * Per-frame output (mirrors NativeProcessor.PROCESSING_TYPE_*)
+ */
+enum ProcessingMode : int {
+    MODE_CANNY = 0,
+    MODE_GRAYSCALE = 1,
+    MODE_ORIGINAL = 2,      // Colour; handled by yuvToRgba, not process()
+    MODE_SOBEL = 3,         // 3x3 blur + |dx| + |dy| gradient magnitude
+    MODE_LAPLACIAN = 4,     // 3x3 blur + |Laplacian|
+    MODE_THRESHOLD = 5      // 5x5 blur + binary threshold
+};
+
+/**
+ * Whether a mode's output is a binary 0/255 map (so the bit-packed codecs are lossless)
+ */
+inline bool isBinaryMode(int mode) {
+    return mode == MODE_CANNY || mode == MODE_THRESHOLD;
+}
+
 /**
  * OpenCV image processing for edge detection with optimized memory management
  */
@@ -18,16 +53,98 @@ public:
      * Set Canny edge detection thresholds
      */
     void setCannyThresholds(double threshold1, double threshold2);
+    double getCannyThreshold1() const { return cannyThreshold1; }
+    double getCannyThreshold2() const { return cannyThreshold2; }
+
+    /**
+     * Derive the Canny thresholds per frame from the median gradient magnitude (see
+     * AutoThreshold), sampled while yuv420ToGray / wrapPlane bring the frame in; they never
+     * drop below the default 50/150. false = fixed thresholds
+     */
+    void setAutoThreshold(bool enabled);
+    bool isAutoThreshold() const { return autoThresholdEnabled; }
+
+    /**
+     * Drop the automatic thresholds' smoothing history, so the next frame sets them directly
+     */
+    void resetAutoThreshold() { autoThreshold.reset(); }
+
+    /**
+     * Thresholds the next Canny call uses (the smoothed automatic ones when enabled)
+     */
+    double lowThreshold() const { return autoThresholdEnabled ? autoThreshold.low() : cannyThreshold1; }
+    double highThreshold() const { return autoThresholdEnabled ? autoThreshold.high() : cannyThreshold2; }
+
+    /**
+     * Select how processCanny runs (see ExecutionMode)
+     */
+    void setExecutionMode(int mode);
+    int getExecutionMode() const { return executionMode; }
+
+    /**
+     * Time Canny at width x height with cpuMode and, if the device has OpenCL, with
+     * EXECUTION_OPENCL (warm-up frames first, so kernel compilation is not counted), on a
+     * private processor; selectedMode is OpenCL only when clearly faster. Probe frames are
+     * not recorded in the stage histograms.
+     */
+    static BackendProbe probeBackends(int width, int height, int cpuMode);
+
+    /**
+     * Do the first-frame work for width x height in mode ahead of time: size and fault in
+     * the frame buffers and arena, start OpenCV's thread pool and run one dummy frame (for
+     * Canny, also at each governor pyramid level), so OpenCL kernels compile and scratch
+     * reaches its steady-state size. Dummy frames are not recorded in the stage histograms.
+     * Returns false for a bad size or unsupported mode.
+     */
+    bool prepare(int width, int height, int mode);
+
+    /**
+     * Worker thread count for parallel execution modes (0 = one per CPU)
+     */
+    void setThreadCount(int threads);
+
+    /**
+     * Restrict Canny to these rectangles (clipped to each frame); empty = whole frame.
+     * Only the ROIs are blurred and edge-detected, so cost scales with their area.
+     */
+    void setRegions(const std::vector<cv::Rect>& regions);
+    const std::vector<cv::Rect>& getRegions() const { return regions; }
+
+    /**
+     * false: full frame output with everything outside the ROIs zeroed.
+     * true: the ROIs' rows packed back to back, in setRegions order (caller-owned dst only)
+     */
+    void setCompactRegionOutput(bool compact);
+
+    /**
+     * Route OpenCV's per-call scratch Mats through the arena (default) or the heap
+     */
+    void setArenaEnabled(bool enabled) { arena.setEnabled(enabled); }
+    const FrameArena& getArena() const { return arena; }
+
+    /**
+     * Bytes a Canny call writes into a caller-owned dst for a width x height frame
+     */
+    size_t cannyOutputBytes(int width, int height) const;
 
     /**
-     * Convert YUV_420_888 to grayscale Mat
+     * Convert YUV_420_888 to grayscale Mat. With regionRowsOnly only the rows the ROIs
+     * (plus blur halo) cover are copied, the rest of the Mat is stale.
      */
-    cv::Mat yuv420ToGray(const uint8_t* yuvData, int width, int height);
+    cv::Mat yuv420ToGray(const uint8_t* yuvData, int width, int height, bool regionRowsOnly = false);
 
     /**
-     * Convert YUV_420_888 to BGR Mat
+     * Wrap a camera Y plane in a Mat header using its real row stride (no copy).
+     * Planes with pixelStride > 1 are gathered into grayBuffer instead.
      */
-    cv::Mat yuv420ToBGR(const uint8_t* yuvData, int width, int height);
+    cv::Mat wrapPlane(const uint8_t* plane, int width, int height, int rowStride, int pixelStride);
+
+    /**
+     * Convert a packed YUV_420_888 frame (I420 or appended semi-planar planes, see
+     * packedYuvPlanes) to RGBA. Reused buffer, valid until the next call; empty if
+     * length matches neither layout.
+     */
+    cv::Mat yuv420ToRgba(const uint8_t* yuvData, size_t length, int width, int height);
 
     /**
      * Process frame to grayscale (optimized with buffer reuse)
@@ -40,19 +157,95 @@ public:
     cv::Mat processCanny(const uint8_t* yuvData, int width, int height);
 
     /**
-     * Convert Mat to byte array for JNI return
+     * Process an already wrapped grayscale Mat (may be non-continuous)
+     */
+    cv::Mat processGrayscale(const cv::Mat& grayMat);
+
+    /**
+     * Run Canny on an already wrapped grayscale Mat (may be non-continuous)
+     */
+    cv::Mat processCanny(const cv::Mat& grayMat);
+
+    /**
+     * Copy grayscale into a caller-owned Mat header (e.g. a direct ByteBuffer)
+     */
+    void processGrayscale(const cv::Mat& grayMat, cv::Mat& dst);
+
+    /**
+     * Run Canny straight into a caller-owned Mat header (no intermediate copy)
+     */
+    void processCanny(const cv::Mat& grayMat, cv::Mat& dst);
+
+    /**
+     * Run one ProcessingMode (not MODE_ORIGINAL) into a caller-owned Mat header. Canny goes
+     * through processCanny (ROIs, execution modes, pyramid level); the filter modes run a
+     * stage pipeline picked when the mode changes, on the whole frame.
+     * Returns false for an unsupported mode.
      */
-    std::vector<uint8_t> matToByteArray(const cv::Mat& mat);
+    bool process(const cv::Mat& grayMat, cv::Mat& dst, int mode, int pyramidLevel = 0);
+
+    /**
+     * Whether process() handles a mode (every mode with grayscale-sized output)
+     */
+    static bool supportsMode(int mode);
+
+    /**
+     * process() into a reused buffer, valid until the next call; empty for an unsupported mode
+     */
+    cv::Mat process(const cv::Mat& grayMat, int mode);
+
+    /**
+     * Level used by MODE_THRESHOLD (default 128)
+     */
+    void setBinaryThreshold(double level) { binaryThreshold = level; }
+
+    /**
+     * Canny on grayMat reduced pyramidLevel times with cv::pyrDown, edges scaled back up
+     * into dst (nearest neighbour); level 0 is processCanny(grayMat, dst)
+     */
+    void processCanny(const cv::Mat& grayMat, cv::Mat& dst, int pyramidLevel);
 
 private:
+    // Full-frame Canny honouring executionMode
+    void cannyFrame(const cv::Mat& grayMat, cv::Mat& dst);
+
+    // Plain blur + Canny for one ROI; stageScratch is sized to the largest ROI
+    void cannyRegion(const cv::Mat& grayRegion, cv::Mat& dst);
+
+    void processRegions(const cv::Mat& grayMat, cv::Mat& dst, bool compact);
+
+    // Size the arena for a full-frame OpenCV Canny at this resolution
+    void reserveArena(int width, int height);
+
+    // Row span [first, last) that can influence the ROIs, including the blur halo
+    cv::Range regionRows(int width, int height) const;
+
+    stages::StageParams cannyParams() const { return stages::StageParams{lowThreshold(), highThreshold()}; }
+
     double cannyThreshold1;
     double cannyThreshold2;
-    int cannyApertureSize;
+    double binaryThreshold;
+    AutoThreshold autoThreshold;
+    bool autoThresholdEnabled;
+    int executionMode;
+    std::vector<cv::Rect> regions;
+    bool compactRegionOutput;
+    TiledCanny tiledCanny;
+    FusedCanny fusedCanny;
+    OpenClCanny openClCanny;
+
+    // Filter pipeline for filterMode, selected once per mode change rather than per frame
+    int filterMode;
+    stages::PipelineFn filterPipeline;
 
-    // Reusable buffers to minimize allocations
+    // Reusable buffers to minimize allocations; per-call OpenCV scratch uses the arena
+    FrameArena arena;
     cv::Mat grayBuffer;
-    cv::Mat blurredBuffer;
+    cv::Mat rgbaBuffer;
+    stages::StageScratch stageScratch;
     cv::Mat edgesBuffer;
+    cv::Mat pyramidBuffers[2];
+    cv::Mat scaledEdgesBuffer;
     int lastWidth;
     int lastHeight;
 };
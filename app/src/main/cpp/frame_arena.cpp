@@ -0,0 +1,170 @@
+#include "frame_arena.h"
+#include <android/log.h>
+#include <mutex>
+#include <new>
+
+#define LOG_TAG "FrameArena"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+thread_local FrameArena* t_activeArena = nullptr;
+
+// Default allocator from before the router was installed (std, or a benchmark counter)
+cv::MatAllocator* g_fallback = nullptr;
+
+/**
+ * Process-wide default allocator: the calling thread's active arena, else the fallback
+ */
+class ArenaRouter : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        FrameArena* arena = t_activeArena;
+        return arena != nullptr ? arena->allocate(dims, sizes, type, data, step, flags, usageFlags)
+                                : g_fallback->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return g_fallback->allocate(data, accessFlags, usageFlags);
+    }
+
+    // Every UMatData records the allocator that made it, so this only sees fallback blocks
+    void deallocate(cv::UMatData* data) const override {
+        g_fallback->deallocate(data);
+    }
+};
+
+void installRouter() {
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        g_fallback = cv::Mat::getDefaultAllocator();
+        static ArenaRouter router;
+        cv::Mat::setDefaultAllocator(&router);
+    });
+}
+
+size_t alignUp(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+FrameArena::FrameArena()
+    : block(nullptr)
+    , capacityBytes(0)
+    , isEnabled(true)
+    , offset(0)
+    , liveAllocations(0)
+    , cycleBytes(0)
+    , overflows(0)
+{
+    installRouter();
+}
+
+FrameArena::~FrameArena() {
+    if (liveAllocations != 0) {
+        LOGE("Destroyed with %zu live allocations", liveAllocations);
+    }
+    cv::fastFree(block);
+}
+
+FrameArena::Scope::Scope(FrameArena& target)
+    : previous(t_activeArena)
+    , arena(target.isEnabled ? &target : nullptr)
+{
+    if (arena != nullptr) {
+        t_activeArena = arena;
+    }
+}
+
+FrameArena::Scope::~Scope() {
+    t_activeArena = previous;
+    // Nested scopes on the same arena leave the rewind to the outermost one
+    if (arena != nullptr && previous != arena) {
+        arena->rewind();
+    }
+}
+
+void FrameArena::reserve(size_t bytes) {
+    bytes = alignUp(bytes, kAlignment);
+    if (bytes <= capacityBytes) {
+        return;
+    }
+    if (liveAllocations != 0) {
+        LOGE("Cannot grow to %zu bytes with %zu live allocations", bytes, liveAllocations);
+        return;
+    }
+
+    cv::fastFree(block);
+    block = static_cast<uint8_t*>(cv::fastMalloc(bytes));
+    capacityBytes = bytes;
+    offset = 0;
+    LOGD("Capacity %zu bytes", capacityBytes);
+}
+
+void FrameArena::rewind() {
+    if (liveAllocations != 0) {
+        // A scratch Mat escaped its Scope; keep bumping rather than reuse live memory
+        return;
+    }
+
+    if (cycleBytes > capacityBytes) {
+        reserve(cycleBytes + cycleBytes / 4);
+    }
+    offset = 0;
+    cycleBytes = 0;
+}
+
+cv::UMatData* FrameArena::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                   cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+    if (data != nullptr) {
+        // Header over user memory: nothing to carve out
+        return g_fallback->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    // Same packed layout as cv::StdMatAllocator
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+        if (step != nullptr) {
+            step[i] = total;
+        }
+        total *= static_cast<size_t>(sizes[i]);
+    }
+
+    const size_t headerBytes = alignUp(sizeof(cv::UMatData), kAlignment);
+    const size_t needed = headerBytes + alignUp(total, kAlignment);
+    cycleBytes += needed;
+    if (offset + needed > capacityBytes) {
+        ++overflows;
+        return g_fallback->allocate(dims, sizes, type, nullptr, step, flags, usageFlags);
+    }
+
+    uint8_t* base = block + offset;
+    offset += needed;
+    ++liveAllocations;
+
+    auto* u = new (base) cv::UMatData(this);
+    u->data = u->origdata = base + headerBytes;
+    u->size = total;
+    return u;
+}
+
+bool FrameArena::allocate(cv::UMatData* data, cv::AccessFlag /* accessFlags */,
+                          cv::UMatUsageFlags /* usageFlags */) const {
+    return data != nullptr;
+}
+
+void FrameArena::deallocate(cv::UMatData* data) const {
+    if (data == nullptr) {
+        return;
+    }
+    // Memory comes back at the next rewind; only the header needs tearing down
+    data->~UMatData();
+    --liveAllocations;
+}
+
+} // namespace edgevision
@@ -0,0 +1,87 @@
+#ifndef EDGEVISION_FRAME_ARENA_H
+#define EDGEVISION_FRAME_ARENA_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace edgevision {
+
+/**
+ * Bump allocator for the scratch Mats OpenCV creates inside a kernel call (e.g. the
+ * Canny edge map and gradient stripes).
+ *
+ * While a Scope is open, cv::Mat allocations on that thread are carved out of one
+ * preallocated block, UMatData included; the block is rewound when the outermost Scope
+ * closes. Anything that does not fit goes to the previous default allocator and the
+ * block grows to the high-water mark at the next rewind, so steady state allocates
+ * nothing. Mats created inside a Scope must not outlive it (the block is only rewound
+ * once every allocation is released, so an escapee disables reuse rather than
+ * corrupting memory). One arena per processor; not shared between threads.
+ */
+class FrameArena : public cv::MatAllocator {
+public:
+    FrameArena();
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /**
+     * Route the calling thread's cv::Mat allocations into arena until destroyed
+     */
+    class Scope {
+    public:
+        explicit Scope(FrameArena& arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameArena* previous;
+        FrameArena* arena;
+    };
+
+    /**
+     * Grow the block to at least bytes (call at resolution change, outside a Scope)
+     */
+    void reserve(size_t bytes);
+
+    size_t capacity() const { return capacityBytes; }
+
+    /**
+     * Allocations that did not fit and went to the fallback allocator
+     */
+    uint64_t overflowCount() const { return overflows; }
+
+    /**
+     * false routes every Scope straight to the fallback allocator (for comparisons)
+     */
+    void setEnabled(bool enabled) { isEnabled = enabled; }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    static constexpr size_t kAlignment = 64;
+
+    // Rewind once nothing is live, growing first if the last cycle overflowed
+    void rewind();
+
+    uint8_t* block;
+    size_t capacityBytes;
+    bool isEnabled;
+
+    // Mutated from the const cv::MatAllocator interface
+    mutable size_t offset;
+    mutable size_t liveAllocations;
+    mutable size_t cycleBytes;      // Everything requested since the last rewind
+    mutable uint64_t overflows;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_FRAME_ARENA_H
@@ -0,0 +1,178 @@
+#include "frame_encoder.h"
+#include "edge_codec.h"
+#include "video_encoder.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+
+#define LOG_TAG "FrameEncoder"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+namespace protocol {
+
+namespace {
+
+// Explicit byte stores keep the wire format little-endian regardless of the host
+inline void putU32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+inline void putU64(uint8_t* out, uint64_t value) {
+    putU32(out, static_cast<uint32_t>(value));
+    putU32(out + 4, static_cast<uint32_t>(value >> 32));
+}
+
+} // namespace
+
+void writeHeader(const FrameHeader& header, uint8_t* out) {
+    uint32_t fpsBits;
+    std::memcpy(&fpsBits, &header.fps, sizeof(fpsBits));
+
+    putU32(out, kMagic);
+    out[4] = kVersion;
+    out[5] = header.format;
+    out[6] = header.mode;
+    out[7] = header.encoding;
+    putU32(out + 8, header.width);
+    putU32(out + 12, header.height);
+    putU64(out + 16, static_cast<uint64_t>(header.timestampMs));
+    putU32(out + 24, fpsBits);
+    putU32(out + 28, header.payloadLength);
+}
+
+size_t maxFrameSize(int width, int height, uint8_t encoding) {
+    const size_t packedBytes = codec::packedRowBytes(width) * height;
+    switch (encoding) {
+        case ENCODING_BITPACK:
+            return kHeaderSize + packedBytes;
+        case ENCODING_BITPACK_RLE:
+            return kHeaderSize + codec::maxRunLengthBytes(packedBytes);
+        case ENCODING_TILE_DELTA:
+            return kHeaderSize + codec::TileDeltaEncoder::maxPayloadSize(width, height);
+        case ENCODING_H264:
+        case ENCODING_HEVC:
+            return kHeaderSize + codec::VideoEncoder::maxPayloadSize(width, height);
+        case ENCODING_CONTOURS:
+            return kHeaderSize + codec::ContourEncoder::maxPayloadSize(width, height);
+        default:
+            return rawFrameSize(width, height);
+    }
+}
+
+size_t FrameEncoder::encode(const cv::Mat& frame, FrameHeader header, uint8_t* out, size_t capacity, int level) {
+    if (frame.empty() || frame.type() != CV_8UC1) {
+        LOGE("Unsupported frame for encoding (type %d)", frame.empty() ? -1 : frame.type());
+        return 0;
+    }
+    if (level < 0 || level >= OutputPyramid::kLevels) {
+        LOGE("Invalid output level: %d", level);
+        return 0;
+    }
+    if (capacity < kHeaderSize) {
+        LOGE("Encode buffer too small for header: %zu bytes", capacity);
+        return 0;
+    }
+
+    header.format = FORMAT_GRAY8;
+    header.width = static_cast<uint32_t>(frame.cols);
+    header.height = static_cast<uint32_t>(frame.rows);
+
+    uint8_t* payload = out + kHeaderSize;
+    const size_t payloadCapacity = capacity - kHeaderSize;
+    size_t payloadBytes = 0;
+    bool fits = false;
+
+    switch (header.encoding) {
+        case ENCODING_RAW: {
+            const size_t rowBytes = static_cast<size_t>(frame.cols);
+            payloadBytes = rowBytes * frame.rows;
+            fits = payloadCapacity >= payloadBytes;
+            if (!fits) {
+                break;
+            }
+            if (frame.isContinuous()) {
+                std::memcpy(payload, frame.data, payloadBytes);
+            } else {
+                for (int y = 0; y < frame.rows; ++y) {
+                    std::memcpy(payload + y * rowBytes, frame.ptr<uint8_t>(y), rowBytes);
+                }
+            }
+            break;
+        }
+        case ENCODING_BITPACK: {
+            payloadBytes = codec::packedRowBytes(frame.cols) * frame.rows;
+            fits = payloadCapacity >= payloadBytes;
+            if (fits) {
+                codec::bitPack(frame, payload);
+            }
+            break;
+        }
+        case ENCODING_BITPACK_RLE: {
+            packed.resize(codec::packedRowBytes(frame.cols) * frame.rows);
+            const size_t packedBytes = codec::bitPack(frame, packed.data());
+            payloadBytes = codec::runLengthEncode(packed.data(), packedBytes, payload, payloadCapacity);
+            fits = payloadBytes > 0;
+            break;
+        }
+        case ENCODING_TILE_DELTA: {
+            payloadBytes = tileDelta[level].encode(frame, payload, payloadCapacity);
+            fits = payloadBytes > 0;
+            break;
+        }
+        case ENCODING_CONTOURS: {
+            payloadBytes = contours.encode(frame, payload,
+                                           std::min(payloadCapacity, codec::ContourEncoder::maxPayloadSize(frame.cols, frame.rows)));
+            fits = payloadBytes > 0;
+            if (!fits) {
+                // Too busy to beat the raster: send this frame bit-packed (same budget)
+                header.encoding = ENCODING_BITPACK;
+                payloadBytes = codec::packedRowBytes(frame.cols) * frame.rows;
+                fits = payloadCapacity >= payloadBytes;
+                if (fits) {
+                    codec::bitPack(frame, payload);
+                }
+            }
+            break;
+        }
+        default:
+            LOGE("Unknown payload encoding: %d", header.encoding);
+            return 0;
+    }
+
+    if (!fits) {
+        LOGE("Encode buffer too small: %zu bytes for encoding %d", capacity, header.encoding);
+        return 0;
+    }
+
+    header.payloadLength = static_cast<uint32_t>(payloadBytes);
+    writeHeader(header, out);
+    return kHeaderSize + payloadBytes;
+}
+
+size_t FrameEncoder::encodeKeyframe(FrameHeader header, uint8_t* out, size_t capacity, int level) const {
+    if (level < 0 || level >= OutputPyramid::kLevels || capacity < kHeaderSize) {
+        return 0;
+    }
+
+    const codec::TileDeltaEncoder& stream = tileDelta[level];
+    const size_t payloadBytes = stream.encodeReference(out + kHeaderSize, capacity - kHeaderSize);
+    if (payloadBytes == 0) {
+        return 0;
+    }
+
+    header.format = FORMAT_GRAY8;
+    header.encoding = ENCODING_TILE_DELTA;
+    header.width = static_cast<uint32_t>(stream.frameWidth());
+    header.height = static_cast<uint32_t>(stream.frameHeight());
+    header.payloadLength = static_cast<uint32_t>(payloadBytes);
+    writeHeader(header, out);
+    return kHeaderSize + payloadBytes;
+}
+
+} // namespace protocol
+} // namespace edgevision
@@ -0,0 +1,138 @@
+#ifndef EDGEVISION_FRAME_ENCODER_H
+#define EDGEVISION_FRAME_ENCODER_H
+
+#include "contour_codec.h"
+#include "output_pyramid.h"
+#include "tile_delta.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace edgevision {
+namespace protocol {
+
+/**
+ * Binary WebSocket frame layout (all fields little-endian), mirrored by
+ * FrameProtocol.kt and web/src/websocket.ts:
+ *
+ *   0  uint32  magic ("EVF1")
+ *   4  uint8   version
+ *   5  uint8   pixel format
+ *   6  uint8   processing mode (NativeProcessor.PROCESSING_TYPE_*)
+ *   7  uint8   payload encoding
+ *   8  uint32  width
+ *  12  uint32  height
+ *  16  int64   timestamp (ms since epoch)
+ *  24  float32 fps
+ *  28  uint32  payload length
+ *  32  payload
+ */
+constexpr uint32_t kMagic = 0x31465645;  // 'E' 'V' 'F' '1' in memory order
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 32;
+
+enum PixelFormat : uint8_t {
+    FORMAT_GRAY8 = 0
+};
+
+enum PayloadEncoding : uint8_t {
+    ENCODING_RAW = 0,           // One byte per pixel
+    ENCODING_BITPACK = 1,       // Binary edge map, 8 pixels per byte, rows byte-aligned
+    ENCODING_BITPACK_RLE = 2,   // ENCODING_BITPACK followed by PackBits run-length coding
+    ENCODING_TILE_DELTA = 3,    // Bit-packed 32x32 tiles changed since the last delta frame
+    ENCODING_H264 = 4,          // Hardware H.264 access unit (see VideoStreamEncoder)
+    ENCODING_HEVC = 5,          // Hardware HEVC access unit (see VideoStreamEncoder)
+    ENCODING_CONTOURS = 6       // Simplified edge polylines (see ContourEncoder)
+};
+
+inline bool isVideoEncoding(uint8_t encoding) {
+    return encoding == ENCODING_H264 || encoding == ENCODING_HEVC;
+}
+
+struct FrameHeader {
+    uint8_t format = FORMAT_GRAY8;
+    uint8_t mode = 0;
+    uint8_t encoding = ENCODING_RAW;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int64_t timestampMs = 0;
+    float fps = 0.0f;
+    uint32_t payloadLength = 0;
+};
+
+/**
+ * Bytes needed to encode a raw GRAY8 frame
+ */
+inline size_t rawFrameSize(int width, int height) {
+    return kHeaderSize + static_cast<size_t>(width) * height;
+}
+
+/**
+ * Worst-case packet size for a frame in the given encoding
+ */
+size_t maxFrameSize(int width, int height, uint8_t encoding);
+
+/**
+ * Write the fixed header; out must hold kHeaderSize bytes
+ */
+void writeHeader(const FrameHeader& header, uint8_t* out);
+
+/**
+ * Packs processed frames into wire packets (video encodings go through
+ * VideoStreamEncoder instead). The bit-packed encodings are only lossless
+ * for binary (0/255) edge maps, and contours only mean something for them; callers
+ * pick ENCODING_RAW for grayscale output.
+ */
+class FrameEncoder {
+public:
+    /**
+     * Encode a CV_8UC1 frame using header.encoding (strided Mats are packed on the way).
+     * header.width/height/payloadLength are filled from the Mat. level is the
+     * OutputPyramid level the frame came from; each level keeps its own tile-delta stream.
+     * ENCODING_CONTOURS falls back to ENCODING_BITPACK (in the packet header) for frames
+     * whose polylines would not fit the bit-packed size.
+     * Returns the number of bytes written, or 0 on failure.
+     */
+    size_t encode(const cv::Mat& frame, FrameHeader header, uint8_t* out, size_t capacity, int level = 0);
+
+    /**
+     * ENCODING_TILE_DELTA keyframe of the frame the level's stream last encoded, for
+     * clients that lost their reference; the stream itself is not affected. Returns the
+     * packet length, or 0 before the level's first delta frame or if capacity is too small.
+     */
+    size_t encodeKeyframe(FrameHeader header, uint8_t* out, size_t capacity, int level) const;
+
+    /**
+     * Make the next ENCODING_TILE_DELTA frame of every level a keyframe
+     */
+    void requestKeyframe() {
+        for (codec::TileDeltaEncoder& encoder : tileDelta) {
+            encoder.requestKeyframe();
+        }
+    }
+
+    /**
+     * Make the next ENCODING_TILE_DELTA frame of one level a keyframe
+     */
+    void requestKeyframe(int level) {
+        if (level >= 0 && level < OutputPyramid::kLevels) {
+            tileDelta[level].requestKeyframe();
+        }
+    }
+
+private:
+    // Bit-packed frame staged before run-length coding
+    std::vector<uint8_t> packed;
+
+    // Contour scratch; every contour client of a level receives the same payload
+    codec::ContourEncoder contours;
+
+    // Reference frame shared by every tile-delta client of a level (they all receive the same stream)
+    codec::TileDeltaEncoder tileDelta[OutputPyramid::kLevels];
+};
+
+} // namespace protocol
+} // namespace edgevision
+
+#endif // EDGEVISION_FRAME_ENCODER_H
@@ -0,0 +1,126 @@
+#include "frame_governor.h"
+#include <android/log.h>
+#include <cinttypes>
+#include <cstdio>
+
+#define LOG_TAG "FrameGovernor"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+// Weight of the newest sample in the moving average
+constexpr double kSmoothing = 0.2;
+
+// Only step back up if the predicted cost leaves this much of the budget spare
+constexpr double kHeadroom = 0.8;
+
+} // namespace
+
+FrameGovernor::FrameGovernor()
+    : targetUs(0)
+    , averageUs(0.0)
+    , step(0)
+    , minimumStep(0)
+    , framesSinceChange(0)
+    , frameCounter(0)
+    , skippedFrames(0)
+{
+}
+
+void FrameGovernor::setTargetLatencyUs(int64_t newTargetUs) {
+    std::lock_guard<std::mutex> guard(lock);
+    targetUs = newTargetUs > 0 ? newTargetUs : 0;
+    averageUs = 0.0;
+    step = minimumStep;
+    framesSinceChange = 0;
+    LOGD("Target latency: %" PRId64 " us", targetUs);
+}
+
+void FrameGovernor::setMinimumStep(int newMinimumStep) {
+    newMinimumStep = newMinimumStep < 0 ? 0 : (newMinimumStep > kMaxStep ? kMaxStep : newMinimumStep);
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (newMinimumStep == minimumStep) {
+        return;
+    }
+    minimumStep = newMinimumStep;
+
+    // Without a target nothing steps back up on its own, so follow the floor both ways
+    const int nextStep = targetUs == 0 || step < minimumStep ? minimumStep : step;
+    if (nextStep != step) {
+        step = nextStep;
+        averageUs = 0.0;
+        framesSinceChange = 0;
+    }
+    LOGD("Minimum step %d: pyramid level %d, every %d frame(s)", minimumStep, pyramidLevel(), skipInterval());
+}
+
+GovernorDecision FrameGovernor::decide() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (targetUs == 0 && step == 0) {
+        return {true, 0};
+    }
+
+    const int interval = skipInterval();
+    frameCounter = (frameCounter + 1) % interval;
+    if (frameCounter != 0) {
+        ++skippedFrames;
+        return {false, pyramidLevel()};
+    }
+    return {true, pyramidLevel()};
+}
+
+void FrameGovernor::record(int64_t latencyUs) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (targetUs == 0) {
+        return;
+    }
+
+    averageUs = averageUs == 0.0 ? static_cast<double>(latencyUs)
+                                 : averageUs + kSmoothing * (static_cast<double>(latencyUs) - averageUs);
+    if (++framesSinceChange < kSettleFrames) {
+        return;
+    }
+
+    // Skipping spreads one frame's cost over several camera frames
+    const double costUs = averageUs / skipInterval();
+    int nextStep = step;
+    if (costUs > static_cast<double>(targetUs) && step < kMaxStep) {
+        nextStep = step + 1;
+    } else if (step > minimumStep) {
+        // One pyramid level is ~4x the pixels; one skip step is interval/(interval-1) more work
+        const double growth = step <= kMaxPyramidLevel
+                ? 4.0 : static_cast<double>(skipInterval()) / (skipInterval() - 1);
+        if (costUs * growth < static_cast<double>(targetUs) * kHeadroom) {
+            nextStep = step - 1;
+        }
+    }
+
+    if (nextStep != step) {
+        step = nextStep;
+        framesSinceChange = 0;
+        LOGD("Step %d: pyramid level %d, every %d frame(s), average %.0f us",
+             step, pyramidLevel(), skipInterval(), averageUs);
+
+        // Per-frame latency only changes with resolution; re-measure from scratch then
+        if (step <= kMaxPyramidLevel) {
+            averageUs = 0.0;
+        }
+    }
+}
+
+std::string FrameGovernor::toJson() const {
+    std::lock_guard<std::mutex> guard(lock);
+    char buffer[224];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"targetUs\":%" PRId64 ",\"averageUs\":%" PRId64 ",\"pyramidLevel\":%d"
+                  ",\"skipInterval\":%d,\"minimumStep\":%d,\"skipped\":%" PRIu64 "}",
+                  targetUs, static_cast<int64_t>(averageUs), pyramidLevel(), skipInterval(), minimumStep,
+                  skippedFrames);
+    return buffer;
+}
+
+} // namespace edgevision
@@ -0,0 +1,81 @@
+#ifndef EDGEVISION_FRAME_GOVERNOR_H
+#define EDGEVISION_FRAME_GOVERNOR_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace edgevision {
+
+/**
+ * What to do with the next incoming frame
+ */
+struct GovernorDecision {
+    bool process;       // false: skip this frame entirely
+    int pyramidLevel;   // 0 = full resolution, n = Canny on a 1/2^n cv::pyrDown image
+};
+
+/**
+ * Holds a latency target by trading resolution, then frame rate, for time.
+ *
+ * Processing latency is tracked as an exponential moving average. Over budget the
+ * governor steps down one level at a time (half resolution, quarter resolution, then
+ * processing only every 2nd..kMaxSkipInterval-th frame); well under budget it steps back
+ * up. After each change it waits kSettleFrames before judging again, so one slow frame
+ * does not make it oscillate. Thread-safe: decide() and record() may run on different threads.
+ */
+class FrameGovernor {
+public:
+    static constexpr int kMaxPyramidLevel = 2;
+    static constexpr int kMaxSkipInterval = 4;
+    static constexpr int kMaxStep = kMaxPyramidLevel + kMaxSkipInterval - 1;
+
+    FrameGovernor();
+
+    /**
+     * Latency budget per frame in microseconds; 0 disables the governor (full resolution,
+     * every frame)
+     */
+    void setTargetLatencyUs(int64_t targetUs);
+
+    /**
+     * Lowest step the governor may use (0 = full resolution allowed), imposed from outside
+     * the latency loop, e.g. by ThermalScheduler; applies even with no target set
+     */
+    void setMinimumStep(int minimumStep);
+
+    /**
+     * Decision for the next incoming frame
+     */
+    GovernorDecision decide();
+
+    /**
+     * Feed back the measured latency of a frame that was processed
+     */
+    void record(int64_t latencyUs);
+
+    /**
+     * Current target, average and decision as a JSON object
+     */
+    std::string toJson() const;
+
+private:
+    static constexpr int kSettleFrames = 15;
+
+    // step 0..kMaxPyramidLevel lowers resolution, higher steps add frame skipping
+    int pyramidLevel() const { return step < kMaxPyramidLevel ? step : kMaxPyramidLevel; }
+    int skipInterval() const { return step > kMaxPyramidLevel ? step - kMaxPyramidLevel + 1 : 1; }
+
+    mutable std::mutex lock;
+    int64_t targetUs;
+    double averageUs;
+    int step;
+    int minimumStep;
+    int framesSinceChange;
+    int frameCounter;
+    uint64_t skippedFrames;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_FRAME_GOVERNOR_H
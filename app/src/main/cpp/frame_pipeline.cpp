@@ -0,0 +1,396 @@
+#include "frame_pipeline.h"
+#include "cpu_topology.h"
+#include "metrics.h"
+#include "opencl_canny.h"
+#include "yuv_convert.h"
+#include <android/log.h>
+#include <pthread.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define LOG_TAG "FramePipeline"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+// Spin briefly for low hand-off latency, then back off so idle stages do not burn a core
+constexpr int kSpinIterations = 64;
+constexpr auto kIdleSleep = std::chrono::microseconds(200);
+
+void nameCurrentThread(const char* name) {
+    pthread_setname_np(pthread_self(), name);
+}
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Compute stages run on the big cluster unless asked to save power on the little one
+void pinComputeStage(bool efficiencyCores) {
+    const CpuTopology& topology = CpuTopology::get();
+    CpuTopology::pinCurrentThread(efficiencyCores && !topology.littleCores().empty()
+                                  ? topology.littleCores() : topology.bigCores());
+}
+
+} // namespace
+
+FramePipeline::FramePipeline()
+    : running(false)
+    , droppedFrames(0)
+    , cannyThreshold1(50.0)
+    , cannyThreshold2(150.0)
+    , autoThresholdEnabled(false)
+    , efficiencyCores(false)
+    , openClCanny(false)
+    , frameWidth(0)
+    , frameHeight(0)
+    , prepared(false)
+{
+}
+
+FramePipeline::~FramePipeline() {
+    stop();
+}
+
+void FramePipeline::addSink(FrameSink sink) {
+    if (isRunning()) {
+        LOGE("Cannot add sink while pipeline is running");
+        return;
+    }
+    sinks.push_back(std::move(sink));
+}
+
+void FramePipeline::setCannyThresholds(double threshold1, double threshold2) {
+    cannyThreshold1.store(threshold1, std::memory_order_relaxed);
+    cannyThreshold2.store(threshold2, std::memory_order_relaxed);
+}
+
+bool FramePipeline::prepare(int width, int height) {
+    if (isRunning()) {
+        LOGE("Cannot prepare while pipeline is running");
+        return false;
+    }
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid pipeline dimensions: %dx%d", width, height);
+        return false;
+    }
+    const int64_t startUs = nowUs();
+    metrics::UnrecordedScope unrecorded;
+
+    frameWidth = width;
+    frameHeight = height;
+
+    // Allocate every slot up front so the steady state never allocates, and write it
+    // once so its page faults are taken here instead of during the first frames
+    for (auto& slot : slots) {
+        slot.gray.create(height, width, CV_8UC1);
+        slot.blurred.create(height, width, CV_8UC1);
+        slot.edges.create(height, width, CV_8UC1);
+        slot.gray.setTo(cv::Scalar(0));
+        slot.blurred.setTo(cv::Scalar(0));
+        slot.edges.setTo(cv::Scalar(0));
+
+        // Reduced levels at cv::pyrDown's output size, so the stages only reuse them
+        int levelWidth = width;
+        int levelHeight = height;
+        for (int level = 0; level < FrameGovernor::kMaxPyramidLevel; ++level) {
+            levelWidth = (levelWidth + 1) / 2;
+            levelHeight = (levelHeight + 1) / 2;
+            for (cv::Mat* buffer : {&slot.reduced[level], &slot.reducedBlurred[level], &slot.reducedEdges[level]}) {
+                buffer->create(levelHeight, levelWidth, CV_8UC1);
+                buffer->setTo(cv::Scalar(0));
+            }
+        }
+    }
+
+    // Dense noise drives Canny's edge tracing to its worst case; every level the governor
+    // can pick runs once, so the stage code, OpenCV's pool and the kernels are warm
+    FrameSlot& warm = slots[0];
+    cv::randu(warm.gray, cv::Scalar(0), cv::Scalar(256));
+    warm.lowThreshold = cannyThreshold1.load(std::memory_order_relaxed);
+    warm.highThreshold = cannyThreshold2.load(std::memory_order_relaxed);
+    OpenClCanny openCl;
+    for (int level = 0; level <= FrameGovernor::kMaxPyramidLevel; ++level) {
+        warm.pyramidLevel = level;
+        blurSlot(warm);
+        detectSlot(warm, openCl);
+    }
+    warm.gray.setTo(cv::Scalar(0));
+    warm.edges.setTo(cv::Scalar(0));
+    prepared = true;
+
+    LOGD("Pipeline prepared: %dx%d in %.1f ms", width, height, (nowUs() - startUs) / 1000.0);
+    return true;
+}
+
+bool FramePipeline::start(int width, int height) {
+    if (isRunning()) {
+        if (width == frameWidth && height == frameHeight) {
+            return true;
+        }
+        stop();
+    }
+
+    if (!prepared || width != frameWidth || height != frameHeight) {
+        if (!prepare(width, height)) {
+            return false;
+        }
+    }
+
+    freeSlots.reset();
+    toPreprocess.reset();
+    toDetect.reset();
+    toOutput.reset();
+    for (size_t i = 0; i < kSlotCount; ++i) {
+        freeSlots.tryPush(static_cast<int>(i));
+    }
+
+    droppedFrames.store(0, std::memory_order_relaxed);
+    running.store(true, std::memory_order_release);
+
+    workers.emplace_back(&FramePipeline::preprocessLoop, this);
+    workers.emplace_back(&FramePipeline::detectLoop, this);
+    workers.emplace_back(&FramePipeline::outputLoop, this);
+
+    LOGD("Pipeline started: %dx%d, %zu slots", width, height, kSlotCount);
+    return true;
+}
+
+void FramePipeline::stop() {
+    if (!running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+
+    LOGD("Pipeline stopped, dropped %llu frames",
+         static_cast<unsigned long long>(getDroppedFrames()));
+}
+
+bool FramePipeline::submit(const uint8_t* yPlane, int rowStride, int pixelStride, int64_t timestampNs) {
+    if (!isRunning()) {
+        return false;
+    }
+
+    // Over budget the governor thins frames out before they cost a copy
+    const GovernorDecision decision = frameGovernor.decide();
+    if (!decision.process) {
+        return false;
+    }
+
+    int slotIndex;
+    if (!freeSlots.tryPop(slotIndex)) {
+        droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        metrics::MetricsRegistry::get().countDropped();
+        return false;
+    }
+    metrics::MetricsRegistry::get().countFrame();
+
+    FrameSlot& slot = slots[slotIndex];
+    const bool autoThresholds = autoThresholdEnabled.load(std::memory_order_relaxed);
+    slot.unrecorded = metrics::UnrecordedScope::active();
+    slot.submitTimeUs = nowUs();
+    metrics::ScopedTimer timer(metrics::STAGE_COPY_IN);
+    if (pixelStride == 1 && autoThresholds) {
+        // Row by row so the gradient sample of row y-1 reads its neighbours while they are in cache
+        for (int y = 0; y < frameHeight; ++y) {
+            uint8_t* row = slot.gray.ptr<uint8_t>(y);
+            std::memcpy(row, yPlane + static_cast<size_t>(y) * rowStride, frameWidth);
+            if (y >= 2 && AutoThreshold::sampleRow(y - 1)) {
+                autoThreshold.accumulateRow(slot.gray.ptr<uint8_t>(y - 2), slot.gray.ptr<uint8_t>(y - 1), row,
+                                            frameWidth);
+            }
+        }
+    } else if (pixelStride == 1) {
+        cv::Mat plane(frameHeight, frameWidth, CV_8UC1, const_cast<uint8_t*>(yPlane),
+                      static_cast<size_t>(rowStride));
+        plane.copyTo(slot.gray);
+    } else {
+        gatherPlane(yPlane, rowStride, pixelStride, slot.gray);
+        if (autoThresholds) {
+            autoThreshold.accumulate(slot.gray);
+        }
+    }
+
+    if (autoThresholds) {
+        autoThreshold.endFrame();
+        slot.lowThreshold = autoThreshold.low();
+        slot.highThreshold = autoThreshold.high();
+    } else {
+        slot.lowThreshold = cannyThreshold1.load(std::memory_order_relaxed);
+        slot.highThreshold = cannyThreshold2.load(std::memory_order_relaxed);
+    }
+    slot.timestampNs = timestampNs;
+    slot.slowestStageUs = timer.elapsedUs();
+    slot.pyramidLevel = decision.pyramidLevel;
+
+    // Cannot fail: at most kSlotCount indices exist across all rings
+    toPreprocess.tryPush(slotIndex);
+    return true;
+}
+
+bool FramePipeline::waitPop(SlotRing& ring, int& slot) {
+    int spins = 0;
+    while (!ring.tryPop(slot)) {
+        if (!isRunning()) {
+            return false;
+        }
+        if (++spins < kSpinIterations) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(kIdleSleep);
+        }
+    }
+    return true;
+}
+
+void FramePipeline::blurSlot(FrameSlot& slot) {
+    if (slot.pyramidLevel == 0) {
+        cv::GaussianBlur(slot.gray, slot.blurred, cv::Size(5, 5), 1.5);
+        return;
+    }
+
+    const cv::Mat* source = &slot.gray;
+    for (int level = 0; level < slot.pyramidLevel; ++level) {
+        cv::pyrDown(*source, slot.reduced[level]);
+        source = &slot.reduced[level];
+    }
+    cv::GaussianBlur(*source, slot.reducedBlurred[slot.pyramidLevel - 1], cv::Size(5, 5), 1.5);
+}
+
+void FramePipeline::detectSlot(FrameSlot& slot, OpenClCanny& openCl) const {
+    const bool reduced = slot.pyramidLevel > 0;
+    const cv::Mat& source = reduced ? slot.reducedBlurred[slot.pyramidLevel - 1] : slot.blurred;
+    cv::Mat& edges = reduced ? slot.reducedEdges[slot.pyramidLevel - 1] : slot.edges;
+    if (openClCanny.load(std::memory_order_relaxed) && OpenClCanny::available()) {
+        openCl.detect(source, edges, slot.lowThreshold, slot.highThreshold);
+    } else {
+        cv::Canny(source, edges, slot.lowThreshold, slot.highThreshold, 3);
+    }
+    if (reduced) {
+        cv::resize(edges, slot.edges, slot.edges.size(), 0, 0, cv::INTER_NEAREST);
+    }
+}
+
+void FramePipeline::preprocessLoop() {
+    nameCurrentThread("ev-blur");
+    bool onEfficiencyCores = efficiencyCores.load(std::memory_order_relaxed);
+    pinComputeStage(onEfficiencyCores);
+
+    int slotIndex;
+    while (waitPop(toPreprocess, slotIndex)) {
+        FrameSlot& slot = slots[slotIndex];
+        if (efficiencyCores.load(std::memory_order_relaxed) != onEfficiencyCores) {
+            onEfficiencyCores = !onEfficiencyCores;
+            pinComputeStage(onEfficiencyCores);
+        }
+        try {
+            metrics::UnrecordedScope unrecorded(slot.unrecorded);
+            metrics::ScopedTimer timer(metrics::STAGE_BLUR);
+            blurSlot(slot);
+            slot.slowestStageUs = std::max(slot.slowestStageUs, timer.elapsedUs());
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in blur stage: %s", e.what());
+        }
+        toDetect.tryPush(slotIndex);
+    }
+}
+
+void FramePipeline::detectLoop() {
+    nameCurrentThread("ev-canny");
+    bool onEfficiencyCores = efficiencyCores.load(std::memory_order_relaxed);
+    pinComputeStage(onEfficiencyCores);
+
+    // Owned by this thread, which is also the one its OpenCL queue belongs to
+    OpenClCanny openCl;
+
+    int slotIndex;
+    while (waitPop(toDetect, slotIndex)) {
+        FrameSlot& slot = slots[slotIndex];
+        if (efficiencyCores.load(std::memory_order_relaxed) != onEfficiencyCores) {
+            onEfficiencyCores = !onEfficiencyCores;
+            pinComputeStage(onEfficiencyCores);
+        }
+        try {
+            metrics::UnrecordedScope unrecorded(slot.unrecorded);
+            metrics::ScopedTimer timer(metrics::STAGE_CANNY);
+            detectSlot(slot, openCl);
+            slot.slowestStageUs = std::max(slot.slowestStageUs, timer.elapsedUs());
+        } catch (const cv::Exception& e) {
+            LOGE("OpenCV exception in detect stage: %s", e.what());
+        }
+        toOutput.tryPush(slotIndex);
+    }
+}
+
+void FramePipeline::outputLoop() {
+    nameCurrentThread("ev-output");
+
+    // Fan-out is mostly memcpy; keep it off the big cores when the SoC has little ones
+    const CpuTopology& topology = CpuTopology::get();
+    CpuTopology::pinCurrentThread(topology.littleCores().empty() ? topology.bigCores()
+                                                                 : topology.littleCores());
+
+    int slotIndex;
+    while (waitPop(toOutput, slotIndex)) {
+        FrameSlot& slot = slots[slotIndex];
+        // Covers the sinks' own timers (encode, upload) as well
+        metrics::UnrecordedScope unrecorded(slot.unrecorded);
+        const int64_t outputStartUs = nowUs();
+        for (const auto& sink : sinks) {
+            try {
+                sink(slot.edges, slot.timestampNs);
+            } catch (const std::exception& e) {
+                LOGE("Exception in pipeline sink: %s", e.what());
+            }
+        }
+
+        // Warm-up frames run cold; they would skew both the stats and the governor
+        if (!slot.unrecorded) {
+            const int64_t outputEndUs = nowUs();
+            // Submit to sinks, queueing included: what a caller of submit() sees as latency
+            metrics::MetricsRegistry::get().record(metrics::STAGE_TOTAL,
+                                                   static_cast<uint32_t>(outputEndUs - slot.submitTimeUs));
+
+            // Stages overlap, so the frame rate is bound by the slowest one, not by the sum
+            slot.slowestStageUs = std::max(slot.slowestStageUs, outputEndUs - outputStartUs);
+            frameGovernor.record(slot.slowestStageUs);
+        }
+        freeSlots.tryPush(slotIndex);
+    }
+}
+
+void LatestFrame::store(const cv::Mat& source, int64_t timestamp) {
+    std::lock_guard<std::mutex> guard(lock);
+    source.copyTo(frame);
+    timestampNs = timestamp;
+    fresh = true;
+}
+
+int64_t LatestFrame::take(cv::Mat& dst) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!fresh) {
+        return -1;
+    }
+    frame.copyTo(dst);
+    fresh = false;
+    return timestampNs;
+}
+
+void LatestFrame::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    fresh = false;
+    timestampNs = -1;
+}
+
+} // namespace edgevision
@@ -0,0 +1,181 @@
+#ifndef EDGEVISION_FRAME_PIPELINE_H
+#define EDGEVISION_FRAME_PIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "auto_threshold.h"
+#include "frame_governor.h"
+#include "spsc_ring.h"
+
+namespace edgevision {
+
+class OpenClCanny;
+
+/**
+ * Four-stage Canny pipeline: ingest -> blur -> detect -> output fan-out.
+ *
+ * Ingest runs on the submitting (camera) thread because the Image must be released
+ * quickly; each later stage owns a thread and stages hand frame slots to each other
+ * through SPSC rings, so throughput is bounded by the slowest stage.
+ */
+class FramePipeline {
+public:
+    /**
+     * Called on the output thread; the Mat is only valid for the duration of the call
+     */
+    using FrameSink = std::function<void(const cv::Mat& edges, int64_t timestampNs)>;
+
+    FramePipeline();
+    ~FramePipeline();
+
+    /**
+     * Register an output sink (only while stopped)
+     */
+    void addSink(FrameSink sink);
+
+    void setCannyThresholds(double threshold1, double threshold2);
+
+    /**
+     * Derive each frame's thresholds from the gradient magnitude sampled during the ingest
+     * copy (see AutoThreshold) instead of the fixed ones
+     */
+    void setAutoThreshold(bool enabled) { autoThresholdEnabled.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * Run the detect stage's Canny through OpenCL (OpenClCanny::detect) instead of cv::Canny
+     * on the CPU, from its next frame; ignored when the device has no OpenCL. The blur stage
+     * stays on the CPU.
+     */
+    void setOpenClCanny(bool enabled) { openClCanny.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * Size and fault in the frame slots for width x height, then push a dummy frame through
+     * the blur and detect stages at every governor pyramid level (compiling the OpenCL
+     * kernels when setOpenClCanny is on) on the calling thread, outside the stage
+     * histograms. start() does this itself unless it already ran for that size. Only while
+     * stopped.
+     */
+    bool prepare(int width, int height);
+
+    /**
+     * Start the stage threads, preparing first if the slots are not sized for width x height
+     */
+    bool start(int width, int height);
+
+    /**
+     * Move the blur and Canny stages from the big to the little cluster (or back) at their
+     * next frame; on SoCs without little cores they stay put
+     */
+    void setEfficiencyCores(bool enabled) { efficiencyCores.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * Stop and join all stage threads; in-flight frames are discarded
+     */
+    void stop();
+
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    int getWidth() const { return frameWidth; }
+    int getHeight() const { return frameHeight; }
+
+    /**
+     * Ingest stage: copy the Y plane into a free slot. Returns false (frame dropped)
+     * when every slot is still in flight.
+     */
+    bool submit(const uint8_t* yPlane, int rowStride, int pixelStride, int64_t timestampNs);
+
+    uint64_t getDroppedFrames() const { return droppedFrames.load(std::memory_order_relaxed); }
+
+    /**
+     * Decides per submitted frame. Fed with each frame's slowest stage time rather than
+     * its submit-to-output latency: the stages run concurrently, so the pipeline keeps up
+     * with the target rate as long as no single stage exceeds the per-frame budget.
+     */
+    FrameGovernor& governor() { return frameGovernor; }
+
+private:
+    static constexpr size_t kSlotCount = 4;
+
+    struct FrameSlot {
+        cv::Mat gray;
+        cv::Mat blurred;
+        cv::Mat edges;
+        // Per governor pyramid level 1..kMaxPyramidLevel, so no level resizes another's
+        cv::Mat reduced[FrameGovernor::kMaxPyramidLevel];
+        cv::Mat reducedBlurred[FrameGovernor::kMaxPyramidLevel];
+        cv::Mat reducedEdges[FrameGovernor::kMaxPyramidLevel];
+        int64_t timestampNs = 0;
+        int64_t submitTimeUs = 0;  // Start of ingest, for the STAGE_TOTAL latency
+        int64_t slowestStageUs = 0;  // Longest of this frame's ingest/blur/detect/output steps
+        int pyramidLevel = 0;
+        bool unrecorded = false;  // Submitted inside a metrics::UnrecordedScope
+        double lowThreshold = 0.0;  // Canny thresholds chosen at ingest
+        double highThreshold = 0.0;
+    };
+
+    using SlotRing = SpscRing<int, kSlotCount>;
+
+    void preprocessLoop();
+    void detectLoop();
+    void outputLoop();
+
+    // One frame's work in the blur and detect stages, shared by the loops and prepare()
+    static void blurSlot(FrameSlot& slot);
+    void detectSlot(FrameSlot& slot, OpenClCanny& openCl) const;
+
+    // Block until a slot index is available or the pipeline stops
+    bool waitPop(SlotRing& ring, int& slot);
+
+    std::array<FrameSlot, kSlotCount> slots;
+
+    // freeSlots: output -> ingest, toPreprocess: ingest -> blur,
+    // toDetect: blur -> detect, toOutput: detect -> output
+    SlotRing freeSlots;
+    SlotRing toPreprocess;
+    SlotRing toDetect;
+    SlotRing toOutput;
+
+    FrameGovernor frameGovernor;
+    std::vector<FrameSink> sinks;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> droppedFrames;
+    std::atomic<double> cannyThreshold1;
+    std::atomic<double> cannyThreshold2;
+    std::atomic<bool> autoThresholdEnabled;
+    std::atomic<bool> efficiencyCores;
+    std::atomic<bool> openClCanny;
+    AutoThreshold autoThreshold;    // Ingest (camera) thread only
+    int frameWidth;
+    int frameHeight;
+    bool prepared;
+};
+
+/**
+ * Mailbox holding the most recent pipeline output for polling from Java
+ */
+class LatestFrame {
+public:
+    void store(const cv::Mat& frame, int64_t timestampNs);
+
+    /**
+     * Copy the newest unread frame into dst; returns its timestamp or -1 if none
+     */
+    int64_t take(cv::Mat& dst);
+
+    void clear();
+
+private:
+    std::mutex lock;
+    cv::Mat frame;
+    int64_t timestampNs = -1;
+    bool fresh = false;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_FRAME_PIPELINE_H
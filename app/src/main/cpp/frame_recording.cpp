@@ -0,0 +1,297 @@
+#include "frame_recording.h"
+#include <android/log.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#define LOG_TAG "FrameRecording"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+const char kMagic[8] = {'E', 'V', 'R', 'A', 'W', 0, 0, 0};
+constexpr size_t kRecordAlignment = 64;
+
+size_t recordSize(int width, int height) {
+    const size_t bytes = sizeof(RecordHeader) + static_cast<size_t>(width) * height;
+    return (bytes + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+}
+
+} // namespace
+
+FrameRecorder::FrameRecorder()
+    : fd(-1)
+    , mapping(nullptr)
+    , mappingBytes(0)
+    , recording(false)
+{
+}
+
+FrameRecorder::~FrameRecorder() {
+    stop();
+}
+
+bool FrameRecorder::start(const std::string& path, int width, int height, int maxFrames) {
+    stop();
+    if (width <= 0 || height <= 0 || maxFrames <= 0) {
+        LOGE("Invalid recording size %dx%d x %d frames", width, height, maxFrames);
+        return false;
+    }
+
+    const size_t bytesPerRecord = recordSize(width, height);
+    const size_t totalBytes = sizeof(RecordingHeader) + bytesPerRecord * static_cast<size_t>(maxFrames);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGE("Cannot create %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    // Reserve the blocks now: a store into a sparse mapping on a full disk is SIGBUS
+    const int error = posix_fallocate(fd, 0, static_cast<off_t>(totalBytes));
+    if (error != 0) {
+        LOGE("Cannot reserve %zu bytes for %s: %s", totalBytes, path.c_str(), std::strerror(error));
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    void* address = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        LOGE("Cannot map %s: %s", path.c_str(), std::strerror(errno));
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    mapping = static_cast<uint8_t*>(address);
+    mappingBytes = totalBytes;
+    madvise(mapping, mappingBytes, MADV_SEQUENTIAL);
+
+    RecordingHeader* header = reinterpret_cast<RecordingHeader*>(mapping);
+    std::memset(header, 0, sizeof(RecordingHeader));
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kVersion;
+    header->headerBytes = sizeof(RecordingHeader);
+    header->width = static_cast<uint32_t>(width);
+    header->height = static_cast<uint32_t>(height);
+    header->recordBytes = static_cast<uint32_t>(bytesPerRecord);
+    header->frameCapacity = static_cast<uint32_t>(maxFrames);
+
+    recording.store(true, std::memory_order_release);
+    LOGD("Recording %dx%d, up to %d frames (%zu MB) to %s",
+         width, height, maxFrames, totalBytes >> 20, path.c_str());
+    return true;
+}
+
+bool FrameRecorder::append(const uint8_t* plane, int width, int height, int rowStride, int pixelStride,
+                           int64_t timestampNs, int mode) {
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    RecordingHeader* header = reinterpret_cast<RecordingHeader*>(mapping);
+    const uint32_t index = header->frameCount;
+    if (index >= header->frameCapacity
+            || width != static_cast<int>(header->width) || height != static_cast<int>(header->height)) {
+        return false;
+    }
+
+    uint8_t* base = mapping + sizeof(RecordingHeader) + static_cast<size_t>(index) * header->recordBytes;
+    RecordHeader* record = reinterpret_cast<RecordHeader*>(base);
+    record->timestampNs = timestampNs;
+    record->mode = mode;
+    record->reserved = 0;
+
+    uint8_t* luma = base + sizeof(RecordHeader);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = plane + static_cast<size_t>(y) * rowStride;
+        uint8_t* dst = luma + static_cast<size_t>(y) * width;
+        if (pixelStride == 1) {
+            std::memcpy(dst, src, width);
+        } else {
+            for (int x = 0; x < width; ++x) {
+                dst[x] = src[x * pixelStride];
+            }
+        }
+    }
+
+    if (index == 0) {
+        header->startTimestampNs = timestampNs;
+    }
+    // Publish the frame only after its bytes, so readers never see a torn record
+    __atomic_store_n(&header->frameCount, index + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+int FrameRecorder::stop() {
+    if (mapping == nullptr) {
+        return 0;
+    }
+    recording.store(false, std::memory_order_release);
+
+    const RecordingHeader* header = reinterpret_cast<const RecordingHeader*>(mapping);
+    const int written = static_cast<int>(header->frameCount);
+    const size_t usedBytes = sizeof(RecordingHeader) + static_cast<size_t>(written) * header->recordBytes;
+
+    munmap(mapping, mappingBytes);
+    mapping = nullptr;
+    mappingBytes = 0;
+
+    // Give back the unused preallocation
+    if (ftruncate(fd, static_cast<off_t>(usedBytes)) != 0) {
+        LOGE("Cannot trim recording: %s", std::strerror(errno));
+    }
+    ::close(fd);
+    fd = -1;
+
+    LOGD("Recording stopped after %d frames", written);
+    return written;
+}
+
+int FrameRecorder::framesWritten() const {
+    if (mapping == nullptr) {
+        return 0;
+    }
+    const RecordingHeader* header = reinterpret_cast<const RecordingHeader*>(mapping);
+    return static_cast<int>(__atomic_load_n(&header->frameCount, __ATOMIC_ACQUIRE));
+}
+
+FrameReplay::FrameReplay()
+    : mapping(nullptr)
+    , mappingBytes(0)
+    , frameWidth(0)
+    , frameHeight(0)
+    , frames(0)
+    , recordBytes(0)
+    , cursor(0)
+    , paced(false)
+{
+}
+
+FrameReplay::~FrameReplay() {
+    close();
+}
+
+bool FrameReplay::open(const std::string& path) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(RecordingHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    const size_t fileBytes = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, fileBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced; the descriptor is no longer needed
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        LOGE("Cannot map %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    const RecordingHeader* header = static_cast<const RecordingHeader*>(address);
+    const bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+            && header->version == FrameRecorder::kVersion
+            && header->headerBytes == sizeof(RecordingHeader)
+            && header->width > 0 && header->height > 0
+            && header->recordBytes == recordSize(static_cast<int>(header->width), static_cast<int>(header->height));
+    if (!valid) {
+        munmap(address, fileBytes);
+        return false;
+    }
+
+    mapping = static_cast<uint8_t*>(address);
+    mappingBytes = fileBytes;
+    frameWidth = static_cast<int>(header->width);
+    frameHeight = static_cast<int>(header->height);
+    recordBytes = header->recordBytes;
+
+    // A recording that was never stopped still holds its preallocation; trust frameCount
+    const size_t available = (fileBytes - sizeof(RecordingHeader)) / recordBytes;
+    frames = static_cast<int>(std::min<size_t>(header->frameCount, available));
+    madvise(mapping, mappingBytes, MADV_SEQUENTIAL);
+    rewind();
+
+    LOGD("Replaying %d frames of %dx%d from %s", frames, frameWidth, frameHeight, path.c_str());
+    return true;
+}
+
+void FrameReplay::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingBytes);
+    }
+    mapping = nullptr;
+    mappingBytes = 0;
+    frameWidth = 0;
+    frameHeight = 0;
+    frames = 0;
+    recordBytes = 0;
+    cursor = 0;
+}
+
+const RecordHeader* FrameReplay::record(int index) const {
+    return reinterpret_cast<const RecordHeader*>(
+            mapping + sizeof(RecordingHeader) + static_cast<size_t>(index) * recordBytes);
+}
+
+cv::Mat FrameReplay::frame(int index) const {
+    // OpenCV headers are non-const; callers only read (the mapping is PROT_READ)
+    uint8_t* luma = const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(record(index)) + sizeof(RecordHeader));
+    return cv::Mat(frameHeight, frameWidth, CV_8UC1, luma);
+}
+
+int64_t FrameReplay::timestampNs(int index) const {
+    return record(index)->timestampNs;
+}
+
+int FrameReplay::mode(int index) const {
+    return record(index)->mode;
+}
+
+void FrameReplay::setPaced(bool enabled) {
+    paced = enabled;
+    rewind();
+}
+
+std::chrono::steady_clock::time_point FrameReplay::nextDue() const {
+    // The first frame starts the clock when it is pulled
+    if (!paced || cursor == 0 || cursor >= frames) {
+        return std::chrono::steady_clock::now();
+    }
+    return replayStart + std::chrono::nanoseconds(timestampNs(cursor) - timestampNs(0));
+}
+
+bool FrameReplay::next(cv::Mat& frameOut, int64_t& timestampOut) {
+    if (cursor >= frames) {
+        return false;
+    }
+
+    const int index = cursor++;
+    if (paced && index == 0) {
+        replayStart = std::chrono::steady_clock::now();
+    }
+
+    frameOut = frame(index);
+    timestampOut = timestampNs(index);
+    return true;
+}
+
+void FrameReplay::rewind() {
+    cursor = 0;
+    replayStart = std::chrono::steady_clock::now();
+}
+
+} // namespace edgevision
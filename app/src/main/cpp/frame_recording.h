@@ -0,0 +1,152 @@
+#ifndef EDGEVISION_FRAME_RECORDING_H
+#define EDGEVISION_FRAME_RECORDING_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace edgevision {
+
+/**
+ * Raw Y-plane recording container (.evr), native byte order:
+ *
+ *   RecordingHeader (64 bytes), then frameCapacity records of recordBytes each:
+ *     RecordHeader (16 bytes) | width x height luma, rows packed | padding to 64 bytes
+ *
+ * The file is preallocated for frameCapacity records and written through a shared
+ * mapping, so appending a frame is a memcpy with no syscall. frameCount is published
+ * after each record's data, so a recording cut short by a crash is still readable up
+ * to its last complete frame.
+ */
+struct RecordingHeader {
+    char magic[8];              // "EVRAW\0\0\0"
+    uint32_t version;
+    uint32_t headerBytes;
+    uint32_t width;
+    uint32_t height;
+    uint32_t recordBytes;
+    uint32_t frameCapacity;
+    uint32_t frameCount;
+    uint32_t reserved0;
+    int64_t startTimestampNs;
+    uint8_t reserved[16];
+};
+
+struct RecordHeader {
+    int64_t timestampNs;        // Camera timestamp (handle-less calls: steady clock)
+    int32_t mode;               // ProcessingMode the frame was captured under
+    uint32_t reserved;
+};
+
+static_assert(sizeof(RecordingHeader) == 64, "RecordingHeader must stay 64 bytes");
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader must stay 16 bytes");
+
+/**
+ * Appends frames to a preallocated memory-mapped container. Not thread-safe: callers
+ * serialise start, append and stop; isRecording() can be polled without that lock to
+ * skip it while idle.
+ */
+class FrameRecorder {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    FrameRecorder();
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    /**
+     * Create path (truncating it) with room for maxFrames frames of width x height.
+     * Disk space is reserved up front, so a full disk fails here rather than mid-frame.
+     */
+    bool start(const std::string& path, int width, int height, int maxFrames);
+
+    /**
+     * Copy one Y plane into the next record; false when full, stopped or size mismatch
+     */
+    bool append(const uint8_t* plane, int width, int height, int rowStride, int pixelStride,
+                int64_t timestampNs, int mode);
+
+    /**
+     * Unmap and trim the file to the frames written; returns how many
+     */
+    int stop();
+
+    bool isRecording() const { return recording.load(std::memory_order_acquire); }
+    int framesWritten() const;
+
+private:
+    int fd;
+    uint8_t* mapping;
+    size_t mappingBytes;
+    std::atomic<bool> recording;
+};
+
+/**
+ * Read-only view of a recording; frames are cv::Mat headers over the mapping (no copy)
+ */
+class FrameReplay {
+public:
+    FrameReplay();
+    ~FrameReplay();
+
+    FrameReplay(const FrameReplay&) = delete;
+    FrameReplay& operator=(const FrameReplay&) = delete;
+
+    /**
+     * Map path and validate its header; false if it is not a recording
+     */
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return mapping != nullptr; }
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+    int frameCount() const { return frames; }
+
+    /**
+     * Frame index as an 8-bit Mat valid until close()
+     */
+    cv::Mat frame(int index) const;
+    int64_t timestampNs(int index) const;
+    int mode(int index) const;
+
+    /**
+     * true: nextDue() follows the recorded spacing of the frames;
+     * false: every frame is due as soon as the caller pulls it
+     */
+    void setPaced(bool paced);
+
+    /**
+     * When the frame next() returns is due. FrameReplay never sleeps itself, so callers can
+     * wait for this without holding whatever lock guards the replay.
+     */
+    std::chrono::steady_clock::time_point nextDue() const;
+
+    /**
+     * Next frame in order; false once every frame has been returned (rewind() to loop)
+     */
+    bool next(cv::Mat& frame, int64_t& timestampNs);
+    void rewind();
+
+private:
+    const RecordHeader* record(int index) const;
+
+    uint8_t* mapping;
+    size_t mappingBytes;
+    int frameWidth;
+    int frameHeight;
+    int frames;
+    size_t recordBytes;
+    int cursor;
+    bool paced;
+    std::chrono::steady_clock::time_point replayStart;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_FRAME_RECORDING_H
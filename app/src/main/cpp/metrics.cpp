@@ -0,0 +1,154 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace edgevision {
+namespace metrics {
+
+namespace {
+
+const char* const kStageNames[STAGE_COUNT] = {
+    "copyIn", "blur", "canny", "copyOut", "encode", "upload", "total"
+};
+
+inline int highestBit(uint32_t value) {
+    return 31 - __builtin_clz(value);
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : totalUs(0)
+    , maxUs(0)
+{
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::bucketFor(uint32_t micros) {
+    if (micros < kSubBuckets) {
+        return static_cast<int>(micros);
+    }
+    // msb >= 3: group by power of two, then the next three bits pick the sub-bucket
+    const int group = highestBit(micros) - 3;
+    const int sub = static_cast<int>((micros >> group) & (kSubBuckets - 1));
+    return kSubBuckets + group * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucketMidpoint(int bucket) {
+    if (bucket < kSubBuckets) {
+        return static_cast<uint64_t>(bucket);
+    }
+    const int group = (bucket - kSubBuckets) / kSubBuckets;
+    const int sub = (bucket - kSubBuckets) % kSubBuckets;
+    const uint64_t lower = static_cast<uint64_t>(kSubBuckets + sub) << group;
+    return lower + ((uint64_t{1} << group) >> 1);
+}
+
+void LatencyHistogram::record(uint32_t micros) {
+    buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+    totalUs.fetch_add(micros, std::memory_order_relaxed);
+
+    uint32_t currentMax = maxUs.load(std::memory_order_relaxed);
+    while (micros > currentMax &&
+           !maxUs.compare_exchange_weak(currentMax, micros, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize() const {
+    // Buckets are read one at a time, so a snapshot taken under load may be off by the few
+    // samples recorded while it runs; that is fine for monitoring
+    std::array<uint32_t, kBucketCount> counts;
+    Summary summary;
+    for (int i = 0; i < kBucketCount; ++i) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    summary.meanUs = totalUs.load(std::memory_order_relaxed) / summary.count;
+    summary.maxUs = maxUs.load(std::memory_order_relaxed);
+
+    const uint64_t p50Rank = (summary.count * 50 + 99) / 100;
+    const uint64_t p95Rank = (summary.count * 95 + 99) / 100;
+    const uint64_t p99Rank = (summary.count * 99 + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount && seen < p99Rank; ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        seen += counts[i];
+        const uint64_t value = std::min<uint64_t>(bucketMidpoint(i), summary.maxUs);
+        if (summary.p50Us == 0 && seen >= p50Rank) {
+            summary.p50Us = value;
+        }
+        if (summary.p95Us == 0 && seen >= p95Rank) {
+            summary.p95Us = value;
+        }
+        if (seen >= p99Rank) {
+            summary.p99Us = value;
+        }
+    }
+    return summary;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    totalUs.store(0, std::memory_order_relaxed);
+    maxUs.store(0, std::memory_order_relaxed);
+}
+
+MetricsRegistry::MetricsRegistry()
+    : frames(0)
+    , dropped(0)
+{
+}
+
+MetricsRegistry& MetricsRegistry::get() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::string MetricsRegistry::toJson() const {
+    char buffer[256];
+    std::string json;
+    json.reserve(1024);
+
+    std::snprintf(buffer, sizeof(buffer), "{\"frames\":%" PRIu64 ",\"dropped\":%" PRIu64 ",\"stages\":{",
+                  frames.load(std::memory_order_relaxed), dropped.load(std::memory_order_relaxed));
+    json += buffer;
+
+    bool first = true;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const LatencyHistogram::Summary s = stages[i].summarize();
+        if (s.count == 0) {
+            continue;
+        }
+        std::snprintf(buffer, sizeof(buffer),
+                      "%s\"%s\":{\"count\":%" PRIu64 ",\"meanUs\":%" PRIu64 ",\"p50Us\":%" PRIu64
+                      ",\"p95Us\":%" PRIu64 ",\"p99Us\":%" PRIu64 ",\"maxUs\":%" PRIu64 "}",
+                      first ? "" : ",", kStageNames[i], s.count, s.meanUs, s.p50Us, s.p95Us, s.p99Us, s.maxUs);
+        json += buffer;
+        first = false;
+    }
+
+    json += "}}";
+    return json;
+}
+
+void MetricsRegistry::reset() {
+    for (auto& stage : stages) {
+        stage.reset();
+    }
+    frames.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+}
+
+} // namespace metrics
+} // namespace edgevision
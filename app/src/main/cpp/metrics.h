@@ -0,0 +1,165 @@
+#ifndef EDGEVISION_METRICS_H
+#define EDGEVISION_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace edgevision {
+namespace metrics {
+
+/**
+ * Timed stages of the frame path (names are the keys in MetricsRegistry::toJson)
+ */
+enum Stage : int {
+    STAGE_COPY_IN = 0,    // Camera plane / Java array into processing memory
+    STAGE_BLUR,           // Gaussian blur (only when it runs as its own pass)
+    STAGE_CANNY,          // Canny or the selected edge filter; includes the blur for tiled and fused Canny
+    STAGE_COPY_OUT,       // Result into Java memory
+    STAGE_ENCODE,         // WebSocket packet encoding
+    STAGE_UPLOAD,         // Texture upload on the GL thread
+    STAGE_TOTAL,          // Whole process call; pipeline: submit() to the end of output
+    STAGE_COUNT
+};
+
+/**
+ * Lock-free log-linear latency histogram in microseconds.
+ *
+ * Values below 8 us get exact buckets; above that every power of two is split into
+ * 8 buckets, so percentiles are within ~6% for the whole 32-bit range. record() is a
+ * handful of relaxed atomic adds and can be called from any thread.
+ */
+class LatencyHistogram {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t meanUs = 0;
+        uint64_t p50Us = 0;
+        uint64_t p95Us = 0;
+        uint64_t p99Us = 0;
+        uint64_t maxUs = 0;
+    };
+
+    LatencyHistogram();
+
+    void record(uint32_t micros);
+    Summary summarize() const;
+    void reset();
+
+private:
+    static constexpr int kSubBuckets = 8;
+    static constexpr int kBucketCount = kSubBuckets + 29 * kSubBuckets;
+
+    static int bucketFor(uint32_t micros);
+    static uint64_t bucketMidpoint(int bucket);
+
+    std::array<std::atomic<uint32_t>, kBucketCount> buckets;
+    std::atomic<uint64_t> totalUs;
+    std::atomic<uint32_t> maxUs;
+};
+
+/**
+ * Process-wide stage histograms and frame counters
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& get();
+
+    void record(Stage stage, uint32_t micros) { stages[stage].record(micros); }
+    void countFrame() { frames.fetch_add(1, std::memory_order_relaxed); }
+    void countDropped() { dropped.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * {"frames":N,"dropped":N,"stages":{"copyIn":{"count":..,"meanUs":..,"p50Us":..,
+     * "p95Us":..,"p99Us":..,"maxUs":..},...}}; stages that never ran are omitted
+     */
+    std::string toJson() const;
+
+    void reset();
+
+private:
+    MetricsRegistry();
+
+    std::array<LatencyHistogram, STAGE_COUNT> stages;
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> dropped;
+};
+
+/**
+ * While one is alive, ScopedTimers on the constructing thread record nothing, so warm-up
+ * and probe frames stay out of the histograms. Nests. The flag is per thread: work handed
+ * to another thread has to carry it along (see FramePipeline's slots).
+ */
+class UnrecordedScope {
+public:
+    UnrecordedScope()
+        : UnrecordedScope(true)
+    {
+    }
+
+    /**
+     * Suppress only when enabled, e.g. for a frame that was submitted inside a scope
+     */
+    explicit UnrecordedScope(bool enabled)
+        : previous(suppressed())
+    {
+        suppressed() = previous || enabled;
+    }
+
+    ~UnrecordedScope() {
+        suppressed() = previous;
+    }
+
+    static bool active() { return suppressed(); }
+
+    UnrecordedScope(const UnrecordedScope&) = delete;
+    UnrecordedScope& operator=(const UnrecordedScope&) = delete;
+
+private:
+    static bool& suppressed() {
+        static thread_local bool value = false;
+        return value;
+    }
+
+    bool previous;
+};
+
+/**
+ * Records the lifetime of the scope into a stage histogram
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Stage stage)
+        : stage(stage)
+        , start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedTimer() {
+        if (!UnrecordedScope::active()) {
+            MetricsRegistry::get().record(stage, static_cast<uint32_t>(elapsedUs()));
+        }
+    }
+
+    /**
+     * Time since construction, e.g. to feed a FrameGovernor
+     */
+    int64_t elapsedUs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Stage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace metrics
+} // namespace edgevision
+
+#endif // EDGEVISION_METRICS_H
@@ -1,27 +1,427 @@
 #include <jni.h>
+#include <chrono>
 #include <string>
 #include <android/log.h>
 #include <vector>
-#include <chrono>
+#include <mutex>
+#include <thread>
+#include "batch_processor.h"
+#include "bitmap_writer.h"
 #include "edge_processor.h"
+#include "frame_encoder.h"
+#include "frame_pipeline.h"
+#include "frame_recording.h"
+#include "metrics.h"
+#include "output_pyramid.h"
+#include "processing_session.h"
+#include "result_callback.h"
+#include "texture_uploader.h"
+#include "thermal_scheduler.h"
+#include "video_encoder.h"
+#include "yuv_convert.h"
 
 #define LOG_TAG "EdgeVision-Native"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 
-// Global edge processor instance
-static edgevision::EdgeProcessor* g_edgeProcessor = nullptr;
+// Processing type constants (mirror NativeProcessor.PROCESSING_TYPE_*, see edgevision::ProcessingMode)
+static constexpr jint PROCESSING_TYPE_CANNY = edgevision::MODE_CANNY;
+static constexpr jint PROCESSING_TYPE_GRAYSCALE = edgevision::MODE_GRAYSCALE;
+static constexpr jint PROCESSING_TYPE_ORIGINAL = edgevision::MODE_ORIGINAL;
+
+// Session behind the handle-less entry points; NativeProcessor.create() makes more
+static edgevision::ProcessingSession g_defaultSession;
+
+// Pipelined processing (lifecycle and submit are serialized by g_pipelineLock)
+static std::mutex g_pipelineLock;
+static edgevision::FramePipeline* g_pipeline = nullptr;
+static int64_t g_pipelineTargetUs = 0;     // setTargetFps budget, kept until the pipeline exists
+static edgevision::LatestFrame g_pipelineResult;
+
+// Completion listener called on the pipeline output thread (replaces polling when set)
+static edgevision::ResultCallback g_resultCallback;
+
+// Offline batch processing (one batch at a time)
+static std::mutex g_batchLock;
+static edgevision::BatchProcessor g_batchProcessor;
+
+// PBO ring shared by the GL thread and the frame producer (see TextureUploader for threading)
+static edgevision::TextureUploader g_textureUploader;
+
+// WebSocket packet encoder and the reduced streams it serves (only called from the camera thread)
+static edgevision::protocol::FrameEncoder g_frameEncoder;
+static edgevision::OutputPyramid g_outputPyramid;
+
+// Hardware video streams; the server's idle timer releases them from another thread
+static std::mutex g_videoEncoderLock;
+static edgevision::protocol::VideoStreamEncoder g_videoEncoder;
+
+// Thermal back-off applied to the governors and pipeline stages (see setThermalScheduling)
+static edgevision::ThermalScheduler g_thermalScheduler;
+
+// Result of the last probeExecutionBackend, reported in getStats
+static std::mutex g_backendProbeLock;
+static edgevision::BackendProbe g_backendProbe;
+static bool g_backendProbed = false;
+
+// Field capture of input Y planes, and replay of such a capture through the default session
+static std::mutex g_recorderLock;
+static edgevision::FrameRecorder g_recorder;
+static std::mutex g_replayLock;
+static edgevision::FrameReplay g_replay;
+
+// Resolve a NativeProcessor.create() handle, nullptr if it was never valid
+static edgevision::ProcessingSession* sessionFromHandle(jlong handle) {
+    if (handle == 0) {
+        LOGE("Null processing session handle");
+        return nullptr;
+    }
+    return reinterpret_cast<edgevision::ProcessingSession*>(handle);
+}
+
+// Resolve and validate a direct Image.Plane buffer, nullptr if unusable
+static const uint8_t* getPlaneAddress(JNIEnv* env, jobject planeBuffer, jint rowStride,
+                                      jint pixelStride, jint width, jint height) {
+    auto* plane = static_cast<const uint8_t*>(env->GetDirectBufferAddress(planeBuffer));
+    if (plane == nullptr) {
+        LOGE("Plane is not a direct ByteBuffer");
+        return nullptr;
+    }
+
+    // The last row of a plane is not padded, so only (height-1) full strides are required
+    const size_t requiredBytes = edgevision::minimumPlaneBytes(width, height, rowStride, pixelStride);
+    if (requiredBytes == 0) {
+        LOGE("Invalid plane layout: %dx%d, rowStride=%d, pixelStride=%d",
+             width, height, rowStride, pixelStride);
+        return nullptr;
+    }
+
+    const jlong capacity = env->GetDirectBufferCapacity(planeBuffer);
+    if (capacity < 0 || !edgevision::planeFits(static_cast<size_t>(capacity), width, height, rowStride, pixelStride)) {
+        LOGE("Plane too small: %lld < %zu bytes", static_cast<long long>(capacity), requiredBytes);
+        return nullptr;
+    }
+
+    return plane;
+}
+
+// Wrap a caller-owned direct ByteBuffer as a packed width x height Mat (CV_8UC1 unless told otherwise)
+static bool wrapOutputBuffer(JNIEnv* env, jobject outputBuffer, jint width, jint height, cv::Mat& out,
+                             int type = CV_8UC1) {
+    auto* output = static_cast<uint8_t*>(env->GetDirectBufferAddress(outputBuffer));
+    if (output == nullptr) {
+        LOGE("Output is not a direct ByteBuffer");
+        return false;
+    }
+
+    const jlong requiredBytes = static_cast<jlong>(width) * height * CV_ELEM_SIZE(type);
+    const jlong capacity = env->GetDirectBufferCapacity(outputBuffer);
+    if (capacity < requiredBytes) {
+        LOGE("Output buffer too small: %lld < %lld bytes",
+             static_cast<long long>(capacity), static_cast<long long>(requiredBytes));
+        return false;
+    }
+
+    out = cv::Mat(height, width, type, output);
+    return true;
+}
+
+// Read a flat [x, y, width, height, ...] int array into rectangles (null = no ROIs)
+static bool readRegions(JNIEnv* env, jintArray rects, std::vector<cv::Rect>& regions) {
+    regions.clear();
+    if (rects == nullptr) {
+        return true;
+    }
+
+    const jsize length = env->GetArrayLength(rects);
+    if (length % 4 != 0) {
+        LOGE("Region array length %d is not a multiple of 4", length);
+        return false;
+    }
+
+    std::vector<jint> values(length);
+    env->GetIntArrayRegion(rects, 0, length, values.data());
+    for (jsize i = 0; i < length; i += 4) {
+        regions.emplace_back(values[i], values[i + 1], values[i + 2], values[i + 3]);
+    }
+    return true;
+}
+
+// Apply ROIs and their output layout to one session
+static jboolean setSessionRegions(JNIEnv* env, edgevision::ProcessingSession& session,
+                                  jintArray rects, jboolean compact) {
+    std::vector<cv::Rect> regions;
+    if (!readRegions(env, rects, regions)) {
+        return JNI_FALSE;
+    }
+
+    edgevision::SessionScope sessionScope = session.enter();
+    session.processor().setRegions(regions);
+    session.processor().setCompactRegionOutput(compact == JNI_TRUE);
+    return JNI_TRUE;
+}
+
+// Copy a Mat into a new Java byte array, stripping row padding; nullptr on failure
+static jbyteArray matToJavaArray(JNIEnv* env, const cv::Mat& mat) {
+    edgevision::metrics::ScopedTimer timer(edgevision::metrics::STAGE_COPY_OUT);
+    const jsize rowBytes = static_cast<jsize>(mat.cols * mat.elemSize());
+    jbyteArray array = env->NewByteArray(rowBytes * mat.rows);
+    if (array == nullptr) {
+        LOGE("Failed to allocate output array");
+        return nullptr;
+    }
+
+    if (mat.isContinuous()) {
+        env->SetByteArrayRegion(array, 0, rowBytes * mat.rows, reinterpret_cast<const jbyte*>(mat.data));
+    } else {
+        for (int y = 0; y < mat.rows; ++y) {
+            env->SetByteArrayRegion(array, y * rowBytes, rowBytes, reinterpret_cast<const jbyte*>(mat.ptr(y)));
+        }
+    }
+    return array;
+}
+
+// Pipeline with its output routed to the listener or the poll mailbox (under g_pipelineLock)
+static edgevision::FramePipeline* createPipeline() {
+    auto* pipeline = new edgevision::FramePipeline();
+    pipeline->addSink([](const cv::Mat& edges, int64_t timestampNs) {
+        if (g_resultCallback.hasListener()) {
+            g_resultCallback.deliver(edges, timestampNs);
+        } else {
+            g_pipelineResult.store(edges, timestampNs);
+        }
+    });
+    return pipeline;
+}
+
+// Create g_pipeline on first use (g_pipelineLock held), with the frame rate target and the
+// threshold and execution mode the default session was given before it existed
+static void ensurePipeline() {
+    if (g_pipeline != nullptr) {
+        return;
+    }
+    g_pipeline = createPipeline();
+    g_pipeline->governor().setTargetLatencyUs(g_pipelineTargetUs);
+
+    edgevision::SessionScope sessionScope = g_defaultSession.enter();
+    g_pipeline->setAutoThreshold(g_defaultSession.processor().isAutoThreshold());
+    g_pipeline->setOpenClCanny(g_defaultSession.processor().getExecutionMode() == edgevision::EXECUTION_OPENCL);
+}
+
+// Copy an input plane into the active recording; free when no recording is running
+static void recordPlane(const uint8_t* yPlane, jint width, jint height, jint rowStride, jint pixelStride,
+                        int64_t timestampNs, jint mode) {
+    if (!g_recorder.isRecording()) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(g_recorderLock);
+    g_recorder.append(yPlane, width, height, rowStride, pixelStride, timestampNs, mode);
+}
+
+// recordPlane for calls that carry no camera timestamp (steady clock instead)
+static void recordPlane(const uint8_t* yPlane, jint width, jint height, jint rowStride, jint pixelStride,
+                        jint mode) {
+    if (g_recorder.isRecording()) {
+        recordPlane(yPlane, width, height, rowStride, pixelStride,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count(), mode);
+    }
+}
+
+// Packed YUV frame from a Java array into a new Java array, default session
+static jbyteArray processArrayFrame(JNIEnv* env, jbyteArray inputData, jint width, jint height, jint mode) {
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid dimensions: %dx%d", width, height);
+        return nullptr;
+    }
+    if (env->GetArrayLength(inputData) < width * height) {
+        LOGE("Input array shorter than %d bytes", width * height);
+        return nullptr;
+    }
+
+    edgevision::metrics::ScopedTimer totalTimer(edgevision::metrics::STAGE_TOTAL);
+    edgevision::metrics::MetricsRegistry::get().countFrame();
+
+    // Buffers belong to the default session; hold it for the whole call
+    edgevision::SessionScope sessionScope = g_defaultSession.enter();
+    edgevision::EdgeProcessor& processor = g_defaultSession.processor();
+
+    jbyte* inputBytes = env->GetByteArrayElements(inputData, nullptr);
+    if (inputBytes == nullptr) {
+        LOGE("Failed to get input bytes");
+        return nullptr;
+    }
+
+    recordPlane(reinterpret_cast<const uint8_t*>(inputBytes), width, height, width, 1, mode);
+
+    jbyteArray outputArray = nullptr;
+    try {
+        // Only Canny with ROIs can skip rows; every other mode reads the whole frame
+        cv::Mat grayMat = processor.yuv420ToGray(reinterpret_cast<const uint8_t*>(inputBytes),
+                                                 width, height, mode == PROCESSING_TYPE_CANNY);
+        cv::Mat result = processor.process(grayMat, mode);
+        if (!result.empty()) {
+            // Copy straight into the Java array (no intermediate vector)
+            outputArray = matToJavaArray(env, result);
+        }
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in processFrame (mode %d): %s", mode, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Standard exception in processFrame (mode %d): %s", mode, e.what());
+    } catch (...) {
+        LOGE("Unknown exception in processFrame (mode %d)", mode);
+    }
+
+    env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
+    return outputArray;
+}
+
+// Packed YUV frame from a Java array into a caller-owned direct ByteBuffer, default session
+static jint processArrayFrameInto(JNIEnv* env, jbyteArray inputData, jint width, jint height, jint mode,
+                                  jobject outputBuffer) {
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid dimensions: %dx%d", width, height);
+        return -1;
+    }
+
+    edgevision::metrics::ScopedTimer totalTimer(edgevision::metrics::STAGE_TOTAL);
+    edgevision::metrics::MetricsRegistry::get().countFrame();
+
+    cv::Mat output;
+    if (!wrapOutputBuffer(env, outputBuffer, width, height, output)) {
+        return -1;
+    }
+
+    if (mode == PROCESSING_TYPE_GRAYSCALE) {
+        // Y plane is already grayscale: copy straight from the Java array into the output
+        edgevision::metrics::ScopedTimer copyTimer(edgevision::metrics::STAGE_COPY_IN);
+        env->GetByteArrayRegion(inputData, 0, width * height, reinterpret_cast<jbyte*>(output.data));
+        if (env->ExceptionCheck()) {
+            LOGE("Input array shorter than %d bytes", width * height);
+            return -1;
+        }
+        recordPlane(output.data, width, height, width, 1, mode);
+        return width * height;
+    }
+
+    // Buffers belong to the default session; hold it for the whole call
+    edgevision::SessionScope sessionScope = g_defaultSession.enter();
+    edgevision::EdgeProcessor& processor = g_defaultSession.processor();
+
+    if (env->GetArrayLength(inputData) < width * height) {
+        LOGE("Input array shorter than %d bytes", width * height);
+        return -1;
+    }
+    jbyte* inputBytes = env->GetByteArrayElements(inputData, nullptr);
+    if (inputBytes == nullptr) {
+        LOGE("Failed to get input bytes");
+        return -1;
+    }
+
+    recordPlane(reinterpret_cast<const uint8_t*>(inputBytes), width, height, width, 1, mode);
+
+    jint written = -1;
+    try {
+        cv::Mat grayMat = processor.yuv420ToGray(reinterpret_cast<const uint8_t*>(inputBytes),
+                                                 width, height, mode == PROCESSING_TYPE_CANNY);
+        if (processor.process(grayMat, output, mode)) {
+            written = mode == PROCESSING_TYPE_CANNY
+                    ? static_cast<jint>(processor.cannyOutputBytes(width, height)) : width * height;
+        }
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in processFrameInto (mode %d): %s", mode, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Standard exception in processFrameInto (mode %d): %s", mode, e.what());
+    } catch (...) {
+        LOGE("Unknown exception in processFrameInto (mode %d)", mode);
+    }
+
+    env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
+    return written;
+}
+
+// Live in-place path once the session is held: wrap the Y plane (interleaved gather,
+// automatic threshold sampling) and run mode into output; returns the bytes written or -1
+static jint processPlaneLocked(edgevision::EdgeProcessor& processor, const uint8_t* yPlane,
+                               jint rowStride, jint pixelStride, jint width, jint height, jint mode,
+                               int pyramidLevel, cv::Mat& output) {
+    if (mode == PROCESSING_TYPE_ORIGINAL) {
+        LOGE("Color output needs the chroma planes, use processColorPlanesInto");
+        return -1;
+    }
+
+    cv::Mat grayMat = processor.wrapPlane(yPlane, width, height, rowStride, pixelStride);
+    if (!processor.process(grayMat, output, mode, pyramidLevel)) {
+        return -1;
+    }
+    return mode == PROCESSING_TYPE_CANNY ? static_cast<jint>(processor.cannyOutputBytes(width, height))
+                                         : width * height;
+}
+
+// Process a camera Y plane in place into a caller-owned direct ByteBuffer using one session
+static jint processPlanesIntoSession(JNIEnv* env, edgevision::ProcessingSession& session,
+                                     jobject yBuffer, jint rowStride, jint pixelStride,
+                                     jint width, jint height, jint mode, jobject outputBuffer) {
+
+    // Validate before consulting the governor, so rejected calls never count as frames
+    const uint8_t* yPlane = getPlaneAddress(env, yBuffer, rowStride, pixelStride, width, height);
+    if (yPlane == nullptr) {
+        return -1;
+    }
+    cv::Mat output;
+    if (!wrapOutputBuffer(env, outputBuffer, width, height, output)) {
+        return -1;
+    }
+
+    // Thermal floor first, so the governor never steps back above it
+    session.governor().setMinimumStep(g_thermalScheduler.poll().minimumStep);
+
+    // Over budget the governor skips Canny frames outright (0 bytes = no new frame)
+    const edgevision::GovernorDecision decision = mode == PROCESSING_TYPE_CANNY
+            ? session.governor().decide() : edgevision::GovernorDecision{true, 0};
+    if (!decision.process) {
+        return 0;
+    }
+
+    edgevision::metrics::ScopedTimer totalTimer(edgevision::metrics::STAGE_TOTAL);
+    edgevision::metrics::MetricsRegistry::get().countFrame();
+    recordPlane(yPlane, width, height, rowStride, pixelStride, mode);
+
+    // Scratch buffers belong to the session; hold it for the whole call
+    edgevision::SessionScope sessionScope = session.enter();
+
+    try {
+        const jint written = processPlaneLocked(session.processor(), yPlane, rowStride, pixelStride,
+                                                width, height, mode, decision.pyramidLevel, output);
+        if (written >= 0 && mode == PROCESSING_TYPE_CANNY) {
+            session.governor().record(totalTimer.elapsedUs());
+        }
+        return written;
 
-// Initialize edge processor
-static void ensureEdgeProcessorInitialized() {
-    if (g_edgeProcessor == nullptr) {
-        g_edgeProcessor = new edgevision::EdgeProcessor();
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in processPlanesInto: %s", e.what());
+        return -1;
+    } catch (const std::exception& e) {
+        LOGE("Standard exception in processPlanesInto: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in processPlanesInto");
+        return -1;
     }
 }
 
 extern "C" {
 
+/**
+ * Cache the JavaVM so native threads can call back into Kotlin
+ */
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM* vm, void* /* reserved */) {
+    edgevision::ResultCallback::setJavaVm(vm);
+    return JNI_VERSION_1_6;
+}
+
 /**
  * Get version string - test function
  */
@@ -34,6 +434,20 @@ Java_com_example_edgevision_native_NativeProcessor_getVersionString(
     return env->NewStringUTF(version.c_str());
 }
 
+/**
+ * Process a packed YUV frame in any grayscale-output mode (NativeProcessor.PROCESSING_TYPE_*)
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processFrame(
+        JNIEnv* env,
+        jobject /* this */,
+        jbyteArray inputData,
+        jint width,
+        jint height,
+        jint mode) {
+    return processArrayFrame(env, inputData, width, height, mode);
+}
+
 /**
  * Process frame with Canny edge detection
  */
@@ -44,167 +458,1240 @@ Java_com_example_edgevision_native_NativeProcessor_processFrameCanny(
         jbyteArray inputData,
         jint width,
         jint height) {
+    return processArrayFrame(env, inputData, width, height, PROCESSING_TYPE_CANNY);
+}
+
+/**
+ * Process frame to grayscale
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processFrameGrayscale(
+        JNIEnv* env,
+        jobject /* this */,
+        jbyteArray inputData,
+        jint width,
+        jint height) {
+    return processArrayFrame(env, inputData, width, height, PROCESSING_TYPE_GRAYSCALE);
+}
+
+/**
+ * Process a camera Y plane in place from its direct ByteBuffer (zero-copy input)
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processPlanes(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject yBuffer,
+        jint rowStride,
+        jint pixelStride,
+        jint width,
+        jint height,
+        jint mode) {
 
-    auto startTime = std::chrono::high_resolution_clock::now();
+    edgevision::metrics::ScopedTimer totalTimer(edgevision::metrics::STAGE_TOTAL);
+    edgevision::metrics::MetricsRegistry::get().countFrame();
 
-    // Initialize edge processor
-    ensureEdgeProcessorInitialized();
+    // Buffers belong to the default session; hold it for the whole call
+    edgevision::SessionScope sessionScope = g_defaultSession.enter();
+    edgevision::EdgeProcessor& processor = g_defaultSession.processor();
 
-    // Get input data
-    jbyte* inputBytes = env->GetByteArrayElements(inputData, nullptr);
-    if (inputBytes == nullptr) {
-        LOGE("Failed to get input bytes");
+    // Get plane memory without copying
+    const uint8_t* yPlane = getPlaneAddress(env, yBuffer, rowStride, pixelStride, width, height);
+    if (yPlane == nullptr) {
         return nullptr;
     }
+    recordPlane(yPlane, width, height, rowStride, pixelStride, mode);
 
     try {
-        // Validate input dimensions
-        if (width <= 0 || height <= 0) {
-            LOGE("Invalid dimensions: %dx%d", width, height);
-            env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-            return nullptr;
-        }
+        cv::Mat grayMat = processor.wrapPlane(yPlane, width, height, rowStride, pixelStride);
 
-        // Process with OpenCV Canny
-        cv::Mat edges = g_edgeProcessor->processCanny(
-            reinterpret_cast<const uint8_t*>(inputBytes),
-            width,
-            height
-        );
-
-        // Convert Mat to byte array
-        std::vector<uint8_t> resultBytes = g_edgeProcessor->matToByteArray(edges);
-
-        // Create Java byte array
-        jbyteArray outputArray = env->NewByteArray(resultBytes.size());
-        if (outputArray == nullptr) {
-            env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-            LOGE("Failed to allocate output array");
+        cv::Mat result = processor.process(grayMat, mode);
+        if (result.empty()) {
             return nullptr;
         }
 
-        env->SetByteArrayRegion(outputArray, 0, resultBytes.size(),
-                                reinterpret_cast<const jbyte*>(resultBytes.data()));
-
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-
-        // Calculate processing time
-        auto endTime = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-        LOGI("Canny processing: %dx%d in %lld ms, output: %zu bytes",
-             width, height, duration.count(), resultBytes.size());
-
-        return outputArray;
+        // Copy straight into the Java array (strips row padding)
+        return matToJavaArray(env, result);
 
     } catch (const cv::Exception& e) {
-        LOGE("OpenCV exception in processCanny: %s", e.what());
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
+        LOGE("OpenCV exception in processPlanes: %s", e.what());
         return nullptr;
     } catch (const std::exception& e) {
-        LOGE("Standard exception in processCanny: %s", e.what());
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
+        LOGE("Standard exception in processPlanes: %s", e.what());
         return nullptr;
     } catch (...) {
-        LOGE("Unknown exception in processCanny");
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
+        LOGE("Unknown exception in processPlanes");
         return nullptr;
     }
 }
 
 /**
- * Process frame to grayscale
+ * Process a packed YUV frame in any grayscale-output mode into a caller-owned direct ByteBuffer
+ * Returns the number of bytes written, or -1 on failure
  */
-JNIEXPORT jbyteArray JNICALL
-Java_com_example_edgevision_native_NativeProcessor_processFrameGrayscale(
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processFrameInto(
         JNIEnv* env,
         jobject /* this */,
         jbyteArray inputData,
         jint width,
-        jint height) {
-
-    auto startTime = std::chrono::high_resolution_clock::now();
-
-    // Initialize edge processor
-    ensureEdgeProcessorInitialized();
-
-    // Get input data
-    jbyte* inputBytes = env->GetByteArrayElements(inputData, nullptr);
-    if (inputBytes == nullptr) {
-        LOGE("Failed to get input bytes");
-        return nullptr;
-    }
+        jint height,
+        jint mode,
+        jobject outputBuffer) {
+    return processArrayFrameInto(env, inputData, width, height, mode, outputBuffer);
+}
 
-    try {
-        // Validate input dimensions
-        if (width <= 0 || height <= 0) {
-            LOGE("Invalid dimensions: %dx%d", width, height);
-            env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-            return nullptr;
-        }
+/**
+ * Process frame with Canny edge detection into a caller-owned direct ByteBuffer
+ * Returns the number of bytes written, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processFrameCannyInto(
+        JNIEnv* env,
+        jobject /* this */,
+        jbyteArray inputData,
+        jint width,
+        jint height,
+        jobject outputBuffer) {
+    return processArrayFrameInto(env, inputData, width, height, PROCESSING_TYPE_CANNY, outputBuffer);
+}
 
-        // Process with OpenCV grayscale
-        cv::Mat grayMat = g_edgeProcessor->processGrayscale(
-            reinterpret_cast<const uint8_t*>(inputBytes),
-            width,
-            height
-        );
+/**
+ * Convert frame to grayscale into a caller-owned direct ByteBuffer
+ * Returns the number of bytes written, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processFrameGrayscaleInto(
+        JNIEnv* env,
+        jobject /* this */,
+        jbyteArray inputData,
+        jint width,
+        jint height,
+        jobject outputBuffer) {
+    return processArrayFrameInto(env, inputData, width, height, PROCESSING_TYPE_GRAYSCALE, outputBuffer);
+}
 
-        // Convert Mat to byte array
-        std::vector<uint8_t> resultBytes = g_edgeProcessor->matToByteArray(grayMat);
+/**
+ * Process a camera Y plane in place and write into a caller-owned direct ByteBuffer
+ * Returns the number of bytes written, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processPlanesInto(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject yBuffer,
+        jint rowStride,
+        jint pixelStride,
+        jint width,
+        jint height,
+        jint mode,
+        jobject outputBuffer) {
+    return processPlanesIntoSession(env, g_defaultSession, yBuffer, rowStride, pixelStride,
+                                    width, height, mode, outputBuffer);
+}
 
-        // Create Java byte array
-        jbyteArray outputArray = env->NewByteArray(resultBytes.size());
-        if (outputArray == nullptr) {
-            env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-            LOGE("Failed to allocate output array");
-            return nullptr;
-        }
+/**
+ * Convert camera YUV_420_888 planes (planar or semi-planar) to RGBA in a caller-owned
+ * direct ByteBuffer of width * height * 4 bytes, for PROCESSING_TYPE_ORIGINAL
+ * Returns the number of bytes written, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processColorPlanesInto(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject yBuffer,
+        jobject uBuffer,
+        jobject vBuffer,
+        jint yRowStride,
+        jint uvRowStride,
+        jint uvPixelStride,
+        jint width,
+        jint height,
+        jobject outputBuffer) {
 
-        env->SetByteArrayRegion(outputArray, 0, resultBytes.size(),
-                                reinterpret_cast<const jbyte*>(resultBytes.data()));
+    edgevision::metrics::ScopedTimer totalTimer(edgevision::metrics::STAGE_TOTAL);
+    edgevision::metrics::MetricsRegistry::get().countFrame();
 
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
+    // Chroma is subsampled 2x in both directions, rounding up for odd sizes
+    const jint chromaWidth = (width + 1) / 2;
+    const jint chromaHeight = (height + 1) / 2;
+    edgevision::YuvPlanes planes;
+    planes.y = getPlaneAddress(env, yBuffer, yRowStride, 1, width, height);
+    planes.u = getPlaneAddress(env, uBuffer, uvRowStride, uvPixelStride, chromaWidth, chromaHeight);
+    planes.v = getPlaneAddress(env, vBuffer, uvRowStride, uvPixelStride, chromaWidth, chromaHeight);
+    if (planes.y == nullptr || planes.u == nullptr || planes.v == nullptr) {
+        return -1;
+    }
+    planes.yRowStride = yRowStride;
+    planes.uvRowStride = uvRowStride;
+    planes.uvPixelStride = uvPixelStride;
 
-        // Calculate processing time
-        auto endTime = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-        LOGI("Grayscale processing: %dx%d in %lld ms, output: %zu bytes",
-             width, height, duration.count(), resultBytes.size());
+    cv::Mat output;
+    if (!wrapOutputBuffer(env, outputBuffer, width, height, output, CV_8UC4)) {
+        return -1;
+    }
 
-        return outputArray;
+    try {
+        edgevision::yuvToRgba(planes, width, height, output);
+        return width * height * 4;
 
     } catch (const cv::Exception& e) {
-        LOGE("OpenCV exception in processGrayscale: %s", e.what());
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-        return nullptr;
+        LOGE("OpenCV exception in processColorPlanesInto: %s", e.what());
+        return -1;
     } catch (const std::exception& e) {
-        LOGE("Standard exception in processGrayscale: %s", e.what());
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-        return nullptr;
+        LOGE("Standard exception in processColorPlanesInto: %s", e.what());
+        return -1;
     } catch (...) {
-        LOGE("Unknown exception in processGrayscale");
-        env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
-        return nullptr;
+        LOGE("Unknown exception in processColorPlanesInto");
+        return -1;
     }
 }
 
 /**
- * Process frame and return as Bitmap
+ * Create an independent processing session (own buffers, settings and core affinity)
+ * Returns an opaque handle for the session* functions, or 0 on failure
  */
-JNIEXPORT jobject JNICALL
-Java_com_example_edgevision_native_NativeProcessor_processFrameToBitmap(
+JNIEXPORT jlong JNICALL
+Java_com_example_edgevision_native_NativeProcessor_create(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+    try {
+        return reinterpret_cast<jlong>(new edgevision::ProcessingSession());
+    } catch (const std::exception& e) {
+        LOGE("Failed to create processing session: %s", e.what());
+        return 0;
+    }
+}
+
+/**
+ * Free a session from create(); no call on it may still be running
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_destroy(
         JNIEnv* /* env */,
         jobject /* this */,
-        jbyteArray /* inputData */,
+        jlong handle) {
+    delete reinterpret_cast<edgevision::ProcessingSession*>(handle);
+}
+
+/**
+ * processPlanesInto on a session from create()
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_sessionProcessPlanesInto(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jobject yBuffer,
+        jint rowStride,
+        jint pixelStride,
         jint width,
         jint height,
-        jint processingType) {
+        jint mode,
+        jobject outputBuffer) {
+    edgevision::ProcessingSession* session = sessionFromHandle(handle);
+    if (session == nullptr) {
+        return -1;
+    }
+    return processPlanesIntoSession(env, *session, yBuffer, rowStride, pixelStride,
+                                    width, height, mode, outputBuffer);
+}
 
-    LOGD("processFrameToBitmap: %dx%d, type=%d", width, height, processingType);
+/**
+ * Canny execution mode for one session (see setExecutionMode)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_sessionSetExecutionMode(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jlong handle,
+        jint mode) {
+    edgevision::ProcessingSession* session = sessionFromHandle(handle);
+    if (session != nullptr) {
+        edgevision::SessionScope sessionScope = session->enter();
+        session->processor().setExecutionMode(mode);
+    }
+}
+
+/**
+ * Automatic Canny thresholds for one session (see setAutoThreshold)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_sessionSetAutoThreshold(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jlong handle,
+        jboolean enabled) {
+    edgevision::ProcessingSession* session = sessionFromHandle(handle);
+    if (session != nullptr) {
+        edgevision::SessionScope sessionScope = session->enter();
+        session->processor().setAutoThreshold(enabled == JNI_TRUE);
+    }
+}
+
+/**
+ * Tiled execution thread count for one session (0 = one per CPU)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_sessionSetThreadCount(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jlong handle,
+        jint threads) {
+    edgevision::ProcessingSession* session = sessionFromHandle(handle);
+    if (session != nullptr) {
+        edgevision::SessionScope sessionScope = session->enter();
+        session->processor().setThreadCount(threads);
+    }
+}
+
+/**
+ * Restrict Canny on the default session to ROIs ([x, y, width, height, ...], null = whole
+ * frame); compact packs the ROIs back to back instead of zeroing the rest of the frame
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_setRegions(
+        JNIEnv* env,
+        jobject /* this */,
+        jintArray rects,
+        jboolean compact) {
+    return setSessionRegions(env, g_defaultSession, rects, compact);
+}
+
+/**
+ * setRegions for a session from create()
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_sessionSetRegions(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong handle,
+        jintArray rects,
+        jboolean compact) {
+    edgevision::ProcessingSession* session = sessionFromHandle(handle);
+    if (session == nullptr) {
+        return JNI_FALSE;
+    }
+    return setSessionRegions(env, *session, rects, compact);
+}
+
+/**
+ * Cores the threads calling into this session run on (0=any, 1=big, 2=little)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_sessionSetCoreAffinity(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jlong handle,
+        jint affinity) {
+    edgevision::ProcessingSession* session = sessionFromHandle(handle);
+    if (session != nullptr) {
+        session->setAffinity(affinity);
+    }
+}
+
+/**
+ * Process a batch of Y planes (direct ByteBuffers, width x height with rowStride) in one
+ * call, spread over worker threads. Result i is written at i * width * height in output.
+ * Returns the number of frames processed, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processBatch(
+        JNIEnv* env,
+        jobject /* this */,
+        jobjectArray frameBuffers,
+        jint rowStride,
+        jint width,
+        jint height,
+        jint mode,
+        jobject outputBuffer) {
+
+    if (!edgevision::EdgeProcessor::supportsMode(mode)) {
+        LOGE("Unsupported processing mode for batch: %d", mode);
+        return -1;
+    }
+
+    const jsize frameCount = env->GetArrayLength(frameBuffers);
+    if (frameCount == 0) {
+        return 0;
+    }
+
+    // The arena is one tall Mat of all results, so wrapOutputBuffer validates its capacity
+    cv::Mat arena;
+    if (!wrapOutputBuffer(env, outputBuffer, width, height * frameCount, arena)) {
+        return -1;
+    }
+
+    std::vector<const uint8_t*> frames(frameCount);
+    for (jsize i = 0; i < frameCount; ++i) {
+        jobject frameBuffer = env->GetObjectArrayElement(frameBuffers, i);
+        frames[i] = frameBuffer != nullptr
+                ? getPlaneAddress(env, frameBuffer, rowStride, 1, width, height) : nullptr;
+        env->DeleteLocalRef(frameBuffer);
+        if (frames[i] == nullptr) {
+            LOGE("Batch frame %d is not a usable direct ByteBuffer", i);
+            return -1;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(g_batchLock);
+    try {
+        // Settings come from the default session; its buffers are not touched
+        edgevision::EdgeProcessor settings;
+        {
+            edgevision::SessionScope sessionScope = g_defaultSession.enter();
+            settings.setExecutionMode(g_defaultSession.processor().getExecutionMode());
+            settings.setAutoThreshold(g_defaultSession.processor().isAutoThreshold());
+            settings.setCannyThresholds(g_defaultSession.processor().getCannyThreshold1(),
+                                        g_defaultSession.processor().getCannyThreshold2());
+        }
+        g_batchProcessor.process(frames, rowStride, width, height,
+                                 mode, settings, arena.data);
+        return frameCount;
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in processBatch: %s", e.what());
+        return -1;
+    } catch (const std::exception& e) {
+        LOGE("Standard exception in processBatch: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in processBatch");
+        return -1;
+    }
+}
+
+/**
+ * Warm the default session for width x height frames in mode before the first real one
+ * (buffers, arena, OpenCV thread pool, OpenCL kernels), and for Canny also the pipeline's
+ * slots and stages unless it is already running; blocks for the dummy frames, which stay
+ * out of the stage histograms
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_prepare(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint width,
+        jint height,
+        jint mode) {
+
+    try {
+        {
+            edgevision::SessionScope sessionScope = g_defaultSession.enter();
+            if (!g_defaultSession.processor().prepare(width, height, mode)) {
+                return JNI_FALSE;
+            }
+        }
+        if (mode != edgevision::MODE_CANNY) {
+            return JNI_TRUE;
+        }
+
+        std::lock_guard<std::mutex> guard(g_pipelineLock);
+        ensurePipeline();
+        return g_pipeline->isRunning() || g_pipeline->prepare(width, height) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in prepare: %s", e.what());
+        return JNI_FALSE;
+    } catch (const std::exception& e) {
+        // e.g. bad_alloc from sizing the slots and arena up front
+        LOGE("Standard exception in prepare: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * Derive Canny thresholds from each frame's median gradient magnitude (never below the fixed
+ * 50/150), for the default session and the pipeline
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_setAutoThreshold(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jboolean enabled) {
+    {
+        edgevision::SessionScope sessionScope = g_defaultSession.enter();
+        g_defaultSession.processor().setAutoThreshold(enabled == JNI_TRUE);
+    }
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+    if (g_pipeline != nullptr) {
+        g_pipeline->setAutoThreshold(enabled == JNI_TRUE);
+    }
+}
+
+/**
+ * Select the Canny execution mode (0=OpenCV full frame, 1=tiled bands, 2=fused NEON,
+ * 3=OpenCL via cv::UMat). The pipeline's detect stage follows OpenCL vs CPU; its CPU
+ * path is always cv::Canny, since each stage already has a thread of its own.
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_setExecutionMode(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint mode) {
+    {
+        edgevision::SessionScope sessionScope = g_defaultSession.enter();
+        g_defaultSession.processor().setExecutionMode(mode);
+    }
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+    if (g_pipeline != nullptr) {
+        g_pipeline->setOpenClCanny(mode == edgevision::EXECUTION_OPENCL);
+    }
+}
+
+/**
+ * Time the default session's CPU execution mode against OpenCL at width x height and
+ * switch the session and the pipeline's detect stage to whichever is faster; returns the
+ * selected execution mode. Takes up to a few seconds on first use while OpenCL kernels
+ * compile. Call it before the camera starts: frames processed meanwhile compete for the
+ * same cores and GPU and skew the timings.
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_probeExecutionBackend(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint width,
+        jint height) {
+
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid probe size: %dx%d", width, height);
+        return -1;
+    }
+
+    int cpuMode;
+    {
+        edgevision::SessionScope sessionScope = g_defaultSession.enter();
+        cpuMode = g_defaultSession.processor().getExecutionMode();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(g_pipelineLock);
+        if (g_pipeline != nullptr && g_pipeline->isRunning()) {
+            LOGE("probeExecutionBackend while the pipeline runs; timings include its load");
+        }
+    }
+
+    try {
+        const edgevision::BackendProbe probe = edgevision::EdgeProcessor::probeBackends(width, height, cpuMode);
+        bool apply;
+        {
+            edgevision::SessionScope sessionScope = g_defaultSession.enter();
+            // Leave it alone if the app picked a mode while the probe ran
+            apply = g_defaultSession.processor().getExecutionMode() == cpuMode;
+            if (apply) {
+                g_defaultSession.processor().setExecutionMode(probe.selectedMode);
+            }
+        }
+        if (apply) {
+            std::lock_guard<std::mutex> guard(g_pipelineLock);
+            if (g_pipeline != nullptr) {
+                g_pipeline->setOpenClCanny(probe.selectedMode == edgevision::EXECUTION_OPENCL);
+            }
+        }
+        std::lock_guard<std::mutex> guard(g_backendProbeLock);
+        g_backendProbe = probe;
+        g_backendProbed = true;
+        return probe.selectedMode;
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in probeExecutionBackend: %s", e.what());
+        return -1;
+    }
+}
+
+/**
+ * Set the worker thread count for tiled execution and batches (0 = one per CPU). This
+ * also sizes OpenCV's global thread pool, so it applies to every session
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_setThreadCount(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint threads) {
+    {
+        edgevision::SessionScope sessionScope = g_defaultSession.enter();
+        g_defaultSession.processor().setThreadCount(threads);
+    }
+
+    // Bands and batch runs only set the work split; OpenCV's pool decides how many threads
+    // execute it (0 would make it serial, negative restores one per CPU)
+    cv::setNumThreads(threads > 0 ? threads : -1);
+
+    std::lock_guard<std::mutex> guard(g_batchLock);
+    g_batchProcessor.setWorkerCount(threads);
+}
+
+/**
+ * Latency budget for the resolution / frame-skip governors of the pipeline and the
+ * default session, as a target frame rate (0 = always full resolution, every frame)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_setTargetFps(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jfloat fps) {
+    const int64_t targetUs = fps > 0.0f ? static_cast<int64_t>(1000000.0f / fps) : 0;
+    g_defaultSession.governor().setTargetLatencyUs(targetUs);
+
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+    g_pipelineTargetUs = targetUs;
+    if (g_pipeline != nullptr) {
+        g_pipeline->governor().setTargetLatencyUs(targetUs);
+    }
+}
+
+/**
+ * Follow AThermal status and headroom: step resolution/rate down, move pipeline stages to
+ * the little cores and recommend the GPU backend before the SoC throttles
+ * Returns false if the device has no AThermal (API < 30)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_setThermalScheduling(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jboolean enabled) {
+
+    const bool applied = g_thermalScheduler.setEnabled(enabled == JNI_TRUE);
+    if (enabled == JNI_TRUE) {
+        return applied ? JNI_TRUE : JNI_FALSE;
+    }
+
+    // Lift the floors now rather than at the next frame of each path
+    g_defaultSession.governor().setMinimumStep(0);
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+    if (g_pipeline != nullptr) {
+        g_pipeline->governor().setMinimumStep(0);
+        g_pipeline->setEfficiencyCores(false);
+    }
+    return JNI_TRUE;
+}
+
+/**
+ * Whether the thermal scheduler currently wants Canny on the GPU backend (polls it)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_thermalPrefersGpu(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+    return g_thermalScheduler.poll().preferGpu ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Start the staged native pipeline for frames of the given size
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_pipelineStart(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint width,
+        jint height) {
+
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+    ensurePipeline();
+
+    g_pipelineResult.clear();
+    try {
+        return g_pipeline->start(width, height) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in pipelineStart: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * Hand a camera Y plane to the pipeline; returns false if the frame was dropped
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_pipelineSubmit(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject yBuffer,
+        jint rowStride,
+        jint pixelStride,
+        jint width,
+        jint height,
+        jlong timestampNs) {
+
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+
+    if (g_pipeline == nullptr || !g_pipeline->isRunning()) {
+        LOGE("Pipeline not started");
+        return JNI_FALSE;
+    }
+
+    if (width != g_pipeline->getWidth() || height != g_pipeline->getHeight()) {
+        LOGE("Frame %dx%d does not match pipeline %dx%d",
+             width, height, g_pipeline->getWidth(), g_pipeline->getHeight());
+        return JNI_FALSE;
+    }
+
+    const uint8_t* yPlane = getPlaneAddress(env, yBuffer, rowStride, pixelStride, width, height);
+    if (yPlane == nullptr) {
+        return JNI_FALSE;
+    }
+    recordPlane(yPlane, width, height, rowStride, pixelStride, timestampNs, PROCESSING_TYPE_CANNY);
+
+    const edgevision::ThermalPolicy thermal = g_thermalScheduler.poll();
+    g_pipeline->governor().setMinimumStep(thermal.minimumStep);
+    g_pipeline->setEfficiencyCores(thermal.efficiencyCores);
+
+    try {
+        return g_pipeline->submit(yPlane, rowStride, pixelStride, timestampNs) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in pipelineSubmit: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/**
+ * Copy the newest completed pipeline frame into a direct ByteBuffer
+ * Returns its camera timestamp, or -1 if no new frame is ready
+ */
+JNIEXPORT jlong JNICALL
+Java_com_example_edgevision_native_NativeProcessor_pipelinePoll(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject outputBuffer) {
+
+    int width;
+    int height;
+    {
+        std::lock_guard<std::mutex> guard(g_pipelineLock);
+        if (g_pipeline == nullptr) {
+            return -1;
+        }
+        width = g_pipeline->getWidth();
+        height = g_pipeline->getHeight();
+    }
+
+    cv::Mat output;
+    if (!wrapOutputBuffer(env, outputBuffer, width, height, output)) {
+        return -1;
+    }
+
+    try {
+        edgevision::metrics::ScopedTimer timer(edgevision::metrics::STAGE_COPY_OUT);
+        return g_pipelineResult.take(output);
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in pipelinePoll: %s", e.what());
+        return -1;
+    }
+}
+
+/**
+ * Register a NativeProcessor.ResultListener for pipeline results, or clear it with null
+ * Only allowed while the pipeline is stopped; returns false otherwise
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_setResultListener(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject listener) {
+
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+    if (g_pipeline != nullptr && g_pipeline->isRunning()) {
+        LOGE("Result listener can only be changed while the pipeline is stopped");
+        return JNI_FALSE;
+    }
+    return g_resultCallback.setListener(env, listener) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Stop the pipeline threads (buffers are kept for a later restart)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_pipelineStop(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+
+    std::lock_guard<std::mutex> guard(g_pipelineLock);
+    if (g_pipeline != nullptr) {
+        g_pipeline->stop();
+    }
+    g_pipelineResult.clear();
+}
+
+/**
+ * Record every input Y plane (processFrame*, processPlanes*, pipelineSubmit) into a preallocated
+ * memory-mapped container at path, up to maxFrames frames of width x height
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_recordingStart(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring path,
+        jint width,
+        jint height,
+        jint maxFrames) {
+
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        return JNI_FALSE;
+    }
+    const std::string recordingPath(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+
+    std::lock_guard<std::mutex> guard(g_recorderLock);
+    return g_recorder.start(recordingPath, width, height, maxFrames) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Finish the recording; returns the number of frames it holds
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_recordingStop(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+
+    std::lock_guard<std::mutex> guard(g_recorderLock);
+    return g_recorder.stop();
+}
+
+/**
+ * Open a recording for replayNextInto
+ * Returns {width, height, frameCount}, or null if path is not a recording
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_example_edgevision_native_NativeProcessor_replayOpen(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring path,
+        jboolean paced) {
+
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        return nullptr;
+    }
+    const std::string replayPath(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+
+    std::lock_guard<std::mutex> guard(g_replayLock);
+    if (!g_replay.open(replayPath)) {
+        LOGE("Not a recording: %s", replayPath.c_str());
+        return nullptr;
+    }
+    g_replay.setPaced(paced == JNI_TRUE);
+
+    const jint info[3] = {g_replay.width(), g_replay.height(), g_replay.frameCount()};
+    jintArray result = env->NewIntArray(3);
+    if (result != nullptr) {
+        env->SetIntArrayRegion(result, 0, 3, info);
+    }
+    return result;
+}
+
+/**
+ * Run the next recorded frame through the default session into a direct ByteBuffer
+ * (width * height bytes), on the same path as live processPlanesInto frames; paced replays
+ * block until the frame's recorded time
+ * Returns the bytes written, 0 at the end of the recording, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_replayNextInto(
+        JNIEnv* env,
+        jobject /* this */,
+        jint mode,
+        jobject outputBuffer) {
+
+    // Wait unlocked, so replayClose and the camera path are not held up by pacing
+    std::chrono::steady_clock::time_point due;
+    {
+        std::lock_guard<std::mutex> guard(g_replayLock);
+        if (!g_replay.isOpen()) {
+            LOGE("No recording open");
+            return -1;
+        }
+        due = g_replay.nextDue();
+    }
+    std::this_thread::sleep_until(due);
+
+    // Frames point into the mapping, so keep the replay locked until processing is done
+    std::lock_guard<std::mutex> guard(g_replayLock);
+    if (!g_replay.isOpen()) {
+        LOGE("Recording closed during replay");
+        return -1;
+    }
+
+    cv::Mat output;
+    if (!wrapOutputBuffer(env, outputBuffer, g_replay.width(), g_replay.height(), output)) {
+        return -1;
+    }
+
+    cv::Mat frame;
+    int64_t timestampNs = 0;
+    if (!g_replay.next(frame, timestampNs)) {
+        return 0;
+    }
+
+    edgevision::metrics::ScopedTimer totalTimer(edgevision::metrics::STAGE_TOTAL);
+    edgevision::metrics::MetricsRegistry::get().countFrame();
+
+    edgevision::SessionScope sessionScope = g_defaultSession.enter();
+    try {
+        return processPlaneLocked(g_defaultSession.processor(), frame.data, static_cast<jint>(frame.step),
+                                  1, frame.cols, frame.rows, mode, 0, output);
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in replayNextInto: %s", e.what());
+        return -1;
+    }
+}
+
+/**
+ * Unmap the replayed recording
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_replayClose(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+
+    std::lock_guard<std::mutex> guard(g_replayLock);
+    g_replay.close();
+}
+
+/**
+ * Pack a processed frame (direct ByteBuffer, width * height bytes) into the binary
+ * WebSocket format in a caller-owned direct ByteBuffer, using the given payload encoding,
+ * at output pyramid level (0 = full, n = 1/2^n per side)
+ * Returns the packet length, 0 when a video encoder has no output ready yet, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_encodeFrame(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject frameBuffer,
+        jint width,
+        jint height,
+        jint mode,
+        jlong timestampMs,
+        jfloat fps,
+        jint encoding,
+        jint level,
+        jobject packetBuffer) {
+
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid frame dimensions for encoding: %dx%d", width, height);
+        return -1;
+    }
+    if (level < 0 || level >= edgevision::OutputPyramid::kLevels) {
+        LOGE("Invalid output level: %d", level);
+        return -1;
+    }
+
+    cv::Mat frame;
+    if (!wrapOutputBuffer(env, frameBuffer, width, height, frame)) {
+        return -1;
+    }
+
+    auto* packet = static_cast<uint8_t*>(env->GetDirectBufferAddress(packetBuffer));
+    if (packet == nullptr) {
+        LOGE("Packet is not a direct ByteBuffer");
+        return -1;
+    }
+    const jlong capacity = env->GetDirectBufferCapacity(packetBuffer);
+
+    edgevision::protocol::FrameHeader header;
+    header.mode = static_cast<uint8_t>(mode);
+    header.timestampMs = timestampMs;
+    header.fps = fps;
+    header.encoding = static_cast<uint8_t>(encoding);
+
+    edgevision::metrics::ScopedTimer timer(edgevision::metrics::STAGE_ENCODE);
+
+    // One downscale per level per frame, however many clients and codecs share it
+    g_outputPyramid.setFrame(frame, timestampMs, edgevision::isBinaryMode(mode));
+    const cv::Mat& levelFrame = g_outputPyramid.level(level);
+
+    if (edgevision::protocol::isVideoEncoding(header.encoding)) {
+        // Hardware encoders lag a frame or two behind, so "nothing yet" is not an error
+        size_t written = 0;
+        std::lock_guard<std::mutex> guard(g_videoEncoderLock);
+        if (!g_videoEncoder.encode(levelFrame, header, packet, static_cast<size_t>(capacity),
+                                   level, written)) {
+            return -1;
+        }
+        return static_cast<jint>(written);
+    }
+
+    const size_t written = g_frameEncoder.encode(levelFrame, header, packet,
+                                                 static_cast<size_t>(capacity), level);
+    return written > 0 ? static_cast<jint>(written) : -1;
+}
+
+/**
+ * Per-stage latency histograms and frame counters as a JSON object (see MetricsRegistry::toJson)
+ */
+JNIEXPORT jstring JNICALL
+Java_com_example_edgevision_native_NativeProcessor_getStats(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::string json = edgevision::metrics::MetricsRegistry::get().toJson();
+
+    // Report the governor of whichever path is producing Canny frames
+    std::string governor;
+    {
+        std::lock_guard<std::mutex> guard(g_pipelineLock);
+        if (g_pipeline != nullptr && g_pipeline->isRunning()) {
+            governor = g_pipeline->governor().toJson();
+        }
+    }
+    if (governor.empty()) {
+        governor = g_defaultSession.governor().toJson();
+    }
+    json.pop_back();
+    json += ",\"governor\":" + governor + ",\"thermal\":" + g_thermalScheduler.toJson();
+    {
+        std::lock_guard<std::mutex> guard(g_backendProbeLock);
+        if (g_backendProbed) {
+            json += ",\"backend\":" + g_backendProbe.toJson();
+        }
+    }
+    json += "}";
+    return env->NewStringUTF(json.c_str());
+}
+
+/**
+ * Clear all latency histograms and counters
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_resetStats(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+    edgevision::metrics::MetricsRegistry::get().reset();
+}
+
+/**
+ * Make the next packet of one tile-delta or video stream (encoding at output level) a
+ * keyframe, for every client of that stream
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_requestKeyframe(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint encoding,
+        jint level) {
+    if (edgevision::protocol::isVideoEncoding(static_cast<uint8_t>(encoding))) {
+        std::lock_guard<std::mutex> guard(g_videoEncoderLock);
+        g_videoEncoder.requestKeyframe(static_cast<uint8_t>(encoding), level);
+    } else if (encoding == edgevision::protocol::ENCODING_TILE_DELTA) {
+        g_frameEncoder.requestKeyframe(level);
+    }
+}
+
+/**
+ * Tile-delta keyframe of the frame the level's delta stream last encoded, for one client
+ * that lost its reference, without resetting the stream for the others.
+ * Returns the packet length, 0 if the stream has no frame yet, or -1 on failure
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_edgevision_native_NativeProcessor_encodeKeyframe(
+        JNIEnv* env,
+        jobject /* this */,
+        jint mode,
+        jlong timestampMs,
+        jfloat fps,
+        jint level,
+        jobject packetBuffer) {
+
+    auto* packet = static_cast<uint8_t*>(env->GetDirectBufferAddress(packetBuffer));
+    if (packet == nullptr) {
+        LOGE("Packet is not a direct ByteBuffer");
+        return -1;
+    }
+    const jlong capacity = env->GetDirectBufferCapacity(packetBuffer);
+
+    edgevision::protocol::FrameHeader header;
+    header.mode = static_cast<uint8_t>(mode);
+    header.timestampMs = timestampMs;
+    header.fps = fps;
+
+    edgevision::metrics::ScopedTimer timer(edgevision::metrics::STAGE_ENCODE);
+    return static_cast<jint>(g_frameEncoder.encodeKeyframe(header, packet, static_cast<size_t>(capacity), level));
+}
+
+/**
+ * Free the hardware video encoders nobody has fed for idleMs (0 = all)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_releaseIdleVideoEncoders(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jlong idleMs) {
+    std::lock_guard<std::mutex> guard(g_videoEncoderLock);
+    g_videoEncoder.releaseIdle(static_cast<int64_t>(idleMs) * 1000);
+}
+
+/**
+ * Create the pixel buffer ring for the current GL context (GL thread)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_uploaderInitialize(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint width,
+        jint height) {
+
+    return g_textureUploader.initialize(width, height) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Upload the newest published frame into a GL_LUMINANCE texture (GL thread)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_uploaderUpdate(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint textureId) {
+
+    return g_textureUploader.update(static_cast<GLuint>(textureId)) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Delete the pixel buffer ring (GL thread)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_uploaderRelease(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+
+    g_textureUploader.release();
+}
+
+/**
+ * Claim a mapped pixel buffer as a direct ByteBuffer, or null if none is free.
+ * The buffer is only valid until uploaderPublish.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_example_edgevision_native_NativeProcessor_uploaderAcquire(
+        JNIEnv* env,
+        jobject /* this */) {
+
+    uint8_t* mapped = g_textureUploader.acquire();
+    if (mapped == nullptr) {
+        return nullptr;
+    }
+
+    jobject buffer = env->NewDirectByteBuffer(mapped, static_cast<jlong>(g_textureUploader.getFrameBytes()));
+    if (buffer == nullptr) {
+        g_textureUploader.publish(false);
+    }
+    return buffer;
+}
+
+/**
+ * Hand the acquired pixel buffer to the GL thread (written=false discards it)
+ */
+JNIEXPORT void JNICALL
+Java_com_example_edgevision_native_NativeProcessor_uploaderPublish(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jboolean written) {
+
+    g_textureUploader.publish(written == JNI_TRUE);
+}
+
+/**
+ * Process a packed YUV frame straight into a caller-owned ARGB_8888 Bitmap of width x height
+ * (gray-output modes expanded to RGBA, original converted to color), so the Bitmap can be
+ * reused across frames. Returns false on failure.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_processFrameToBitmap(
+        JNIEnv* env,
+        jobject /* this */,
+        jbyteArray inputData,
+        jint width,
+        jint height,
+        jint processingType,
+        jobject bitmap) {
+
+    edgevision::metrics::ScopedTimer totalTimer(edgevision::metrics::STAGE_TOTAL);
+    edgevision::metrics::MetricsRegistry::get().countFrame();
+
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid dimensions: %dx%d", width, height);
+        return JNI_FALSE;
+    }
+
+    edgevision::BitmapLock output(env, bitmap, width, height);
+    if (!output.isLocked()) {
+        return JNI_FALSE;
+    }
+
+    // Buffers belong to the default session; hold it for the whole call
+    edgevision::SessionScope sessionScope = g_defaultSession.enter();
+    edgevision::EdgeProcessor& processor = g_defaultSession.processor();
+
+    const jsize length = env->GetArrayLength(inputData);
+    jbyte* inputBytes = env->GetByteArrayElements(inputData, nullptr);
+    if (inputBytes == nullptr) {
+        LOGE("Failed to get input bytes");
+        return JNI_FALSE;
+    }
+    const auto* yuv = reinterpret_cast<const uint8_t*>(inputBytes);
+
+    jboolean written = JNI_FALSE;
+    try {
+        if (processingType == PROCESSING_TYPE_ORIGINAL) {
+            // Convert straight into the locked pixels rather than through rgbaBuffer
+            edgevision::YuvPlanes planes;
+            if (edgevision::packedYuvPlanes(yuv, static_cast<size_t>(length), width, height, planes)) {
+                edgevision::yuvToRgba(planes, width, height, output.pixels());
+                written = JNI_TRUE;
+            } else {
+                LOGE("Unrecognized YUV layout: %d bytes for %dx%d", length, width, height);
+            }
+        } else if (length < width * height) {
+            LOGE("Input array shorter than %d bytes", width * height);
+        } else {
+            cv::Mat gray = processor.yuv420ToGray(yuv, width, height, processingType == PROCESSING_TYPE_CANNY);
+            cv::Mat result = processor.process(gray, processingType);
+            if (!result.empty()) {
+                edgevision::grayToRgba(result, output.pixels());
+                written = JNI_TRUE;
+            }
+        }
+
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCV exception in processFrameToBitmap: %s", e.what());
+    } catch (const std::exception& e) {
+        LOGE("Standard exception in processFrameToBitmap: %s", e.what());
+    } catch (...) {
+        LOGE("Unknown exception in processFrameToBitmap");
+    }
+
+    env->ReleaseByteArrayElements(inputData, inputBytes, JNI_ABORT);
+    return written;
+}
+
+/**
+ * Expand an already processed width x height gray frame into a caller-owned ARGB_8888 Bitmap
+ * (snapshot/export without glReadPixels or an intermediate pixel array)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_edgevision_native_NativeProcessor_grayToBitmap(
+        JNIEnv* env,
+        jobject /* this */,
+        jbyteArray grayData,
+        jint width,
+        jint height,
+        jobject bitmap) {
+
+    if (width <= 0 || height <= 0 || env->GetArrayLength(grayData) < width * height) {
+        LOGE("Gray frame smaller than %dx%d", width, height);
+        return JNI_FALSE;
+    }
+
+    edgevision::BitmapLock output(env, bitmap, width, height);
+    if (!output.isLocked()) {
+        return JNI_FALSE;
+    }
+
+    jbyte* grayBytes = env->GetByteArrayElements(grayData, nullptr);
+    if (grayBytes == nullptr) {
+        LOGE("Failed to get gray bytes");
+        return JNI_FALSE;
+    }
 
-    // TODO: Implement bitmap conversion with OpenCV
-    // For now, return null
-    return nullptr;
+    edgevision::grayToRgba(cv::Mat(height, width, CV_8UC1, grayBytes), output.pixels());
+    env->ReleaseByteArrayElements(grayData, grayBytes, JNI_ABORT);
+    return JNI_TRUE;
 }
 
 } // extern "C"
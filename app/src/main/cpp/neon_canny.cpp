@@ -0,0 +1,213 @@
+#include "neon_canny.h"
+#include "canny_kernels.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define LOG_TAG "FusedCanny"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+// 5-tap Gaussian for sigma 1.5 in Q8: [0.1201 0.2339 0.2921 0.2339 0.1201] * 256
+constexpr int kGaussOuter = 31;
+constexpr int kGaussInner = 60;
+constexpr int kGaussCenter = 74;
+
+constexpr int kHorizontalRing = 5;
+constexpr int kSobelRing = 3;
+
+inline int reflect101(int i, int size) {
+    return i < 0 ? -i : (i >= size ? 2 * size - 2 - i : i);
+}
+
+inline uint8_t gauss5(int outer, int inner, int center) {
+    return static_cast<uint8_t>((outer * kGaussOuter + inner * kGaussInner + center * kGaussCenter + 128) >> 8);
+}
+
+void blurHorizontal(const uint8_t* src, uint8_t* dst, int width) {
+    // Borders use BORDER_REFLECT_101 like cv::GaussianBlur
+    for (int x = 0; x < 2; ++x) {
+        dst[x] = gauss5(src[reflect101(x - 2, width)] + src[x + 2],
+                        src[reflect101(x - 1, width)] + src[x + 1], src[x]);
+    }
+
+    int x = 2;
+#if defined(__ARM_NEON)
+    const uint8x8_t wCenter = vdup_n_u8(kGaussCenter);
+    const uint16x8_t wInner = vdupq_n_u16(kGaussInner);
+    const uint16x8_t wOuter = vdupq_n_u16(kGaussOuter);
+    for (; x + 8 <= width - 2; x += 8) {
+        const uint16x8_t inner = vaddl_u8(vld1_u8(src + x - 1), vld1_u8(src + x + 1));
+        const uint16x8_t outer = vaddl_u8(vld1_u8(src + x - 2), vld1_u8(src + x + 2));
+        uint16x8_t acc = vmull_u8(vld1_u8(src + x), wCenter);
+        acc = vmlaq_u16(acc, inner, wInner);
+        acc = vmlaq_u16(acc, outer, wOuter);
+        vst1_u8(dst + x, vrshrn_n_u16(acc, 8));
+    }
+#endif
+    for (; x < width - 2; ++x) {
+        dst[x] = gauss5(src[x - 2] + src[x + 2], src[x - 1] + src[x + 1], src[x]);
+    }
+
+    for (x = std::max(2, width - 2); x < width; ++x) {
+        dst[x] = gauss5(src[x - 2] + src[reflect101(x + 2, width)],
+                        src[x - 1] + src[reflect101(x + 1, width)], src[x]);
+    }
+}
+
+void blurVertical(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+                  const uint8_t* r3, const uint8_t* r4, uint8_t* dst, int width) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    const uint8x8_t wCenter = vdup_n_u8(kGaussCenter);
+    const uint16x8_t wInner = vdupq_n_u16(kGaussInner);
+    const uint16x8_t wOuter = vdupq_n_u16(kGaussOuter);
+    for (; x + 8 <= width; x += 8) {
+        const uint16x8_t inner = vaddl_u8(vld1_u8(r1 + x), vld1_u8(r3 + x));
+        const uint16x8_t outer = vaddl_u8(vld1_u8(r0 + x), vld1_u8(r4 + x));
+        uint16x8_t acc = vmull_u8(vld1_u8(r2 + x), wCenter);
+        acc = vmlaq_u16(acc, inner, wInner);
+        acc = vmlaq_u16(acc, outer, wOuter);
+        vst1_u8(dst + x, vrshrn_n_u16(acc, 8));
+    }
+#endif
+    for (; x < width; ++x) {
+        dst[x] = gauss5(r0[x] + r4[x], r1[x] + r3[x], r2[x]);
+    }
+}
+
+inline void sobelPixel(const uint8_t* p, const uint8_t* c, const uint8_t* n,
+                       int xl, int x, int xr, int16_t* dx, int16_t* dy, int* mag) {
+    const int gx = (p[xr] - p[xl]) + 2 * (c[xr] - c[xl]) + (n[xr] - n[xl]);
+    const int gy = (n[xl] + 2 * n[x] + n[xr]) - (p[xl] + 2 * p[x] + p[xr]);
+    dx[x] = static_cast<int16_t>(gx);
+    dy[x] = static_cast<int16_t>(gy);
+    mag[x] = std::abs(gx) + std::abs(gy);
+}
+
+void sobelRow(const uint8_t* p, const uint8_t* c, const uint8_t* n,
+              int16_t* dx, int16_t* dy, int* mag, int width) {
+    // Borders use BORDER_REPLICATE like cv::Canny's internal Sobel
+    sobelPixel(p, c, n, 0, 0, 1, dx, dy, mag);
+
+    int x = 1;
+#if defined(__ARM_NEON)
+    for (; x + 8 <= width - 1; x += 8) {
+        const int16x8_t pl = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p + x - 1)));
+        const int16x8_t pc = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p + x)));
+        const int16x8_t pr = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p + x + 1)));
+        const int16x8_t cl = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(c + x - 1)));
+        const int16x8_t cr = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(c + x + 1)));
+        const int16x8_t nl = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(n + x - 1)));
+        const int16x8_t nc = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(n + x)));
+        const int16x8_t nr = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(n + x + 1)));
+
+        int16x8_t gx = vaddq_s16(vsubq_s16(pr, pl), vsubq_s16(nr, nl));
+        gx = vaddq_s16(gx, vshlq_n_s16(vsubq_s16(cr, cl), 1));
+
+        const int16x8_t bottom = vaddq_s16(vaddq_s16(nl, nr), vshlq_n_s16(nc, 1));
+        const int16x8_t top = vaddq_s16(vaddq_s16(pl, pr), vshlq_n_s16(pc, 1));
+        const int16x8_t gy = vsubq_s16(bottom, top);
+
+        vst1q_s16(dx + x, gx);
+        vst1q_s16(dy + x, gy);
+
+        const int16x8_t m = vaddq_s16(vabsq_s16(gx), vabsq_s16(gy));
+        vst1q_s32(mag + x, vmovl_s16(vget_low_s16(m)));
+        vst1q_s32(mag + x + 4, vmovl_s16(vget_high_s16(m)));
+    }
+#endif
+    for (; x < width - 1; ++x) {
+        sobelPixel(p, c, n, x - 1, x, x + 1, dx, dy, mag);
+    }
+
+    sobelPixel(p, c, n, width - 2, width - 1, width - 1, dx, dy, mag);
+}
+
+} // namespace
+
+FusedCanny::FusedCanny()
+    : width(0)
+    , height(0)
+{
+}
+
+void FusedCanny::allocate(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+
+    horizontalRows.assign(static_cast<size_t>(kHorizontalRing) * width, 0);
+    blurredRows.assign(static_cast<size_t>(kSobelRing) * width, 0);
+    dxRows.assign(static_cast<size_t>(kSobelRing) * width, 0);
+    dyRows.assign(static_cast<size_t>(kSobelRing) * width, 0);
+    magnitudeRows.assign(static_cast<size_t>(kSobelRing) * width, 0);
+    zeroRow.assign(width, 0);
+
+    classMap.create(height + 2, width + 2, CV_8UC1);
+    classMap.setTo(cv::Scalar(canny::EDGE_NONE));
+
+    LOGD("Fused Canny buffers sized for %dx%d", width, height);
+}
+
+void FusedCanny::run(const cv::Mat& gray, cv::Mat& edges, double lowThreshold, double highThreshold) {
+    if (gray.cols != width || gray.rows != height) {
+        allocate(gray.cols, gray.rows);
+    }
+
+    // Integer thresholds, matching cv::Canny's L1 path (which swaps a reversed pair)
+    if (lowThreshold > highThreshold) {
+        std::swap(lowThreshold, highThreshold);
+    }
+    const int low = static_cast<int>(std::floor(lowThreshold));
+    const int high = static_cast<int>(std::floor(highThreshold));
+
+    auto hRow = [&](int y) { return horizontalRows.data() + static_cast<size_t>(y % kHorizontalRing) * width; };
+    auto bRow = [&](int y) { return blurredRows.data() + static_cast<size_t>(y % kSobelRing) * width; };
+    auto slot = [&](int y) { return static_cast<size_t>(y % kSobelRing) * width; };
+
+    // Each input row y advances every stage by one row; stage k lags the input by k rows
+    // because it needs k rows of look-ahead from the stage before it
+    for (int y = 0; y < height + 4; ++y) {
+        if (y < height) {
+            blurHorizontal(gray.ptr<uint8_t>(y), hRow(y), width);
+        }
+
+        const int blurY = y - 2;
+        if (blurY >= 0 && blurY < height) {
+            blurVertical(hRow(reflect101(blurY - 2, height)), hRow(reflect101(blurY - 1, height)),
+                         hRow(blurY), hRow(reflect101(blurY + 1, height)),
+                         hRow(reflect101(blurY + 2, height)), bRow(blurY), width);
+        }
+
+        const int sobelY = blurY - 1;
+        if (sobelY >= 0 && sobelY < height) {
+            const size_t s = slot(sobelY);
+            sobelRow(bRow(std::max(sobelY - 1, 0)), bRow(sobelY), bRow(std::min(sobelY + 1, height - 1)),
+                     dxRows.data() + s, dyRows.data() + s, magnitudeRows.data() + s, width);
+        }
+
+        const int nmsY = sobelY - 1;
+        if (nmsY >= 0 && nmsY < height) {
+            const int* magPrev = nmsY > 0 ? magnitudeRows.data() + slot(nmsY - 1) : zeroRow.data();
+            const int* magNext = nmsY + 1 < height ? magnitudeRows.data() + slot(nmsY + 1) : zeroRow.data();
+            const size_t s = slot(nmsY);
+            canny::suppressRow(magPrev, magnitudeRows.data() + s, magNext,
+                               dxRows.data() + s, dyRows.data() + s, width, low, high,
+                               classMap.ptr<uint8_t>(nmsY + 1) + 1);
+        }
+    }
+
+    canny::hysteresis(classMap, edges, stack);
+}
+
+} // namespace edgevision
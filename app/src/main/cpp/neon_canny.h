@@ -0,0 +1,46 @@
+#ifndef EDGEVISION_NEON_CANNY_H
+#define EDGEVISION_NEON_CANNY_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace edgevision {
+
+/**
+ * Single-pass Canny front end: 5x5 Gaussian, 3x3 Sobel and NMS are computed row by row
+ * from small ring buffers, so the Y plane is read once and only the classification map
+ * is written back before hysteresis. Uses NEON on ARM, scalar code elsewhere.
+ */
+class FusedCanny {
+public:
+    FusedCanny();
+
+    /**
+     * Smallest frames handled by the fused path; callers fall back to OpenCV below this
+     */
+    static bool supports(int width, int height) { return width >= 16 && height >= 5; }
+
+    void run(const cv::Mat& gray, cv::Mat& edges, double lowThreshold, double highThreshold);
+
+private:
+    void allocate(int width, int height);
+
+    int width;
+    int height;
+
+    // Row rings: horizontal blur (5 rows), full blur (3), Sobel and magnitude (3)
+    std::vector<uint8_t> horizontalRows;
+    std::vector<uint8_t> blurredRows;
+    std::vector<int16_t> dxRows;
+    std::vector<int16_t> dyRows;
+    std::vector<int> magnitudeRows;
+    std::vector<int> zeroRow;
+
+    cv::Mat classMap;
+    std::vector<int> stack;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_NEON_CANNY_H
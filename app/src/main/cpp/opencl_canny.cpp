@@ -0,0 +1,83 @@
+#include "opencl_canny.h"
+#include <android/log.h>
+#include <cstdio>
+#include <mutex>
+
+#define LOG_TAG "OpenClCanny"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+std::once_flag g_probeOnce;
+bool g_available = false;
+std::string g_deviceName;
+
+void probeDevice() {
+    try {
+        g_available = cv::ocl::haveOpenCL();
+        if (g_available) {
+            cv::ocl::setUseOpenCL(true);
+            g_available = cv::ocl::useOpenCL();
+        }
+        if (g_available) {
+            g_deviceName = cv::ocl::Device::getDefault().name();
+            // Reported inside JSON stats
+            for (char& c : g_deviceName) {
+                if (c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) {
+                    c = ' ';
+                }
+            }
+        }
+    } catch (const cv::Exception& e) {
+        LOGE("OpenCL probe failed: %s", e.what());
+        g_available = false;
+    }
+    LOGD("OpenCL %s %s", g_available ? "available:" : "unavailable", g_deviceName.c_str());
+}
+
+} // namespace
+
+bool OpenClCanny::available() {
+    std::call_once(g_probeOnce, probeDevice);
+    return g_available;
+}
+
+std::string OpenClCanny::deviceName() {
+    std::call_once(g_probeOnce, probeDevice);
+    return g_deviceName;
+}
+
+void OpenClCanny::run(const cv::Mat& gray, cv::Mat& edges, double lowThreshold, double highThreshold) {
+    // Per-thread switch: the probe enabled it on whichever thread asked first
+    cv::ocl::setUseOpenCL(true);
+
+    // copyTo only reallocates the device buffers when the frame size changes
+    gray.copyTo(input);
+    cv::GaussianBlur(input, blurred, cv::Size(5, 5), 1.5);
+    cv::Canny(blurred, output, lowThreshold, highThreshold, 3);
+
+    // The download waits for the queue; edges is a caller-owned header, filled in place
+    output.copyTo(edges);
+}
+
+void OpenClCanny::detect(const cv::Mat& blurredGray, cv::Mat& edges, double lowThreshold, double highThreshold) {
+    cv::ocl::setUseOpenCL(true);
+    blurredGray.copyTo(blurred);
+    cv::Canny(blurred, output, lowThreshold, highThreshold, 3);
+    output.copyTo(edges);
+}
+
+std::string BackendProbe::toJson() const {
+    char buffer[320];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"openClAvailable\":%s,\"device\":\"%s\",\"width\":%d,\"height\":%d"
+                  ",\"cpuMode\":%d,\"cpuUs\":%.0f,\"openClUs\":%.0f,\"selectedMode\":%d}",
+                  openClAvailable ? "true" : "false", device.c_str(), width, height,
+                  cpuMode, cpuUs, openClUs, selectedMode);
+    return buffer;
+}
+
+} // namespace edgevision
@@ -0,0 +1,65 @@
+#ifndef EDGEVISION_OPENCL_CANNY_H
+#define EDGEVISION_OPENCL_CANNY_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+
+namespace edgevision {
+
+/**
+ * 5x5 Gaussian + Canny through OpenCV's transparent API (cv::UMat), so they run as
+ * OpenCL kernels on the GPU when the driver supports it.
+ *
+ * The device-side input, blur and edge buffers persist across frames; per frame there
+ * is one upload and one download, and only a size change reallocates. The first call
+ * compiles OpenCV's kernels, which can take hundreds of milliseconds. Use from one
+ * thread: OpenCV keeps the OpenCL queue and the setUseOpenCL switch per thread, so every
+ * call turns OpenCL on for the thread it runs on.
+ */
+class OpenClCanny {
+public:
+    /**
+     * Whether OpenCV has a usable OpenCL device (probed once, then cached)
+     */
+    static bool available();
+
+    /**
+     * Name of the OpenCL device, empty without one
+     */
+    static std::string deviceName();
+
+    /**
+     * Same output as the CPU CannyPipeline; blocks until edges holds the result
+     */
+    void run(const cv::Mat& gray, cv::Mat& edges, double lowThreshold, double highThreshold);
+
+    /**
+     * Canny alone on an already blurred frame (FramePipeline's detect stage)
+     */
+    void detect(const cv::Mat& blurredGray, cv::Mat& edges, double lowThreshold, double highThreshold);
+
+private:
+    cv::UMat input;
+    cv::UMat blurred;
+    cv::UMat output;
+};
+
+/**
+ * CPU vs OpenCL timing from EdgeProcessor::probeBackends at one resolution
+ */
+struct BackendProbe {
+    bool openClAvailable = false;
+    std::string device;
+    int width = 0;
+    int height = 0;
+    int cpuMode = 0;            // ExecutionMode the OpenCL path was compared against
+    double cpuUs = 0.0;         // Median Canny time per frame
+    double openClUs = 0.0;      // 0 when OpenCL is unavailable
+    int selectedMode = 0;
+
+    std::string toJson() const;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_OPENCL_CANNY_H
@@ -0,0 +1,78 @@
+#include "output_pyramid.h"
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace edgevision {
+
+void downscale2x(const cv::Mat& src, cv::Mat& dst, bool binary) {
+    const int width = src.cols / 2;
+    const int height = src.rows / 2;
+    dst.create(height, width, CV_8UC1);
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* top = src.ptr<uint8_t>(2 * y);
+        const uint8_t* bottom = src.ptr<uint8_t>(2 * y + 1);
+        uint8_t* out = dst.ptr<uint8_t>(y);
+
+        int x = 0;
+        if (binary) {
+#if defined(__ARM_NEON)
+            for (; x + 16 <= width; x += 16) {
+                // Even/odd columns deinterleaved, so each lane holds one 2x2 block
+                const uint8x16x2_t a = vld2q_u8(top + 2 * x);
+                const uint8x16x2_t b = vld2q_u8(bottom + 2 * x);
+                vst1q_u8(out + x, vmaxq_u8(vmaxq_u8(a.val[0], a.val[1]), vmaxq_u8(b.val[0], b.val[1])));
+            }
+#endif
+            for (; x < width; ++x) {
+                out[x] = std::max(std::max(top[2 * x], top[2 * x + 1]),
+                                  std::max(bottom[2 * x], bottom[2 * x + 1]));
+            }
+        } else {
+#if defined(__ARM_NEON)
+            for (; x + 8 <= width; x += 8) {
+                // Pairwise sums per row, then both rows, divided by 4 with rounding
+                const uint16x8_t sum = vaddq_u16(vpaddlq_u8(vld1q_u8(top + 2 * x)),
+                                                 vpaddlq_u8(vld1q_u8(bottom + 2 * x)));
+                vst1_u8(out + x, vrshrn_n_u16(sum, 2));
+            }
+#endif
+            for (; x < width; ++x) {
+                const int sum = top[2 * x] + top[2 * x + 1] + bottom[2 * x] + bottom[2 * x + 1];
+                out[x] = static_cast<uint8_t>((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+OutputPyramid::OutputPyramid()
+    : currentFrameId(-1)
+    , currentData(nullptr)
+    , builtLevels(0)
+    , isBinary(false)
+{
+}
+
+void OutputPyramid::setFrame(const cv::Mat& frame, int64_t frameId, bool binary) {
+    if (frameId == currentFrameId && frame.data == currentData && binary == isBinary) {
+        return;
+    }
+    levels[0] = frame;
+    currentFrameId = frameId;
+    currentData = frame.data;
+    isBinary = binary;
+    builtLevels = 1;
+}
+
+const cv::Mat& OutputPyramid::level(int level) {
+    level = std::min(std::max(level, 0), kLevels - 1);
+    for (; builtLevels <= level; ++builtLevels) {
+        downscale2x(levels[builtLevels - 1], levels[builtLevels], isBinary);
+    }
+    return levels[level];
+}
+
+} // namespace edgevision
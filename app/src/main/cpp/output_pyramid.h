@@ -0,0 +1,49 @@
+#ifndef EDGEVISION_OUTPUT_PYRAMID_H
+#define EDGEVISION_OUTPUT_PYRAMID_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+namespace edgevision {
+
+/**
+ * Halve a CV_8UC1 Mat in both directions (odd trailing row/column dropped). Binary edge
+ * maps take the max of each 2x2 block so one-pixel edges survive; gray output takes the
+ * rounded mean. NEON where available.
+ */
+void downscale2x(const cv::Mat& src, cv::Mat& dst, bool binary);
+
+/**
+ * Reduced copies of one processed frame for viewers that subscribed to a smaller stream.
+ *
+ * Level 0 is the frame itself (wrapped, not copied), level n is 1/2^n per side, each built
+ * from the level above it. A level is only built when first requested for a frame, and
+ * then shared by every client at that level. Not thread-safe.
+ */
+class OutputPyramid {
+public:
+    static constexpr int kLevels = 3;   // Full, 1/2, 1/4 resolution
+
+    OutputPyramid();
+
+    /**
+     * Start a new frame; frameId tells repeated calls for the same frame apart from new ones
+     */
+    void setFrame(const cv::Mat& frame, int64_t frameId, bool binary);
+
+    /**
+     * Level of the current frame (clamped to kLevels - 1), building it if needed
+     */
+    const cv::Mat& level(int level);
+
+private:
+    cv::Mat levels[kLevels];
+    int64_t currentFrameId;
+    const uint8_t* currentData;
+    int builtLevels;
+    bool isBinary;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_OUTPUT_PYRAMID_H
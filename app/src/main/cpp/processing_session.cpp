@@ -0,0 +1,61 @@
+#include "processing_session.h"
+#include "cpu_topology.h"
+#include <android/log.h>
+
+#define LOG_TAG "ProcessingSession"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+const std::vector<int>& coresFor(int affinity) {
+    const CpuTopology& topology = CpuTopology::get();
+    if (affinity == AFFINITY_LITTLE && !topology.littleCores().empty()) {
+        return topology.littleCores();
+    }
+    return topology.bigCores();
+}
+
+} // namespace
+
+SessionScope::SessionScope(ProcessingSession& session)
+    : guard(session.lock)
+    , restoreMask(false)
+{
+    // AFFINITY_ANY leaves the caller's own mask alone
+    const int affinity = session.affinity;
+    if (affinity == AFFINITY_ANY || !CpuTopology::saveCurrentThread(previousMask)) {
+        return;
+    }
+    restoreMask = CpuTopology::pinCurrentThread(coresFor(affinity));
+}
+
+SessionScope::~SessionScope() {
+    if (restoreMask) {
+        CpuTopology::restoreCurrentThread(previousMask);
+    }
+}
+
+ProcessingSession::ProcessingSession()
+    : affinity(AFFINITY_ANY)
+{
+}
+
+SessionScope ProcessingSession::enter() {
+    return SessionScope(*this);
+}
+
+void ProcessingSession::setAffinity(int newAffinity) {
+    if (newAffinity != AFFINITY_ANY && newAffinity != AFFINITY_BIG && newAffinity != AFFINITY_LITTLE) {
+        LOGE("Unknown core affinity %d, keeping %d", newAffinity, affinity);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    affinity = newAffinity;
+    LOGD("Core affinity: %d", affinity);
+}
+
+} // namespace edgevision
@@ -0,0 +1,77 @@
+#ifndef EDGEVISION_PROCESSING_SESSION_H
+#define EDGEVISION_PROCESSING_SESSION_H
+
+#include <sched.h>
+#include <mutex>
+#include "edge_processor.h"
+#include "frame_governor.h"
+
+namespace edgevision {
+
+/**
+ * Cores a session's calls run on (mirrors NativeProcessor.AFFINITY_*)
+ */
+enum CoreAffinity : int {
+    AFFINITY_ANY = 0,       // Leave scheduling to the kernel
+    AFFINITY_BIG = 1,       // Big cluster (every core on homogeneous SoCs)
+    AFFINITY_LITTLE = 2     // Little cluster, falls back to big when there is none
+};
+
+class ProcessingSession;
+
+/**
+ * One call's hold on a session: the session lock, and the calling thread's affinity from
+ * before the call, restored when the scope ends so JNI callers are not left pinned
+ */
+class SessionScope {
+public:
+    explicit SessionScope(ProcessingSession& session);
+    ~SessionScope();
+
+    SessionScope(const SessionScope&) = delete;
+    SessionScope& operator=(const SessionScope&) = delete;
+
+private:
+    std::unique_lock<std::mutex> guard;
+    cpu_set_t previousMask;
+    bool restoreMask;
+};
+
+/**
+ * One independent processing stream behind a NativeProcessor.create() handle.
+ *
+ * Each session owns its EdgeProcessor, so scratch buffers and settings are never shared
+ * between streams; calls on the same session are serialized by its lock, calls on
+ * different sessions run concurrently.
+ */
+class ProcessingSession {
+public:
+    ProcessingSession();
+
+    /**
+     * Lock the session for one call and move the calling thread onto its cores until the
+     * returned scope ends
+     */
+    SessionScope enter();
+
+    EdgeProcessor& processor() { return edgeProcessor; }
+
+    /**
+     * Resolution / frame-skip decisions for this session's Canny calls
+     */
+    FrameGovernor& governor() { return frameGovernor; }
+
+    void setAffinity(int affinity);
+
+private:
+    friend class SessionScope;
+
+    std::mutex lock;
+    EdgeProcessor edgeProcessor;
+    FrameGovernor frameGovernor;
+    int affinity;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_PROCESSING_SESSION_H
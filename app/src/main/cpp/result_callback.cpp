@@ -0,0 +1,157 @@
+#include "result_callback.h"
+#include <android/log.h>
+#include <pthread.h>
+
+#define LOG_TAG "ResultCallback"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+JavaVM* g_javaVm = nullptr;
+
+// Stale entries only pile up when frame buffers are reallocated (restart at a new size)
+constexpr size_t kMaxCachedBuffers = 8;
+
+/**
+ * Per-thread JNIEnv; threads attached here are detached again when they exit
+ */
+struct ThreadEnv {
+    JNIEnv* env = nullptr;
+    bool attached = false;
+
+    ~ThreadEnv() {
+        if (attached && g_javaVm != nullptr) {
+            g_javaVm->DetachCurrentThread();
+        }
+    }
+};
+
+thread_local ThreadEnv t_threadEnv;
+
+JNIEnv* currentEnv() {
+    if (t_threadEnv.env != nullptr) {
+        return t_threadEnv.env;
+    }
+    if (g_javaVm == nullptr) {
+        LOGE("JavaVM not cached, JNI_OnLoad did not run");
+        return nullptr;
+    }
+
+    JNIEnv* env = nullptr;
+    if (g_javaVm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        // Already a Java thread; it owns its own attachment
+        t_threadEnv.env = env;
+        return env;
+    }
+
+    char name[16] = "ev-native";
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    JavaVMAttachArgs args{JNI_VERSION_1_6, name, nullptr};
+    if (g_javaVm->AttachCurrentThread(&env, &args) != JNI_OK) {
+        LOGE("Failed to attach thread %s", name);
+        return nullptr;
+    }
+
+    LOGD("Attached thread %s", name);
+    t_threadEnv.env = env;
+    t_threadEnv.attached = true;
+    return env;
+}
+
+} // namespace
+
+void ResultCallback::setJavaVm(JavaVM* vm) {
+    g_javaVm = vm;
+}
+
+bool ResultCallback::setListener(JNIEnv* env, jobject newListener) {
+    releaseBuffers(env);
+    if (listener != nullptr) {
+        env->DeleteGlobalRef(listener);
+        listener = nullptr;
+        onFrameProcessed = nullptr;
+    }
+
+    if (newListener == nullptr) {
+        return true;
+    }
+
+    jclass listenerClass = env->GetObjectClass(newListener);
+    jmethodID method = env->GetMethodID(listenerClass, "onFrameProcessed", "(Ljava/nio/ByteBuffer;IIJ)V");
+    env->DeleteLocalRef(listenerClass);
+    if (method == nullptr) {
+        // GetMethodID left a NoSuchMethodError pending for the caller
+        LOGE("Listener has no onFrameProcessed(ByteBuffer, int, int, long)");
+        return false;
+    }
+
+    listener = env->NewGlobalRef(newListener);
+    onFrameProcessed = method;
+    return true;
+}
+
+void ResultCallback::deliver(const cv::Mat& frame, int64_t timestampNs) {
+    if (listener == nullptr) {
+        return;
+    }
+    if (!frame.isContinuous()) {
+        LOGE("Cannot wrap a non-continuous %dx%d frame", frame.cols, frame.rows);
+        return;
+    }
+
+    JNIEnv* env = currentEnv();
+    if (env == nullptr) {
+        return;
+    }
+
+    jobject buffer = bufferFor(env, frame);
+    if (buffer == nullptr) {
+        return;
+    }
+
+    env->CallVoidMethod(listener, onFrameProcessed, buffer, static_cast<jint>(frame.cols),
+                        static_cast<jint>(frame.rows), static_cast<jlong>(timestampNs));
+    if (env->ExceptionCheck()) {
+        // Nothing on a native thread would ever see it; log and keep the pipeline running
+        LOGE("Exception thrown by onFrameProcessed");
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+jobject ResultCallback::bufferFor(JNIEnv* env, const cv::Mat& frame) {
+    const size_t size = frame.total() * frame.elemSize();
+    for (const auto& cached : buffers) {
+        if (cached.data == frame.data && cached.size == size) {
+            return cached.buffer;
+        }
+    }
+
+    if (buffers.size() >= kMaxCachedBuffers) {
+        releaseBuffers(env);
+    }
+
+    jobject local = env->NewDirectByteBuffer(frame.data, static_cast<jlong>(size));
+    if (local == nullptr) {
+        LOGE("Failed to wrap frame in a direct ByteBuffer");
+        env->ExceptionClear();
+        return nullptr;
+    }
+    jobject global = env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+
+    buffers.push_back({frame.data, size, global});
+    return global;
+}
+
+void ResultCallback::releaseBuffers(JNIEnv* env) {
+    for (const auto& cached : buffers) {
+        env->DeleteGlobalRef(cached.buffer);
+    }
+    buffers.clear();
+}
+
+} // namespace edgevision
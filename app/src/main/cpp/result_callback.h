@@ -0,0 +1,53 @@
+#ifndef EDGEVISION_RESULT_CALLBACK_H
+#define EDGEVISION_RESULT_CALLBACK_H
+
+#include <jni.h>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace edgevision {
+
+/**
+ * Delivers pipeline results to a Kotlin NativeProcessor.ResultListener from native threads.
+ *
+ * The JavaVM is cached in JNI_OnLoad and the listener's jmethodID when it is set, so a
+ * delivery is one CallVoidMethod. Calling threads are attached on first use and detached
+ * when they exit. Direct ByteBuffers are cached per frame buffer, so the pipeline's fixed
+ * slots do not allocate a Java object per frame.
+ */
+class ResultCallback {
+public:
+    static void setJavaVm(JavaVM* vm);
+
+    /**
+     * Replace the listener (nullptr clears it). Must not race deliver(), i.e. only
+     * call while the producing pipeline is stopped.
+     */
+    bool setListener(JNIEnv* env, jobject listener);
+
+    bool hasListener() const { return listener != nullptr; }
+
+    /**
+     * Invoke onFrameProcessed on the calling thread; the ByteBuffer wraps frame.data and
+     * is only valid for the duration of the call
+     */
+    void deliver(const cv::Mat& frame, int64_t timestampNs);
+
+private:
+    struct CachedBuffer {
+        const uint8_t* data;
+        size_t size;
+        jobject buffer;    // Global ref to a direct ByteBuffer over data
+    };
+
+    jobject bufferFor(JNIEnv* env, const cv::Mat& frame);
+    void releaseBuffers(JNIEnv* env);
+
+    jobject listener = nullptr;
+    jmethodID onFrameProcessed = nullptr;
+    std::vector<CachedBuffer> buffers;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_RESULT_CALLBACK_H
@@ -0,0 +1,68 @@
+#ifndef EDGEVISION_SPSC_RING_H
+#define EDGEVISION_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace edgevision {
+
+/**
+ * Bounded lock-free single-producer/single-consumer ring buffer.
+ * Capacity must be a power of two; all Capacity slots are usable.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    /**
+     * Producer side: returns false if the ring is full
+     */
+    bool tryPush(const T& value) {
+        const size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items[currentTail & (Capacity - 1)] = value;
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side: returns false if the ring is empty
+     */
+    bool tryPop(T& value) {
+        const size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = items[currentHead & (Capacity - 1)];
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Drop all items; only safe while neither side is active
+     */
+    void reset() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // Keep producer and consumer indices on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) T items[Capacity];
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_SPSC_RING_H
@@ -0,0 +1,196 @@
+#ifndef EDGEVISION_STAGE_PIPELINE_H
+#define EDGEVISION_STAGE_PIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include "metrics.h"
+#include <algorithm>
+
+namespace edgevision {
+namespace stages {
+
+/**
+ * Runtime parameters shared by every stage; kernel sizes are template arguments instead,
+ * so they are constants in each instantiation
+ */
+struct StageParams {
+    double threshold1 = 50.0;   // Canny low threshold / binary threshold level
+    double threshold2 = 150.0;  // Canny high threshold
+};
+
+/**
+ * Intermediate buffers for one pipeline user, grown by prepare() and reused across frames.
+ * Stages write into headers over them (see scratchView), so ROIs of any size never
+ * reallocate.
+ */
+struct StageScratch {
+    cv::Mat buffers[2];     // CV_8UC1 ping-pong between stages
+    cv::Mat gradX;          // CV_16S derivatives
+    cv::Mat gradY;
+    cv::Mat gradAbs;        // CV_8UC1 |dx| before it is added to |dy|
+
+    /**
+     * Grow every buffer to at least width x height. Call outside any FrameArena scope:
+     * Mats created inside one are scratch.
+     */
+    void prepare(int width, int height) {
+        if (buffers[0].cols >= width && buffers[0].rows >= height) {
+            return;
+        }
+        width = std::max(width, buffers[0].cols);
+        height = std::max(height, buffers[0].rows);
+        buffers[0].create(height, width, CV_8UC1);
+        buffers[1].create(height, width, CV_8UC1);
+        gradX.create(height, width, CV_16S);
+        gradY.create(height, width, CV_16S);
+        gradAbs.create(height, width, CV_8UC1);
+    }
+};
+
+/**
+ * Continuous like-sized header at the start of a scratch buffer. It has no parent, unlike
+ * an ROI of the buffer, so the next stage replicates the border at its edges instead of
+ * reading stale pixels left over from a larger frame.
+ */
+inline cv::Mat scratchView(cv::Mat& buffer, const cv::Mat& like) {
+    CV_Assert(buffer.cols >= like.cols && buffer.rows >= like.rows);
+    return cv::Mat(like.rows, like.cols, buffer.type(), buffer.data);
+}
+
+/**
+ * Pass the frame through unchanged (grayscale output)
+ */
+struct Gray {
+    static constexpr int kHalo = 0;
+    static constexpr metrics::Stage kStage = metrics::STAGE_COPY_OUT;
+
+    static void apply(const cv::Mat& src, cv::Mat& dst, const StageParams&, StageScratch&) {
+        src.copyTo(dst);
+    }
+};
+
+/**
+ * KxK Gaussian blur with sigma 0.3 * K (1.5 for the 5x5 kernel Canny uses)
+ */
+template <int K>
+struct Blur {
+    static_assert(K % 2 == 1 && K >= 3, "Blur kernel must be odd and at least 3");
+    static constexpr int kHalo = K / 2;
+    static constexpr metrics::Stage kStage = metrics::STAGE_BLUR;
+
+    static void apply(const cv::Mat& src, cv::Mat& dst, const StageParams&, StageScratch&) {
+        cv::GaussianBlur(src, dst, cv::Size(K, K), 0.3 * K);
+    }
+};
+
+/**
+ * Canny with a fixed Sobel aperture, thresholds from StageParams
+ */
+template <int Aperture>
+struct Canny {
+    static_assert(Aperture == 3 || Aperture == 5 || Aperture == 7, "Canny aperture must be 3, 5 or 7");
+    static constexpr int kHalo = Aperture / 2;
+    static constexpr metrics::Stage kStage = metrics::STAGE_CANNY;
+
+    static void apply(const cv::Mat& src, cv::Mat& dst, const StageParams& params, StageScratch&) {
+        cv::Canny(src, dst, params.threshold1, params.threshold2, Aperture);
+    }
+};
+
+/**
+ * Gradient magnitude approximated as |dx| + |dy| (saturated), KxK Sobel kernels
+ */
+template <int K>
+struct Sobel {
+    static_assert(K == 1 || K == 3 || K == 5 || K == 7, "Sobel kernel must be 1, 3, 5 or 7");
+    static constexpr int kHalo = K / 2 > 0 ? K / 2 : 1;
+    static constexpr metrics::Stage kStage = metrics::STAGE_CANNY;
+
+    static void apply(const cv::Mat& src, cv::Mat& dst, const StageParams&, StageScratch& scratch) {
+        cv::Mat gradX = scratchView(scratch.gradX, src);
+        cv::Mat gradY = scratchView(scratch.gradY, src);
+        cv::Mat gradAbs = scratchView(scratch.gradAbs, src);
+        cv::Sobel(src, gradX, CV_16S, 1, 0, K);
+        cv::Sobel(src, gradY, CV_16S, 0, 1, K);
+        cv::convertScaleAbs(gradX, gradAbs);
+        cv::convertScaleAbs(gradY, dst);
+        cv::add(dst, gradAbs, dst);
+    }
+};
+
+/**
+ * Absolute Laplacian response, KxK aperture
+ */
+template <int K>
+struct Laplacian {
+    static_assert(K == 1 || K == 3 || K == 5 || K == 7, "Laplacian kernel must be 1, 3, 5 or 7");
+    static constexpr int kHalo = K / 2 > 0 ? K / 2 : 1;
+    static constexpr metrics::Stage kStage = metrics::STAGE_CANNY;
+
+    static void apply(const cv::Mat& src, cv::Mat& dst, const StageParams&, StageScratch& scratch) {
+        cv::Mat response = scratchView(scratch.gradX, src);
+        cv::Laplacian(src, response, CV_16S, K);
+        cv::convertScaleAbs(response, dst);
+    }
+};
+
+/**
+ * Binary 0/255 map of pixels brighter than StageParams::threshold1
+ */
+struct Threshold {
+    static constexpr int kHalo = 0;
+    static constexpr metrics::Stage kStage = metrics::STAGE_CANNY;
+
+    static void apply(const cv::Mat& src, cv::Mat& dst, const StageParams& params, StageScratch&) {
+        cv::threshold(src, dst, params.threshold1, 255, cv::THRESH_BINARY);
+    }
+};
+
+/**
+ * Stages run in order, each timed under its own metrics stage. Intermediates alternate
+ * between the two scratch buffers and the last stage writes straight into dst, so a
+ * pipeline of N stages touches N - 1 scratch images. All stages take and produce CV_8UC1.
+ *
+ *   using CannyPipeline = Pipeline<Blur<5>, Canny<3>>;
+ *   CannyPipeline::run(gray, edges, params, scratch);
+ */
+template <typename... Stages>
+struct Pipeline {
+    static_assert(sizeof...(Stages) > 0, "Pipeline needs at least one stage");
+
+    // Rows/columns past an ROI edge the whole chain can read
+    static constexpr int kHalo = (0 + ... + Stages::kHalo);
+
+    /**
+     * Run every stage; scratch must have been prepare()d for src's size
+     */
+    static void run(const cv::Mat& src, cv::Mat& dst, const StageParams& params, StageScratch& scratch) {
+        runFrom<0, Stages...>(src, dst, params, scratch);
+    }
+
+private:
+    template <int Index, typename First, typename... Rest>
+    static void runFrom(const cv::Mat& src, cv::Mat& dst, const StageParams& params, StageScratch& scratch) {
+        if constexpr (sizeof...(Rest) == 0) {
+            metrics::ScopedTimer timer(First::kStage);
+            First::apply(src, dst, params, scratch);
+        } else {
+            cv::Mat out = scratchView(scratch.buffers[Index % 2], src);
+            {
+                metrics::ScopedTimer timer(First::kStage);
+                First::apply(src, out, params, scratch);
+            }
+            runFrom<Index + 1, Rest...>(out, dst, params, scratch);
+        }
+    }
+};
+
+/**
+ * Type-erased entry point of one instantiation, so callers can pick a pipeline at
+ * configuration time and call it per frame without re-dispatching
+ */
+using PipelineFn = void (*)(const cv::Mat& src, cv::Mat& dst, const StageParams& params, StageScratch& scratch);
+
+} // namespace stages
+} // namespace edgevision
+
+#endif // EDGEVISION_STAGE_PIPELINE_H
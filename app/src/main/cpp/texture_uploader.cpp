@@ -0,0 +1,195 @@
+#include "texture_uploader.h"
+#include "metrics.h"
+#include <android/log.h>
+#include <cstring>
+#include <thread>
+
+#define LOG_TAG "TextureUploader"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+TextureUploader::TextureUploader()
+    : enabled(false)
+    , frameWidth(0)
+    , frameHeight(0)
+    , writingSlot(-1)
+    , nextSequence(0)
+{
+}
+
+bool TextureUploader::initialize(int width, int height) {
+    if (slots[0].buffer != 0) {
+        // A new context means the old buffers (and their mappings) are already gone
+        abandon();
+    }
+
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (version == nullptr || std::strncmp(version, "OpenGL ES 3", 11) != 0) {
+        LOGI("Pixel buffer objects unavailable (%s)", version != nullptr ? version : "no context");
+        return false;
+    }
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid upload size: %dx%d", width, height);
+        return false;
+    }
+
+    frameWidth = width;
+    frameHeight = height;
+
+    for (Slot& slot : slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(getFrameBytes()), nullptr, GL_STREAM_DRAW);
+        slot.state.store(SLOT_FREE, std::memory_order_relaxed);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    mapFreeSlots();
+    if (glGetError() != GL_NO_ERROR) {
+        LOGE("Failed to create pixel buffer ring");
+        release();
+        return false;
+    }
+
+    enabled.store(true, std::memory_order_release);
+    LOGI("Pixel buffer ring ready: %d x %dx%d", kSlotCount, width, height);
+    return true;
+}
+
+void TextureUploader::mapFreeSlots() {
+    for (Slot& slot : slots) {
+        if (slot.state.load(std::memory_order_acquire) != SLOT_FREE) {
+            continue;
+        }
+
+        // Invalidating lets the driver hand out fresh storage instead of waiting on the last upload
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        slot.mapped = static_cast<uint8_t*>(glMapBufferRange(
+                GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(getFrameBytes()),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (slot.mapped != nullptr) {
+            slot.state.store(SLOT_MAPPED, std::memory_order_release);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+bool TextureUploader::update(GLuint texture) {
+    if (!isReady()) {
+        return false;
+    }
+
+    // Newest published frame wins; older ones are unmapped and recycled unseen
+    Slot* newest = nullptr;
+    for (Slot& slot : slots) {
+        if (slot.state.load(std::memory_order_acquire) != SLOT_READY) {
+            continue;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        slot.mapped = nullptr;
+        if (newest == nullptr || slot.sequence > newest->sequence) {
+            if (newest != nullptr) {
+                newest->state.store(SLOT_FREE, std::memory_order_release);
+            }
+            newest = &slot;
+        } else {
+            slot.state.store(SLOT_FREE, std::memory_order_release);
+        }
+    }
+
+    if (newest != nullptr) {
+        metrics::ScopedTimer timer(metrics::STAGE_UPLOAD);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, newest->buffer);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frameWidth, frameHeight,
+                        GL_LUMINANCE, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        newest->state.store(SLOT_FREE, std::memory_order_release);
+    }
+
+    // Leaving a PBO bound would turn client-memory uploads elsewhere into buffer offsets
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    mapFreeSlots();
+    return newest != nullptr;
+}
+
+uint8_t* TextureUploader::acquire() {
+    if (!isReady() || writingSlot >= 0) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < kSlotCount; ++i) {
+        int expected = SLOT_MAPPED;
+        if (slots[i].state.compare_exchange_strong(expected, SLOT_WRITING, std::memory_order_acq_rel)) {
+            writingSlot = i;
+            return slots[i].mapped;
+        }
+    }
+    return nullptr;
+}
+
+void TextureUploader::publish(bool written) {
+    if (writingSlot < 0) {
+        return;
+    }
+
+    Slot& slot = slots[writingSlot];
+    writingSlot = -1;
+    if (written) {
+        slot.sequence = ++nextSequence;
+        slot.state.store(SLOT_READY, std::memory_order_release);
+    } else {
+        slot.state.store(SLOT_MAPPED, std::memory_order_release);
+    }
+}
+
+void TextureUploader::reclaimSlots() {
+    enabled.store(false, std::memory_order_release);
+
+    for (Slot& slot : slots) {
+        // Claim the slot back from the producer; a write in progress is allowed to finish
+        int state = slot.state.load(std::memory_order_acquire);
+        while (state == SLOT_WRITING ||
+               !slot.state.compare_exchange_weak(state, SLOT_FREE, std::memory_order_acq_rel)) {
+            if (state == SLOT_WRITING) {
+                std::this_thread::yield();
+                state = slot.state.load(std::memory_order_acquire);
+            }
+        }
+    }
+}
+
+void TextureUploader::release() {
+    reclaimSlots();
+
+    for (Slot& slot : slots) {
+        if (slot.buffer != 0) {
+            if (slot.mapped != nullptr) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            glDeleteBuffers(1, &slot.buffer);
+        }
+        slot.buffer = 0;
+        slot.mapped = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    LOGD("Pixel buffer ring released");
+}
+
+void TextureUploader::abandon() {
+    reclaimSlots();
+
+    for (Slot& slot : slots) {
+        slot.buffer = 0;
+        slot.mapped = nullptr;
+    }
+    LOGD("Pixel buffer ring abandoned with its context");
+}
+
+} // namespace edgevision
@@ -0,0 +1,96 @@
+#ifndef EDGEVISION_TEXTURE_UPLOADER_H
+#define EDGEVISION_TEXTURE_UPLOADER_H
+
+#include <GLES3/gl3.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace edgevision {
+
+/**
+ * Ring of GLES 3.0 pixel unpack buffers that the processor writes into directly.
+ *
+ * The GL thread keeps free slots mapped; a producer thread claims a mapped slot, writes
+ * a frame into it and publishes it. On the next draw the GL thread unmaps the newest
+ * published slot and sources glTexSubImage2D from the PBO, so the copy into the texture
+ * is done by the driver instead of stalling on client memory.
+ *
+ * initialize/update/release must be called on the GL thread, acquire/publish on a single
+ * producer thread.
+ */
+class TextureUploader {
+public:
+    TextureUploader();
+
+    /**
+     * Create the PBO ring for width x height GL_LUMINANCE frames.
+     * Returns false when the context is not GLES 3.0+.
+     */
+    bool initialize(int width, int height);
+
+    /**
+     * Upload the newest published frame into texture and re-map consumed slots.
+     * Returns true if the texture changed.
+     */
+    bool update(GLuint texture);
+
+    /**
+     * Unmap and delete the ring (waits for an in-progress write to finish)
+     */
+    void release();
+
+    /**
+     * Forget GL objects without touching GL, for when the context has been lost
+     */
+    void abandon();
+
+    bool isReady() const { return enabled.load(std::memory_order_acquire); }
+    int getWidth() const { return frameWidth; }
+    int getHeight() const { return frameHeight; }
+    size_t getFrameBytes() const { return static_cast<size_t>(frameWidth) * frameHeight; }
+
+    /**
+     * Claim a mapped slot for writing; nullptr if none is mapped right now
+     */
+    uint8_t* acquire();
+
+    /**
+     * Finish the slot returned by acquire(); written=false returns it unused
+     */
+    void publish(bool written);
+
+private:
+    static constexpr int kSlotCount = 3;
+
+    enum SlotState : int {
+        SLOT_FREE = 0,      // Unmapped, owned by the GL thread
+        SLOT_MAPPED = 1,    // Mapped and waiting for a producer
+        SLOT_WRITING = 2,   // Being filled by the producer
+        SLOT_READY = 3      // Filled, waiting to be unmapped and uploaded
+    };
+
+    struct Slot {
+        GLuint buffer = 0;
+        uint8_t* mapped = nullptr;
+        uint64_t sequence = 0;
+        std::atomic<int> state{SLOT_FREE};
+    };
+
+    void mapFreeSlots();
+
+    // Disable the ring and take every slot back from the producer
+    void reclaimSlots();
+
+    std::array<Slot, kSlotCount> slots;
+    std::atomic<bool> enabled;
+    int frameWidth;
+    int frameHeight;
+    int writingSlot;
+    uint64_t nextSequence;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_TEXTURE_UPLOADER_H
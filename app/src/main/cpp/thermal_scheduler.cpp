@@ -0,0 +1,199 @@
+#include "thermal_scheduler.h"
+#include "cpu_topology.h"
+#include <android/log.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#define LOG_TAG "ThermalScheduler"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+
+namespace {
+
+// AThermalStatus values from android/thermal.h
+constexpr int kStatusLight = 1;
+constexpr int kStatusModerate = 2;
+constexpr int kStatusSevere = 3;
+
+// Forecast headroom at which each level starts (1.0 = throttling begins)
+constexpr float kWarmHeadroom = 0.75f;
+constexpr float kHotHeadroom = 0.9f;
+constexpr float kCriticalHeadroom = 1.0f;
+
+// Indexed by ThermalLevel; steps are FrameGovernor steps (level 1 = 1/2, 2 = 1/4, 3 = 1/4 every 2nd)
+constexpr ThermalPolicy kPolicies[] = {
+    {THERMAL_NOMINAL, 0, false, false},
+    {THERMAL_WARM, 1, false, false},
+    {THERMAL_HOT, 2, true, true},
+    {THERMAL_CRITICAL, 3, true, true},
+};
+
+int levelForStatus(int status) {
+    if (status >= kStatusSevere) {
+        return THERMAL_CRITICAL;
+    }
+    if (status == kStatusModerate) {
+        return THERMAL_HOT;
+    }
+    return status == kStatusLight ? THERMAL_WARM : THERMAL_NOMINAL;
+}
+
+int levelForHeadroom(float headroom) {
+    if (headroom >= kCriticalHeadroom) {
+        return THERMAL_CRITICAL;
+    }
+    if (headroom >= kHotHeadroom) {
+        return THERMAL_HOT;
+    }
+    return headroom >= kWarmHeadroom ? THERMAL_WARM : THERMAL_NOMINAL;
+}
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ThermalScheduler::ThermalScheduler()
+    : acquireManager(nullptr)
+    , releaseManager(nullptr)
+    , getCurrentStatus(nullptr)
+    , getThermalHeadroom(nullptr)
+    , manager(nullptr)
+    , enabled(false)
+    , level(THERMAL_NOMINAL)
+    , lastPollMs(0)
+    , status(-1)
+    , headroom(-1.0f)
+    , calmPolls(0)
+    , levelChanges(0)
+{
+}
+
+ThermalScheduler::~ThermalScheduler() {
+    if (manager != nullptr && releaseManager != nullptr) {
+        releaseManager(manager);
+    }
+}
+
+bool ThermalScheduler::loadThermalApi() {
+    if (manager != nullptr) {
+        return true;
+    }
+
+    // libandroid is already loaded by every app process; this only looks the symbols up
+    void* library = dlopen("libandroid.so", RTLD_NOW | RTLD_NOLOAD);
+    if (library == nullptr) {
+        library = dlopen("libandroid.so", RTLD_NOW);
+    }
+    if (library == nullptr) {
+        return false;
+    }
+
+    acquireManager = reinterpret_cast<AcquireManagerFn>(dlsym(library, "AThermal_acquireManager"));
+    releaseManager = reinterpret_cast<ReleaseManagerFn>(dlsym(library, "AThermal_releaseManager"));
+    getCurrentStatus = reinterpret_cast<GetCurrentStatusFn>(dlsym(library, "AThermal_getCurrentStatus"));
+    getThermalHeadroom = reinterpret_cast<GetThermalHeadroomFn>(dlsym(library, "AThermal_getThermalHeadroom"));
+    if (acquireManager == nullptr || getCurrentStatus == nullptr) {
+        LOGD("AThermal unavailable (API < 30)");
+        return false;
+    }
+
+    manager = acquireManager();
+    if (manager == nullptr) {
+        LOGE("AThermal_acquireManager failed");
+        return false;
+    }
+    LOGD("AThermal ready, headroom forecast %s", getThermalHeadroom != nullptr ? "available" : "unavailable");
+    return true;
+}
+
+bool ThermalScheduler::setEnabled(bool enable) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (enable && !loadThermalApi()) {
+        enabled.store(false, std::memory_order_relaxed);
+        return false;
+    }
+
+    enabled.store(enable, std::memory_order_relaxed);
+    level.store(THERMAL_NOMINAL, std::memory_order_relaxed);
+    lastPollMs.store(0, std::memory_order_relaxed);
+    calmPolls = 0;
+    LOGD("Thermal scheduling %s", enable ? "enabled" : "disabled");
+    return true;
+}
+
+ThermalPolicy ThermalScheduler::poll() {
+    if (enabled.load(std::memory_order_relaxed)) {
+        // One caller per interval does the work; the rest only read the level
+        const int64_t now = nowMs();
+        int64_t last = lastPollMs.load(std::memory_order_relaxed);
+        if (now - last >= kPollIntervalMs
+                && lastPollMs.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> guard(lock);
+            evaluate();
+        }
+    }
+    return policy();
+}
+
+ThermalPolicy ThermalScheduler::policy() const {
+    return kPolicies[level.load(std::memory_order_relaxed)];
+}
+
+void ThermalScheduler::evaluate() {
+    if (manager == nullptr) {
+        return;
+    }
+
+    status = getCurrentStatus(manager);
+    if (getThermalHeadroom != nullptr) {
+        const float forecast = getThermalHeadroom(manager, kForecastSeconds);
+        // NaN when the platform has no forecast yet; keep the previous value
+        if (!std::isnan(forecast)) {
+            headroom = forecast;
+        }
+    }
+
+    const int current = level.load(std::memory_order_relaxed);
+    const int target = std::max(levelForStatus(status), headroom >= 0.0f ? levelForHeadroom(headroom) : 0);
+    int next = current;
+    if (target > current) {
+        next = target;
+        calmPolls = 0;
+    } else if (target < current) {
+        if (++calmPolls >= kCoolDownPolls) {
+            next = current - 1;
+            calmPolls = 0;
+        }
+    } else {
+        calmPolls = 0;
+    }
+
+    if (next != current) {
+        level.store(next, std::memory_order_relaxed);
+        ++levelChanges;
+        LOGD("Thermal level %d -> %d (status %d, headroom %.2f)", current, next, status, headroom);
+    }
+}
+
+std::string ThermalScheduler::toJson() const {
+    std::lock_guard<std::mutex> guard(lock);
+    const ThermalPolicy current = policy();
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"enabled\":%s,\"level\":%d,\"status\":%d,\"headroom\":%.3f,\"minimumStep\":%d"
+                  ",\"efficiencyCores\":%s,\"preferGpu\":%s,\"littleCores\":%d,\"changes\":%u}",
+                  isEnabled() ? "true" : "false", current.level, status, headroom, current.minimumStep,
+                  current.efficiencyCores ? "true" : "false", current.preferGpu ? "true" : "false",
+                  static_cast<int>(CpuTopology::get().littleCores().size()), levelChanges);
+    return buffer;
+}
+
+} // namespace edgevision
@@ -0,0 +1,103 @@
+#ifndef EDGEVISION_THERMAL_SCHEDULER_H
+#define EDGEVISION_THERMAL_SCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace edgevision {
+
+/**
+ * How hard the scheduler is backing off (mirrors NativeProcessor.THERMAL_*)
+ */
+enum ThermalLevel : int {
+    THERMAL_NOMINAL = 0,    // Full quality
+    THERMAL_WARM = 1,       // Heading for throttling: half resolution
+    THERMAL_HOT = 2,        // Close to throttling: quarter resolution on the little cores, GPU preferred
+    THERMAL_CRITICAL = 3    // Throttling: additionally process every 2nd frame
+};
+
+/**
+ * What callers apply for the current level
+ */
+struct ThermalPolicy {
+    int level;
+    int minimumStep;        // FrameGovernor::setMinimumStep floor
+    bool efficiencyCores;   // Pipeline blur/Canny stages on the little cluster
+    bool preferGpu;         // Hand Canny to the GLSL backend when the app has it
+};
+
+/**
+ * Steps processing down before the SoC throttles, rather than after frame times double.
+ *
+ * AThermal (API 30+, resolved with dlsym since minSdk is lower) provides the current
+ * status and, from API 31, a forecast of thermal headroom (1.0 = the point where the
+ * platform starts throttling). The level is the worse of the two, so a rising forecast
+ * reduces the load while the status is still nominal. Levels rise immediately and fall
+ * one at a time after kCoolDownPolls calm polls, so the output does not oscillate.
+ * Thread-safe; poll() is cheap enough to call per frame.
+ */
+class ThermalScheduler {
+public:
+    static constexpr int64_t kPollIntervalMs = 1000;    // Headroom is NaN if asked more often
+    static constexpr int kForecastSeconds = 10;
+    static constexpr int kCoolDownPolls = 10;
+
+    ThermalScheduler();
+    ~ThermalScheduler();
+
+    ThermalScheduler(const ThermalScheduler&) = delete;
+    ThermalScheduler& operator=(const ThermalScheduler&) = delete;
+
+    /**
+     * Start or stop following the thermal state; false if the device has no AThermal
+     * (the policy then stays nominal)
+     */
+    bool setEnabled(bool enabled);
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * Re-read the thermal state if kPollIntervalMs have passed; returns the policy to apply
+     */
+    ThermalPolicy poll();
+
+    /**
+     * Policy of the current level without polling
+     */
+    ThermalPolicy policy() const;
+
+    /**
+     * Level, inputs and policy as a JSON object
+     */
+    std::string toJson() const;
+
+private:
+    bool loadThermalApi();
+    void evaluate();
+
+    using AcquireManagerFn = void* (*)();
+    using ReleaseManagerFn = void (*)(void*);
+    using GetCurrentStatusFn = int (*)(void*);
+    using GetThermalHeadroomFn = float (*)(void*, int);
+
+    AcquireManagerFn acquireManager;
+    ReleaseManagerFn releaseManager;
+    GetCurrentStatusFn getCurrentStatus;
+    GetThermalHeadroomFn getThermalHeadroom;
+    void* manager;
+
+    std::atomic<bool> enabled;
+    std::atomic<int> level;
+    std::atomic<int64_t> lastPollMs;
+
+    mutable std::mutex lock;
+    int status;             // Last AThermalStatus, -1 unknown
+    float headroom;         // Last valid forecast, negative if unknown
+    int calmPolls;
+    uint32_t levelChanges;
+};
+
+} // namespace edgevision
+
+#endif // EDGEVISION_THERMAL_SCHEDULER_H
@@ -0,0 +1,184 @@
+#include "tile_delta.h"
+#include "edge_codec.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define LOG_TAG "TileDelta"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+namespace codec {
+
+namespace {
+
+constexpr size_t kPayloadHeaderSize = 8;
+constexpr size_t kTileHeaderSize = 4;
+constexpr size_t kTileRowBytes = TileDeltaEncoder::kTileSize / 8;
+
+inline void putU16(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline void putU32(uint8_t* out, uint32_t value) {
+    putU16(out, value);
+    putU16(out + 2, value >> 16);
+}
+
+// diff |= a ^ b over one packed row
+void accumulateDiff(const uint8_t* a, const uint8_t* b, uint8_t* diff, size_t length) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= length; i += 16) {
+        const uint8x16_t changed = veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        vst1q_u8(diff + i, vorrq_u8(vld1q_u8(diff + i), changed));
+    }
+#endif
+    for (; i < length; ++i) {
+        diff[i] |= a[i] ^ b[i];
+    }
+}
+
+} // namespace
+
+TileDeltaEncoder::TileDeltaEncoder()
+    : width(0)
+    , height(0)
+    , framesSinceKeyframe(0)
+    , keyframePending(true)
+{
+}
+
+size_t TileDeltaEncoder::maxPayloadSize(int width, int height) {
+    const size_t tiles = static_cast<size_t>((width + kTileSize - 1) / kTileSize) *
+                         ((height + kTileSize - 1) / kTileSize);
+    return kPayloadHeaderSize + tiles * kTileHeaderSize + packedRowBytes(width) * height;
+}
+
+void TileDeltaEncoder::reset(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    const size_t packedBytes = packedRowBytes(width) * height;
+    current.assign(packedBytes, 0);
+    previous.assign(packedBytes, 0);
+    bandDiff.assign(packedRowBytes(width), 0);
+    keyframePending = true;
+    LOGD("Tile delta state sized for %dx%d", width, height);
+}
+
+size_t TileDeltaEncoder::encode(const cv::Mat& edges, uint8_t* out, size_t capacity) {
+    if (edges.cols != width || edges.rows != height) {
+        reset(edges.cols, edges.rows);
+    }
+    if (capacity < kPayloadHeaderSize) {
+        return 0;
+    }
+
+    const bool keyframe = keyframePending || framesSinceKeyframe >= kKeyframeInterval;
+    const size_t rowBytes = packedRowBytes(width);
+    const int tileColumns = (width + kTileSize - 1) / kTileSize;
+    const int tileRows = (height + kTileSize - 1) / kTileSize;
+
+    bitPack(edges, current.data());
+
+    size_t o = kPayloadHeaderSize;
+    uint32_t tileCount = 0;
+
+    for (int ty = 0; ty < tileRows; ++ty) {
+        const int y0 = ty * kTileSize;
+        const int bandRows = std::min(kTileSize, height - y0);
+
+        // One contiguous pass over the band's rows marks every changed byte column
+        if (!keyframe) {
+            std::fill(bandDiff.begin(), bandDiff.end(), 0);
+            for (int y = y0; y < y0 + bandRows; ++y) {
+                accumulateDiff(current.data() + y * rowBytes, previous.data() + y * rowBytes,
+                               bandDiff.data(), rowBytes);
+            }
+        }
+
+        for (int tx = 0; tx < tileColumns; ++tx) {
+            const size_t byteX = tx * kTileRowBytes;
+            const size_t tileBytes = std::min(kTileRowBytes, rowBytes - byteX);
+
+            if (!keyframe) {
+                bool dirty = false;
+                for (size_t i = 0; i < tileBytes; ++i) {
+                    dirty |= bandDiff[byteX + i] != 0;
+                }
+                if (!dirty) {
+                    continue;
+                }
+            }
+
+            if (o + kTileHeaderSize + tileBytes * bandRows > capacity) {
+                return 0;
+            }
+            putU16(out + o, static_cast<uint32_t>(tx));
+            putU16(out + o + 2, static_cast<uint32_t>(ty));
+            o += kTileHeaderSize;
+            for (int y = y0; y < y0 + bandRows; ++y) {
+                std::memcpy(out + o, current.data() + y * rowBytes + byteX, tileBytes);
+                o += tileBytes;
+            }
+            ++tileCount;
+        }
+    }
+
+    out[0] = keyframe ? FLAG_KEYFRAME : 0;
+    out[1] = static_cast<uint8_t>(kTileSize);
+    putU16(out + 2, 0);
+    putU32(out + 4, tileCount);
+
+    // Only advance the reference once the packet is complete, so a failed encode stays in sync
+    current.swap(previous);
+    if (keyframe) {
+        keyframePending = false;
+        framesSinceKeyframe = 0;
+    } else {
+        ++framesSinceKeyframe;
+    }
+    return o;
+}
+
+size_t TileDeltaEncoder::encodeReference(uint8_t* out, size_t capacity) const {
+    if (width == 0 || height == 0 || capacity < maxPayloadSize(width, height)) {
+        return 0;
+    }
+
+    const size_t rowBytes = packedRowBytes(width);
+    const int tileColumns = (width + kTileSize - 1) / kTileSize;
+    const int tileRows = (height + kTileSize - 1) / kTileSize;
+
+    // encode() swaps the finished frame into previous, so that is what the stream's clients hold
+    size_t o = kPayloadHeaderSize;
+    for (int ty = 0; ty < tileRows; ++ty) {
+        const int y0 = ty * kTileSize;
+        const int bandRows = std::min(kTileSize, height - y0);
+        for (int tx = 0; tx < tileColumns; ++tx) {
+            const size_t byteX = tx * kTileRowBytes;
+            const size_t tileBytes = std::min(kTileRowBytes, rowBytes - byteX);
+            putU16(out + o, static_cast<uint32_t>(tx));
+            putU16(out + o + 2, static_cast<uint32_t>(ty));
+            o += kTileHeaderSize;
+            for (int y = y0; y < y0 + bandRows; ++y) {
+                std::memcpy(out + o, previous.data() + y * rowBytes + byteX, tileBytes);
+                o += tileBytes;
+            }
+        }
+    }
+
+    out[0] = FLAG_KEYFRAME;
+    out[1] = static_cast<uint8_t>(kTileSize);
+    putU16(out + 2, 0);
+    putU32(out + 4, static_cast<uint32_t>(tileColumns * tileRows));
+    return o;
+}
+
+} // namespace codec
+} // namespace edgevision
@@ -0,0 +1,78 @@
+#ifndef EDGEVISION_TILE_DELTA_H
+#define EDGEVISION_TILE_DELTA_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace edgevision {
+namespace codec {
+
+/**
+ * Temporal delta coding for bit-packed edge maps.
+ *
+ * The previous frame is kept bit-packed; each new frame is packed, XOR-compared against
+ * it one 32-row band at a time and only the 32x32 tiles that changed are emitted.
+ * Every kKeyframeInterval frames (and after requestKeyframe or a size change) all tiles
+ * are sent so late joiners and dropped state recover; encodeReference serves a single
+ * late client instead.
+ *
+ * Payload layout (little-endian):
+ *   0  uint8   flags (FLAG_KEYFRAME)
+ *   1  uint8   tile size in pixels
+ *   2  uint16  reserved (0)
+ *   4  uint32  tile count
+ *   8  tiles:  uint16 column, uint16 row, then min(32, remaining rows) rows of
+ *              packedRowBytes(min(32, remaining columns)) bytes, MSB first
+ */
+class TileDeltaEncoder {
+public:
+    static constexpr int kTileSize = 32;
+    static constexpr int kKeyframeInterval = 30;   // ~3 s at the 10 FPS stream rate
+    static constexpr uint8_t FLAG_KEYFRAME = 0x01;
+
+    TileDeltaEncoder();
+
+    /**
+     * Worst-case payload size (a keyframe)
+     */
+    static size_t maxPayloadSize(int width, int height);
+
+    /**
+     * Force the next encode to be a keyframe, e.g. when a client joins
+     */
+    void requestKeyframe() { keyframePending = true; }
+
+    /**
+     * Encode a binary CV_8UC1 edge map against the previous call's frame.
+     * Returns bytes written, or 0 if capacity is too small (the reference is kept).
+     */
+    size_t encode(const cv::Mat& edges, uint8_t* out, size_t capacity);
+
+    /**
+     * Write the frame the last encode() produced as a standalone keyframe, without
+     * touching the stream, so one client can resync while the others keep getting
+     * deltas. Returns bytes written, or 0 before the first frame or if capacity is too small.
+     */
+    size_t encodeReference(uint8_t* out, size_t capacity) const;
+
+    int frameWidth() const { return width; }
+    int frameHeight() const { return height; }
+
+private:
+    void reset(int newWidth, int newHeight);
+
+    std::vector<uint8_t> current;    // Bit-packed frame being encoded
+    std::vector<uint8_t> previous;   // Bit-packed frame the client last received
+    std::vector<uint8_t> bandDiff;   // OR of (current ^ previous) over one tile band
+    int width;
+    int height;
+    int framesSinceKeyframe;
+    bool keyframePending;
+};
+
+} // namespace codec
+} // namespace edgevision
+
+#endif // EDGEVISION_TILE_DELTA_H
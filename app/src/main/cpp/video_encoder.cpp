@@ -0,0 +1,368 @@
+#include "video_encoder.h"
+#include <android/log.h>
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaFormat.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define LOG_TAG "VideoEncoder"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace edgevision {
+namespace codec {
+
+namespace {
+
+// MediaCodecInfo.CodecCapabilities color formats
+constexpr int32_t kColorFormatSemiPlanar = 21;  // NV12
+constexpr int32_t kColorFormatPlanar = 19;      // I420
+
+// MediaCodec.BUFFER_FLAG_KEY_FRAME (not in the NDK headers before API 34)
+constexpr uint32_t kBufferFlagKeyFrame = 1;
+
+constexpr int32_t kStreamFps = 10;          // WebSocketManager's send rate
+constexpr int32_t kKeyframeIntervalS = 1;   // Bounds the wait for clients without request-sync
+constexpr int32_t kBitsPerPixel = 2;        // Per second at kStreamFps; edge maps are mostly flat
+constexpr int32_t kMinBitRate = 250000;
+
+// Neutral chroma: the stream stays gray whatever the colour format
+constexpr uint8_t kNeutralChroma = 128;
+
+// How long to wait for a free input buffer before dropping the frame
+constexpr int64_t kInputTimeoutUs = 2000;
+
+const char* mimeFor(VideoEncoder::Codec codec) {
+    return codec == VideoEncoder::CODEC_HEVC ? "video/hevc" : "video/avc";
+}
+
+// AMediaCodec_setParameters is API 26, above minSdk, so it is looked up at runtime
+using SetParametersFn = media_status_t (*)(AMediaCodec*, const AMediaFormat*);
+
+SetParametersFn setParametersFn() {
+    static const SetParametersFn fn = reinterpret_cast<SetParametersFn>(
+            dlsym(RTLD_DEFAULT, "AMediaCodec_setParameters"));
+    return fn;
+}
+
+// AMediaCodec_getInputFormat (API 28) reports the input buffer's row stride and slice height
+using GetInputFormatFn = AMediaFormat* (*)(AMediaCodec*);
+
+GetInputFormatFn getInputFormatFn() {
+    static const GetInputFormatFn fn = reinterpret_cast<GetInputFormatFn>(
+            dlsym(RTLD_DEFAULT, "AMediaCodec_getInputFormat"));
+    return fn;
+}
+
+int64_t steadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+VideoEncoder::VideoEncoder()
+    : mediaCodec(nullptr)
+    , codec(CODEC_H264)
+    , width(0)
+    , height(0)
+    , inputStride(0)
+    , inputSliceHeight(0)
+    , lastUsedUs(0)
+    , keyframePending(false)
+    , syncInFlight(false)
+{
+}
+
+VideoEncoder::~VideoEncoder() {
+    release();
+}
+
+void VideoEncoder::release() {
+    if (mediaCodec == nullptr) {
+        return;
+    }
+    AMediaCodec_stop(mediaCodec);
+    AMediaCodec_delete(mediaCodec);
+    mediaCodec = nullptr;
+    codecConfig.clear();
+    LOGD("Released %dx%d %s encoder", width, height, mimeFor(codec));
+}
+
+bool VideoEncoder::configure(int newWidth, int newHeight, Codec newCodec) {
+    release();
+    width = newWidth;
+    height = newHeight;
+    codec = newCodec;
+
+    // NV12 is near universal for ByteBuffer input; some older encoders only take I420.
+    // A failed configure can leave vendor codecs in their error state, so each attempt
+    // gets a fresh instance
+    for (int32_t colorFormat : {kColorFormatSemiPlanar, kColorFormatPlanar}) {
+        if (mediaCodec != nullptr) {
+            AMediaCodec_delete(mediaCodec);
+        }
+        mediaCodec = AMediaCodec_createEncoderByType(mimeFor(codec));
+        if (mediaCodec == nullptr) {
+            LOGE("No %s encoder on this device", mimeFor(codec));
+            return false;
+        }
+
+        AMediaFormat* format = AMediaFormat_new();
+        AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, mimeFor(codec));
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, width);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, height);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE,
+                              std::max(kMinBitRate, width * height * kBitsPerPixel));
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, kStreamFps);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_I_FRAME_INTERVAL, kKeyframeIntervalS);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, colorFormat);
+
+        const media_status_t status = AMediaCodec_configure(mediaCodec, format, nullptr, nullptr,
+                                                            AMEDIACODEC_CONFIGURE_FLAG_ENCODE);
+        AMediaFormat_delete(format);
+        if (status == AMEDIA_OK && AMediaCodec_start(mediaCodec) == AMEDIA_OK) {
+            readInputLayout();
+            LOGD("Started %dx%d %s encoder, color format %d, input stride %d, slice height %d",
+                 width, height, mimeFor(codec), colorFormat, inputStride, inputSliceHeight);
+            keyframePending = false;
+            syncInFlight = false;
+            return true;
+        }
+    }
+
+    LOGE("Failed to configure %dx%d %s encoder", width, height, mimeFor(codec));
+    AMediaCodec_delete(mediaCodec);
+    mediaCodec = nullptr;
+    return false;
+}
+
+void VideoEncoder::readInputLayout() {
+    // Without the input format (API < 28) the planes are assumed packed at the frame size
+    inputStride = width;
+    inputSliceHeight = height;
+
+    GetInputFormatFn getInputFormat = getInputFormatFn();
+    AMediaFormat* format = getInputFormat != nullptr ? getInputFormat(mediaCodec) : nullptr;
+    if (format == nullptr) {
+        return;
+    }
+    int32_t value = 0;
+    if (AMediaFormat_getInt32(format, "stride", &value) && value >= width) {
+        inputStride = value;
+    }
+    if (AMediaFormat_getInt32(format, "slice-height", &value) && value >= height) {
+        inputSliceHeight = value;
+    }
+    AMediaFormat_delete(format);
+}
+
+bool VideoEncoder::queueFrame(const cv::Mat& frame, int64_t timestampUs) {
+    const ssize_t index = AMediaCodec_dequeueInputBuffer(mediaCodec, kInputTimeoutUs);
+    if (index < 0) {
+        // Encoder still busy: drop this frame rather than stall the caller
+        return true;
+    }
+
+    size_t capacity = 0;
+    uint8_t* input = AMediaCodec_getInputBuffer(mediaCodec, static_cast<size_t>(index), &capacity);
+    // Chroma starts after sliceHeight luma rows in both NV12 and I420
+    const size_t lumaBytes = static_cast<size_t>(inputStride) * inputSliceHeight;
+    const size_t frameBytes = lumaBytes + lumaBytes / 2;
+    if (input == nullptr || capacity < frameBytes) {
+        LOGE("Input buffer too small: %zu < %zu bytes", capacity, frameBytes);
+        AMediaCodec_queueInputBuffer(mediaCodec, static_cast<size_t>(index), 0, 0, timestampUs, 0);
+        return false;
+    }
+
+    // Y rows at the encoder's stride; chroma layout does not matter when it is flat
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(input + static_cast<size_t>(y) * inputStride, frame.ptr<uint8_t>(y), width);
+    }
+    std::memset(input + lumaBytes, kNeutralChroma, frameBytes - lumaBytes);
+
+    return AMediaCodec_queueInputBuffer(mediaCodec, static_cast<size_t>(index), 0, frameBytes,
+                                        static_cast<uint64_t>(timestampUs), 0) == AMEDIA_OK;
+}
+
+bool VideoEncoder::drainOne(uint8_t* out, size_t capacity, size_t& written, int64_t& timestampUs) {
+    written = 0;
+    for (;;) {
+        AMediaCodecBufferInfo info;
+        const ssize_t index = AMediaCodec_dequeueOutputBuffer(mediaCodec, &info, 0);
+        if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
+            return true;
+        }
+        if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED || index == AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED) {
+            // Nothing to copy, look again
+            continue;
+        }
+        if (index < 0) {
+            // The codec died or was reclaimed; the caller recreates it
+            LOGE("dequeueOutputBuffer failed: %zd", index);
+            return false;
+        }
+
+        size_t bufferSize = 0;
+        const uint8_t* data = AMediaCodec_getOutputBuffer(mediaCodec, static_cast<size_t>(index), &bufferSize);
+        const bool valid = data != nullptr && info.offset >= 0 && info.size >= 0 &&
+                           static_cast<size_t>(info.offset) + info.size <= bufferSize;
+        if (!valid) {
+            AMediaCodec_releaseOutputBuffer(mediaCodec, static_cast<size_t>(index), false);
+            LOGE("Invalid output buffer");
+            return false;
+        }
+        const uint8_t* bytes = data + info.offset;
+        const size_t size = static_cast<size_t>(info.size);
+
+        if ((info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) != 0) {
+            codecConfig.assign(bytes, bytes + size);
+            AMediaCodec_releaseOutputBuffer(mediaCodec, static_cast<size_t>(index), false);
+            continue;
+        }
+
+        const bool keyframe = (info.flags & kBufferFlagKeyFrame) != 0;
+        if (keyframe) {
+            syncInFlight = false;
+        }
+        const size_t configBytes = keyframe ? codecConfig.size() : 0;
+        const size_t total = kPayloadHeaderSize + configBytes + size;
+        if (total > capacity) {
+            AMediaCodec_releaseOutputBuffer(mediaCodec, static_cast<size_t>(index), false);
+            LOGE("Packet buffer too small: %zu < %zu bytes", capacity, total);
+            return false;
+        }
+
+        out[0] = keyframe ? FLAG_KEYFRAME : 0;
+        out[1] = out[2] = out[3] = 0;
+        if (configBytes > 0) {
+            std::memcpy(out + kPayloadHeaderSize, codecConfig.data(), configBytes);
+        }
+        std::memcpy(out + kPayloadHeaderSize + configBytes, bytes, size);
+        AMediaCodec_releaseOutputBuffer(mediaCodec, static_cast<size_t>(index), false);
+        written = total;
+        timestampUs = info.presentationTimeUs;
+        return true;
+    }
+}
+
+void VideoEncoder::applyKeyframeRequest() {
+    if (!keyframePending) {
+        return;
+    }
+    keyframePending = false;
+
+    SetParametersFn setParameters = setParametersFn();
+    if (setParameters == nullptr) {
+        return;
+    }
+    AMediaFormat* params = AMediaFormat_new();
+    AMediaFormat_setInt32(params, "request-sync", 0);
+    syncInFlight = setParameters(mediaCodec, params) == AMEDIA_OK;
+    AMediaFormat_delete(params);
+}
+
+bool VideoEncoder::encode(const cv::Mat& frame, Codec requested, int64_t timestampUs,
+                          uint8_t* out, size_t capacity, size_t& written, int64_t& outputTimestampUs) {
+    written = 0;
+    lastUsedUs = steadyNowUs();
+
+    const int frameWidth = alignedSize(frame.cols);
+    const int frameHeight = alignedSize(frame.rows);
+    if (frameWidth == 0 || frameHeight == 0 || frame.type() != CV_8UC1) {
+        LOGE("Unsupported frame for video encoding: %dx%d", frame.cols, frame.rows);
+        return false;
+    }
+
+    if (mediaCodec == nullptr || frameWidth != width || frameHeight != height || requested != codec) {
+        // A fresh encoder starts with a keyframe anyway
+        if (!configure(frameWidth, frameHeight, requested)) {
+            return false;
+        }
+    }
+
+    applyKeyframeRequest();
+    if (!queueFrame(frame, timestampUs) || !drainOne(out, capacity, written, outputTimestampUs)) {
+        // Start over with a fresh encoder on the next frame
+        release();
+        return false;
+    }
+    return true;
+}
+
+} // namespace codec
+
+namespace protocol {
+
+bool VideoStreamEncoder::encode(const cv::Mat& frame, FrameHeader header, uint8_t* out, size_t capacity,
+                                int level, size_t& written) {
+    written = 0;
+    if (!isVideoEncoding(header.encoding)) {
+        LOGE("Not a video encoding: %d", header.encoding);
+        return false;
+    }
+    if (level < 0 || level >= OutputPyramid::kLevels) {
+        LOGE("Invalid output level: %d", level);
+        return false;
+    }
+    if (capacity < kHeaderSize) {
+        LOGE("Encode buffer too small for header: %zu bytes", capacity);
+        return false;
+    }
+
+    const codec::VideoEncoder::Codec codec = header.encoding == ENCODING_HEVC
+            ? codec::VideoEncoder::CODEC_HEVC : codec::VideoEncoder::CODEC_H264;
+    const int64_t timestampUs = header.timestampMs * 1000;
+
+    size_t payloadBytes = 0;
+    int64_t outputTimestampUs = timestampUs;
+    if (!encoders[level][codec].encode(frame, codec, timestampUs, out + kHeaderSize,
+                                       capacity - kHeaderSize, payloadBytes, outputTimestampUs)) {
+        return false;
+    }
+    if (payloadBytes == 0) {
+        return true;
+    }
+
+    // The access unit belongs to an earlier frame than the one just queued
+    header.timestampMs = outputTimestampUs / 1000;
+    header.format = FORMAT_GRAY8;
+    header.width = static_cast<uint32_t>(codec::VideoEncoder::alignedSize(frame.cols));
+    header.height = static_cast<uint32_t>(codec::VideoEncoder::alignedSize(frame.rows));
+    header.payloadLength = static_cast<uint32_t>(payloadBytes);
+    writeHeader(header, out);
+    written = kHeaderSize + payloadBytes;
+    return true;
+}
+
+void VideoStreamEncoder::releaseIdle(int64_t idleUs) {
+    const int64_t now = codec::steadyNowUs();
+    for (auto& levelEncoders : encoders) {
+        for (codec::VideoEncoder& encoder : levelEncoders) {
+            if (encoder.isActive() && now - encoder.lastUseUs() >= idleUs) {
+                encoder.release();
+            }
+        }
+    }
+}
+
+void VideoStreamEncoder::requestKeyframe(uint8_t encoding, int level) {
+    if (!isVideoEncoding(encoding) || level < 0 || level >= OutputPyramid::kLevels) {
+        return;
+    }
+    encoders[level][encoding == ENCODING_HEVC ? codec::VideoEncoder::CODEC_HEVC
+                                              : codec::VideoEncoder::CODEC_H264].requestKeyframe();
+}
+
+void VideoStreamEncoder::requestKeyframe() {
+    for (auto& levelEncoders : encoders) {
+        for (codec::VideoEncoder& encoder : levelEncoders) {
+            encoder.requestKeyframe();
+        }
+    }
+}
+
+} // namespace protocol
+} // namespace edgevision
@@ -0,0 +1,149 @@
+#ifndef EDGEVISION_VIDEO_ENCODER_H
+#define EDGEVISION_VIDEO_ENCODER_H
+
+#include "frame_encoder.h"
+#include "output_pyramid.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AMediaCodec;
+
+namespace edgevision {
+namespace codec {
+
+/**
+ * Hardware H.264 / HEVC encoding of processed frames through AMediaCodec.
+ *
+ * Each gray frame is copied into the Y plane of a YUV420 input buffer with neutral chroma
+ * (the encoder block does the rest), and at most one access unit is collected per call,
+ * so the caller never blocks on the encoder: output shows up a call or two later, and a
+ * frame is dropped if the encoder has no free input buffer. Keyframes carry the codec
+ * config (SPS/PPS, plus VPS for HEVC) so clients can join at any keyframe.
+ *
+ * Payload layout:
+ *   0  uint8   flags (FLAG_KEYFRAME)
+ *   1  uint8[3] reserved (0)
+ *   4  Annex-B access unit
+ */
+class VideoEncoder {
+public:
+    enum Codec : int {
+        CODEC_H264 = 0,
+        CODEC_HEVC = 1
+    };
+
+    static constexpr uint8_t FLAG_KEYFRAME = 0x01;
+    static constexpr size_t kPayloadHeaderSize = 4;
+    static constexpr size_t kMaxConfigBytes = 4096;   // SPS/PPS/VPS are a few dozen bytes
+
+    VideoEncoder();
+    ~VideoEncoder();
+
+    VideoEncoder(const VideoEncoder&) = delete;
+    VideoEncoder& operator=(const VideoEncoder&) = delete;
+
+    /**
+     * Worst-case payload size for a frame (an uncompressed frame's worth plus config)
+     */
+    static size_t maxPayloadSize(int width, int height) {
+        return kPayloadHeaderSize + static_cast<size_t>(width) * height + kMaxConfigBytes;
+    }
+
+    /**
+     * Frame dimension the encoder is fed (cropped to a multiple of 16, which every
+     * hardware encoder accepts)
+     */
+    static int alignedSize(int size) { return size & ~15; }
+
+    /**
+     * Queue one CV_8UC1 frame and write the next ready access unit into out, with the
+     * timestamp of the frame it encodes in outputTimestampUs. Returns false on encoder
+     * failure (the encoder is then released); written is 0 when no output is ready yet.
+     * The encoder is (re)created whenever the codec or frame size changes.
+     */
+    bool encode(const cv::Mat& frame, Codec codec, int64_t timestampUs,
+                uint8_t* out, size_t capacity, size_t& written, int64_t& outputTimestampUs);
+
+    /**
+     * Ask for a sync frame as soon as possible (API 26+; older devices wait for the
+     * periodic one). Repeated requests before that keyframe comes out are ignored.
+     */
+    void requestKeyframe() { keyframePending = !syncInFlight; }
+
+    /**
+     * Free the hardware encoder (e.g. when no client uses this stream any more)
+     */
+    void release();
+
+    bool isActive() const { return mediaCodec != nullptr; }
+
+    /**
+     * Steady-clock time of the last encode call, for idle detection
+     */
+    int64_t lastUseUs() const { return lastUsedUs; }
+
+private:
+    bool configure(int newWidth, int newHeight, Codec newCodec);
+    void readInputLayout();
+    bool queueFrame(const cv::Mat& frame, int64_t timestampUs);
+    bool drainOne(uint8_t* out, size_t capacity, size_t& written, int64_t& timestampUs);
+    void applyKeyframeRequest();
+
+    AMediaCodec* mediaCodec;
+    Codec codec;
+    int width;
+    int height;
+    int inputStride;        // Luma row stride of the input buffers
+    int inputSliceHeight;   // Luma rows before the chroma plane(s)
+    int64_t lastUsedUs;
+    bool keyframePending;
+    bool syncInFlight;      // request-sync sent, keyframe not drained yet
+    std::vector<uint8_t> codecConfig;   // Last CODEC_CONFIG buffer, prepended to keyframes
+};
+
+} // namespace codec
+
+namespace protocol {
+
+/**
+ * ENCODING_H264 / ENCODING_HEVC packets: one hardware encoder per output level and codec,
+ * created when a client first asks for that stream and freed by releaseIdle once nobody
+ * feeds it. Kept apart from FrameEncoder so the host benchmark does not need the media
+ * NDK. Not thread-safe.
+ */
+class VideoStreamEncoder {
+public:
+    /**
+     * Encode a CV_8UC1 frame (cropped to VideoEncoder::alignedSize) into a full packet.
+     * written is the packet length, or 0 while the encoder has no output ready (or
+     * dropped the frame). Returns false on failure.
+     */
+    bool encode(const cv::Mat& frame, FrameHeader header, uint8_t* out, size_t capacity,
+                int level, size_t& written);
+
+    /**
+     * Free the encoders not fed for idleUs (0 = all of them); called from a timer,
+     * since nothing calls encode() once the last video client has gone
+     */
+    void releaseIdle(int64_t idleUs);
+
+    /**
+     * Make the next packet of every active stream a keyframe
+     */
+    void requestKeyframe();
+
+    /**
+     * Ask one stream (ENCODING_H264/HEVC at an output level) for a keyframe
+     */
+    void requestKeyframe(uint8_t encoding, int level);
+
+private:
+    codec::VideoEncoder encoders[OutputPyramid::kLevels][2];
+};
+
+} // namespace protocol
+} // namespace edgevision
+
+#endif // EDGEVISION_VIDEO_ENCODER_H
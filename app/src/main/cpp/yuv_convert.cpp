@@ -0,0 +1,170 @@
+#include "yuv_convert.h"
+#include "metrics.h"
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace edgevision {
+
+namespace {
+
+// BT.601 limited range in Q6: R = 1.164(Y-16) + 1.596(V-128), etc.
+constexpr int kY = 74;
+constexpr int kVr = 102;
+constexpr int kVg = 52;
+constexpr int kUg = 25;
+constexpr int kUb = 129;
+
+inline uint8_t clampShift(int value) {
+    return static_cast<uint8_t>(std::min(std::max((value + 32) >> 6, 0), 255));
+}
+
+inline void convertPixel(int y, int u, int v, uint8_t* out) {
+    const int luma = (y - 16) * kY;
+    const int du = u - 128;
+    const int dv = v - 128;
+    out[0] = clampShift(luma + kVr * dv);
+    out[1] = clampShift(luma - kVg * dv - kUg * du);
+    out[2] = clampShift(luma + kUb * du);
+    out[3] = 255;
+}
+
+#if defined(__ARM_NEON)
+// Eight pixels from their luma and per-pixel (already duplicated) chroma
+inline void convertEight(uint8x8_t y, uint8x8_t u, uint8x8_t v,
+                         uint8x8_t& r, uint8x8_t& g, uint8x8_t& b) {
+    const int16x8_t luma = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)), vdupq_n_s16(16)), kY);
+    const int16x8_t du = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), vdupq_n_s16(128));
+    const int16x8_t dv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), vdupq_n_s16(128));
+
+    // Saturating adds: the blue term can exceed int16 before the shift clamps it anyway
+    r = vqrshrun_n_s16(vqaddq_s16(luma, vmulq_n_s16(dv, kVr)), 6);
+    g = vqrshrun_n_s16(vqsubq_s16(vqsubq_s16(luma, vmulq_n_s16(dv, kVg)), vmulq_n_s16(du, kUg)), 6);
+    b = vqrshrun_n_s16(vqaddq_s16(luma, vmulq_n_s16(du, kUb)), 6);
+}
+#endif
+
+} // namespace
+
+void yuvToRgba(const YuvPlanes& planes, int width, int height, cv::Mat& rgba) {
+    metrics::ScopedTimer timer(metrics::STAGE_COPY_IN);
+
+    const int pixelStride = planes.uvPixelStride;
+#if defined(__ARM_NEON)
+    // A 16-pixel semi-planar load reads one byte past the last chroma sample it uses,
+    // which on the final row may be past the end of the buffer; leave that block to scalar
+    const int vectorEnd = pixelStride == 1 ? width : width - 1;
+#endif
+
+    for (int row = 0; row < height; ++row) {
+        const uint8_t* yRow = planes.y + static_cast<size_t>(row) * planes.yRowStride;
+        const uint8_t* uRow = planes.u + static_cast<size_t>(row / 2) * planes.uvRowStride;
+        const uint8_t* vRow = planes.v + static_cast<size_t>(row / 2) * planes.uvRowStride;
+        uint8_t* out = rgba.ptr<uint8_t>(row);
+
+        int x = 0;
+#if defined(__ARM_NEON)
+        if (pixelStride == 1 || pixelStride == 2) {
+            for (; x + 16 <= vectorEnd; x += 16) {
+                const uint8x16_t y = vld1q_u8(yRow + x);
+                uint8x8_t u;
+                uint8x8_t v;
+                if (pixelStride == 1) {
+                    u = vld1_u8(uRow + x / 2);
+                    v = vld1_u8(vRow + x / 2);
+                } else {
+                    // Even lanes of each interleaved load are this plane's samples
+                    u = vld2_u8(uRow + x).val[0];
+                    v = vld2_u8(vRow + x).val[0];
+                }
+
+                // Each chroma sample covers two horizontal pixels
+                const uint8x8x2_t uu = vzip_u8(u, u);
+                const uint8x8x2_t vv = vzip_u8(v, v);
+
+                uint8x8_t r0, g0, b0, r1, g1, b1;
+                convertEight(vget_low_u8(y), uu.val[0], vv.val[0], r0, g0, b0);
+                convertEight(vget_high_u8(y), uu.val[1], vv.val[1], r1, g1, b1);
+
+                uint8x16x4_t pixels;
+                pixels.val[0] = vcombine_u8(r0, r1);
+                pixels.val[1] = vcombine_u8(g0, g1);
+                pixels.val[2] = vcombine_u8(b0, b1);
+                pixels.val[3] = vdupq_n_u8(255);
+                vst4q_u8(out + x * 4, pixels);
+            }
+        }
+#endif
+        for (; x < width; ++x) {
+            const size_t chroma = static_cast<size_t>(x / 2) * pixelStride;
+            convertPixel(yRow[x], uRow[chroma], vRow[chroma], out + x * 4);
+        }
+    }
+}
+
+bool packedYuvPlanes(const uint8_t* data, size_t length, int width, int height, YuvPlanes& planes) {
+    if (data == nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const size_t lumaBytes = static_cast<size_t>(width) * height;
+    const size_t chromaWidth = (width + 1) / 2;
+    const size_t chromaHeight = (height + 1) / 2;
+    planes.y = data;
+    planes.yRowStride = width;
+
+    // Tight I420: quarter-size U plane, then V
+    const size_t planarBytes = chromaWidth * chromaHeight;
+    if (length == lumaBytes + 2 * planarBytes) {
+        planes.u = data + lumaBytes;
+        planes.v = planes.u + planarBytes;
+        planes.uvRowStride = static_cast<int>(chromaWidth);
+        planes.uvPixelStride = 1;
+        return true;
+    }
+
+    // Semi-planar plane buffers each end on their last sample, one byte short of a full row
+    const size_t rowBytes = chromaWidth * 2;
+    const size_t interleavedBytes = (chromaHeight - 1) * rowBytes + (chromaWidth - 1) * 2 + 1;
+    if (length == lumaBytes + 2 * interleavedBytes) {
+        planes.u = data + lumaBytes;
+        planes.v = planes.u + interleavedBytes;
+        planes.uvRowStride = static_cast<int>(rowBytes);
+        planes.uvPixelStride = 2;
+        return true;
+    }
+
+    return false;
+}
+
+size_t minimumPlaneBytes(int width, int height, int rowStride, int pixelStride) {
+    if (width <= 0 || height <= 0 || pixelStride <= 0 ||
+        static_cast<int64_t>(rowStride) < static_cast<int64_t>(width) * pixelStride) {
+        return 0;
+    }
+    return static_cast<size_t>(rowStride) * (height - 1) + static_cast<size_t>(width - 1) * pixelStride + 1;
+}
+
+void gatherPlane(const uint8_t* plane, int rowStride, int pixelStride, cv::Mat& dst) {
+    for (int y = 0; y < dst.rows; ++y) {
+        const uint8_t* src = plane + static_cast<size_t>(y) * rowStride;
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        int x = 0;
+#if defined(__ARM_NEON)
+        // Semi-planar (NV12/NV21 style) luma: deinterleave 16 pixels per step, stopping
+        // while a whole 32-byte load still ends before the row's last sample
+        if (pixelStride == 2) {
+            for (; x + 16 < dst.cols; x += 16) {
+                vst1q_u8(out + x, vld2q_u8(src + x * 2).val[0]);
+            }
+        }
+#endif
+        for (; x < dst.cols; ++x) {
+            out[x] = src[x * pixelStride];
+        }
+    }
+}
+
+} // namespace edgevision
@@ -0,0 +1,64 @@
+#ifndef EDGEVISION_YUV_CONVERT_H
+#define EDGEVISION_YUV_CONVERT_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace edgevision {
+
+/**
+ * The three planes of a YUV_420_888 image as the camera hands them over.
+ *
+ * uvPixelStride 1 is planar (I420/YV12), 2 is semi-planar: u and v then point into the
+ * same interleaved buffer (NV12 when v == u + 1, NV21 when u == v + 1).
+ */
+struct YuvPlanes {
+    const uint8_t* y;
+    const uint8_t* u;
+    const uint8_t* v;
+    int yRowStride;
+    int uvRowStride;
+    int uvPixelStride;
+};
+
+/**
+ * Convert YUV_420_888 to RGBA straight from the planes (BT.601 limited range, the same
+ * coefficients as cv::COLOR_YUV2RGB_I420), honouring every stride so the camera buffers
+ * never need repacking. rgba must be a width x height CV_8UC4 Mat; alpha is 255.
+ */
+void yuvToRgba(const YuvPlanes& planes, int width, int height, cv::Mat& rgba);
+
+/**
+ * Locate the planes in a packed frame copied into one array: either tight I420
+ * (Y, U, V) or the Y, U, V plane buffers of a semi-planar image appended end to end
+ * (what FrameBufferQueue produces), told apart by length. Rows must be unpadded.
+ * Returns false for any other length.
+ */
+bool packedYuvPlanes(const uint8_t* data, size_t length, int width, int height, YuvPlanes& planes);
+
+/**
+ * Bytes a plane buffer must hold: (height-1) full row strides plus the last row up to and
+ * including its last sample, (width-1)*pixelStride + 1, because the camera does not pad the
+ * last row. 0 for an invalid layout (non-positive sizes or rowStride < width*pixelStride).
+ */
+size_t minimumPlaneBytes(int width, int height, int rowStride, int pixelStride);
+
+/**
+ * Whether a plane buffer of capacity bytes holds a valid width x height layout
+ */
+inline bool planeFits(size_t capacity, int width, int height, int rowStride, int pixelStride) {
+    const size_t required = minimumPlaneBytes(width, height, rowStride, pixelStride);
+    return required != 0 && capacity >= required;
+}
+
+/**
+ * Copy every pixelStride-th byte of a plane into a width x height CV_8UC1 dst, reading
+ * nothing past minimumPlaneBytes (cv::extractChannel over a CV_8UC(pixelStride) header
+ * would touch pixelStride-1 bytes beyond the last sample).
+ */
+void gatherPlane(const uint8_t* plane, int rowStride, int pixelStride, cv::Mat& dst);
+
+} // namespace edgevision
+
+#endif // EDGEVISION_YUV_CONVERT_H
@@ -4,8 +4,11 @@ import android.Manifest
 import android.content.Intent
 import android.content.pm.PackageManager
 import android.hardware.camera2.CameraDevice
+import android.media.Image
 import android.net.Uri
 import android.os.Bundle
+import android.os.Handler
+import android.os.Looper
 import android.provider.Settings
 import android.util.Log
 import android.util.Size
@@ -48,9 +51,13 @@ import com.example.edgevision.camera.FrameBufferQueue
 import com.example.edgevision.camera.FrameReader
 import com.example.edgevision.camera.PreviewSurface
 import com.example.edgevision.gl.EdgeVisionRenderer
+import com.example.edgevision.gl.EglContextFactory
+import com.example.edgevision.native.FrameOutputPool
 import com.example.edgevision.native.NativeProcessor
 import com.example.edgevision.ui.theme.EdgeVisionTheme
 import com.example.edgevision.websocket.WebSocketManager
+import java.nio.ByteBuffer
+import kotlin.concurrent.thread
 
 class MainActivity : ComponentActivity() {
 
@@ -58,7 +65,8 @@ class MainActivity : ComponentActivity() {
     private var hasPermission by mutableStateOf(false)
     private var cameraStatus by mutableStateOf("Initializing...")
     private var frameCount by mutableStateOf(0)
-    private var isEdgeDetectionEnabled by mutableStateOf(true)
+    private var processingMode by mutableStateOf(NativeProcessor.PROCESSING_TYPE_CANNY)
+    private var isGpuBackendEnabled by mutableStateOf(false)
     private var isWebSocketServerRunning by mutableStateOf(false)
     private var webSocketUrl by mutableStateOf("Not started")
     private var connectedClients by mutableStateOf(0)
@@ -71,6 +79,23 @@ class MainActivity : ComponentActivity() {
     private var previewSurface: PreviewSurface? = null
     private var glSurfaceView: GLSurfaceView? = null
     private var glRenderer: EdgeVisionRenderer? = null
+    private val outputPool = FrameOutputPool()
+    private var isPipelineRunning = false
+    private var hasPipelineListener = false
+    // Camera thread (inline frames) and native output thread (pipeline frames) both publish
+    private val outputLock = Any()
+    private var cameraDevice: CameraDevice? = null
+    private var gpuSurface: android.view.Surface? = null
+    @Volatile private var isCaptureRequested = false
+    // GPU backend chosen by the thermal scheduler rather than the user
+    private var isThermalGpu = false
+    private val thermalHandler = Handler(Looper.getMainLooper())
+    private val thermalCheck = object : Runnable {
+        override fun run() {
+            onThermalCheck()
+            thermalHandler.postDelayed(this, THERMAL_CHECK_INTERVAL_MS)
+        }
+    }
 
     // WebSocket components
     private lateinit var webSocketManager: WebSocketManager
@@ -79,6 +104,21 @@ class MainActivity : ComponentActivity() {
         private const val TAG = "MainActivity"
         // Use square dimensions to match camera output
         private val PREVIEW_SIZE = Size(1088, 1088)
+        // Camera frame rate the native governor tries to hold
+        private const val TARGET_FPS = 30f
+        // How often the thermal scheduler's backend recommendation is checked
+        private const val THERMAL_CHECK_INTERVAL_MS = 1000L
+        // Order the processing toggle cycles through
+        private val PROCESSING_MODES = listOf(
+            NativeProcessor.PROCESSING_TYPE_CANNY,
+            NativeProcessor.PROCESSING_TYPE_SOBEL,
+            NativeProcessor.PROCESSING_TYPE_LAPLACIAN,
+            NativeProcessor.PROCESSING_TYPE_THRESHOLD,
+            NativeProcessor.PROCESSING_TYPE_GRAYSCALE
+        )
+
+        private fun nextProcessingMode(mode: Int): Int =
+            PROCESSING_MODES[(PROCESSING_MODES.indexOf(mode) + 1) % PROCESSING_MODES.size]
     }
 
     private val cameraPermissionLauncher = registerForActivityResult(
@@ -116,11 +156,13 @@ class MainActivity : ComponentActivity() {
                         CameraScreen(
                             status = cameraStatus,
                             frameCount = frameCount,
-                            isEdgeDetectionEnabled = isEdgeDetectionEnabled,
+                            nextModeLabel = NativeProcessor.modeName(nextProcessingMode(processingMode)),
+                            isGpuBackendEnabled = isGpuBackendEnabled,
                             isWebSocketServerRunning = isWebSocketServerRunning,
                             webSocketUrl = webSocketUrl,
                             connectedClients = connectedClients,
                             onToggleProcessing = { toggleProcessing() },
+                            onToggleBackend = { toggleBackend() },
                             onCaptureFrame = { captureFrame() },
                             onToggleWebSocket = { toggleWebSocketServer() },
                             onTextureViewCreated = { view ->
@@ -218,7 +260,12 @@ class MainActivity : ComponentActivity() {
         Log.d(TAG, "Setting up GLSurfaceView with renderer")
 
         // Create and set renderer with context
-        glRenderer = EdgeVisionRenderer(this)
+        glRenderer = EdgeVisionRenderer(this).apply {
+            setOutputPool(outputPool)
+            onCameraSurfaceReady = { surface ->
+                runOnUiThread { onGpuSurfaceReady(surface) }
+            }
+        }
         view.setRenderer(glRenderer)
 
         // Set render mode to continuous (will optimize later)
@@ -228,77 +275,113 @@ class MainActivity : ComponentActivity() {
     }
 
     private fun startCameraPreview(cameraDevice: CameraDevice) {
+        // Edge detection runs on the native stage threads; grayscale stays inline
+        // Trade resolution, then frame rate, for latency when Canny cannot keep up
+        NativeProcessor.setTargetFps(TARGET_FPS)
+        // Raise the Canny thresholds over noisy or busy scenes (never below the 50/150 defaults)
+        NativeProcessor.setAutoThreshold(true)
+        // Back off before the SoC throttles, so the frame rate holds over long sessions
+        if (NativeProcessor.setThermalScheduling(true)) {
+            thermalHandler.removeCallbacks(thermalCheck)
+            thermalHandler.post(thermalCheck)
+        }
+
+        // Results arrive on the native output thread, so the camera thread only submits
+        if (!hasPipelineListener) {
+            hasPipelineListener = NativeProcessor.setResultListener { frame, width, height, _ ->
+                onPipelineResult(frame, width, height)
+            }
+        }
+        isPipelineRunning = NativeProcessor.pipelineStart(PREVIEW_SIZE.width, PREVIEW_SIZE.height)
+        Log.i(TAG, "Native pipeline running: $isPipelineRunning, listener: $hasPipelineListener")
+
         // Initialize frame reader with buffer queue
         frameReader = FrameReader(PREVIEW_SIZE).apply {
             onFrameAvailable = { frameBuffer ->
                 processFrame(frameBuffer)
             }
+            // Read the Y plane in place instead of copying every plane into a ByteArray
+            onImageAvailable = { image ->
+                processImage(image)
+            }
         }
 
-        val reader = frameReader?.getImageReader() ?: return
+        this.cameraDevice = cameraDevice
+        createSession(cameraDevice)
+    }
 
-        // Create capture session with both preview surface and image reader
-        val surfaces = mutableListOf(reader.surface)
-        previewSurface?.getSurface()?.let { surfaces.add(it) }
+    private fun createSession(cameraDevice: CameraDevice) {
+        val reader = frameReader?.getImageReader() ?: return
 
-        // Create capture session
+        // Create capture session with the image reader plus the GPU camera texture when available
         captureManager.createCaptureSession(
             cameraDevice = cameraDevice,
             reader = reader,
             onSessionConfigured = { session ->
                 Log.d(TAG, "Capture session configured")
                 cameraStatus = "Camera ready - capturing frames"
-                captureManager.startRepeatingCapture(cameraDevice, reader.surface)
+                applyProcessingBackend()
             },
             onSessionFailed = {
                 Log.e(TAG, "Failed to configure capture session")
                 cameraStatus = "Failed to start camera"
-            }
+            },
+            extraSurfaces = listOfNotNull(gpuSurface)
         )
     }
 
+    private fun onGpuSurfaceReady(surface: android.view.Surface) {
+        Log.d(TAG, "GPU camera surface ready")
+        gpuSurface = surface
+        // Session outputs are fixed at creation, so rebuild it to include the new surface
+        cameraDevice?.let { createSession(it) }
+    }
+
+    /**
+     * Route camera frames to exactly one backend: the ImageReader (CPU/JNI) or the
+     * GPU camera texture, so the unused path costs nothing per frame
+     */
+    private fun applyProcessingBackend() {
+        val camera = cameraDevice ?: return
+        val reader = frameReader?.getImageReader() ?: return
+        val surface = gpuSurface
+        val useGpu = (isGpuBackendEnabled || isThermalGpu) &&
+                processingMode == NativeProcessor.PROCESSING_TYPE_CANNY && surface != null
+
+        NativeProcessor.processingBackend = if (useGpu) {
+            NativeProcessor.BACKEND_GPU
+        } else {
+            NativeProcessor.BACKEND_CPU
+        }
+        if (useGpu && surface != null) {
+            captureManager.startRepeatingCapture(camera, surface)
+        } else {
+            captureManager.startRepeatingCapture(camera, reader.surface)
+        }
+        Log.d(TAG, "Processing backend: ${if (useGpu) "GPU" else "CPU"}")
+    }
+
     private fun processFrame(frameBuffer: FrameBufferQueue.FrameBuffer) {
         // Update frame count
         frameCount++
 
         // Process frames with OpenCV
         try {
-            val processedData = if (isEdgeDetectionEnabled) {
-                // Process with Canny edge detection
-                NativeProcessor.processFrameCanny(
-                    frameBuffer.data,
-                    frameBuffer.width,
-                    frameBuffer.height
-                )
-            } else {
-                // Process with grayscale (raw feed)
-                NativeProcessor.processFrameGrayscale(
-                    frameBuffer.data,
-                    frameBuffer.width,
-                    frameBuffer.height
-                )
-            }
+            // One entry point for every mode; the native side picks the pipeline on mode changes
+            val mode = processingMode
+            val processedData = NativeProcessor.processFrame(
+                frameBuffer.data,
+                frameBuffer.width,
+                frameBuffer.height,
+                mode
+            )
 
             if (processedData != null) {
-                // Update GL renderer with processed frame
-                glRenderer?.updateFrame(processedData)
-
-                // Send frame via WebSocket if server is running
-                val processingMode = if (isEdgeDetectionEnabled) "Canny Edge Detection" else "Grayscale"
-                val fps = glRenderer?.getFPS() ?: 0.0
-                webSocketManager.sendFrame(
-                    frameData = processedData,
-                    width = frameBuffer.width,
-                    height = frameBuffer.height,
-                    format = "Grayscale",
-                    processingMode = processingMode,
-                    fps = fps
-                )
+                publishFrame(processedData, frameBuffer.width, frameBuffer.height)
 
                 // Log every 30th frame
                 if (frameCount % 30 == 0) {
-                    val mode = if (isEdgeDetectionEnabled) "edge detection" else "grayscale"
-                    Log.d(TAG, "Frame #$frameCount: Processed ($mode), " +
+                    Log.d(TAG, "Frame #$frameCount: Processed (${NativeProcessor.modeName(mode)}), " +
                             "input: ${frameBuffer.data.size} bytes, output: ${processedData.size} bytes")
                 }
             } else {
@@ -309,11 +392,179 @@ class MainActivity : ComponentActivity() {
         }
     }
 
+    private fun processImage(image: Image) {
+        // Frames still in flight from before a switch to the GPU backend
+        if (NativeProcessor.processingBackend == NativeProcessor.BACKEND_GPU) return
+
+        // Update frame count
+        frameCount++
+
+        try {
+            val yPlane = image.planes[0]
+            val mode = processingMode
+
+            if (isPipelineRunning && mode == NativeProcessor.PROCESSING_TYPE_CANNY) {
+                // Hand the frame to the native stages; returns once the Y plane is copied
+                NativeProcessor.pipelineSubmit(
+                    yPlane.buffer,
+                    yPlane.rowStride,
+                    yPlane.pixelStride,
+                    image.width,
+                    image.height,
+                    image.timestamp
+                )
+                if (hasPipelineListener) return
+
+                // No listener: pick up whatever finished since last time
+                synchronized(outputLock) {
+                    val (output, pixelBuffer) = acquireOutput(image.width * image.height)
+                    val written = if (NativeProcessor.pipelinePoll(output) >= 0) image.width * image.height else 0
+                    finishFrame(output, pixelBuffer, written, image.width, image.height, mode)
+                }
+                return
+            }
+
+            synchronized(outputLock) {
+                val (output, pixelBuffer) = acquireOutput(image.width * image.height)
+                val written = NativeProcessor.processPlanesInto(
+                    yPlane.buffer,
+                    yPlane.rowStride,
+                    yPlane.pixelStride,
+                    image.width,
+                    image.height,
+                    mode,
+                    output
+                )
+                finishFrame(output, pixelBuffer, written, image.width, image.height, mode)
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error processing frame #$frameCount", e)
+        }
+    }
+
+    /**
+     * Pipeline result on the native output thread; the frame buffer is only valid during the call
+     */
+    private fun onPipelineResult(frame: ByteBuffer, width: Int, height: Int) {
+        if (NativeProcessor.processingBackend == NativeProcessor.BACKEND_GPU) return
+
+        try {
+            synchronized(outputLock) {
+                val (output, pixelBuffer) = acquireOutput(width * height)
+                frame.rewind()
+                output.put(frame)
+                output.rewind()
+                finishFrame(output, pixelBuffer, width * height, width, height,
+                    NativeProcessor.PROCESSING_TYPE_CANNY)
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error publishing pipeline frame", e)
+        }
+    }
+
+    /**
+     * Output buffer for the next frame plus the pixel buffer it came from, if any.
+     * Writes straight into GPU-visible memory unless a CPU consumer needs this frame.
+     */
+    private fun acquireOutput(size: Int): Pair<ByteBuffer, ByteBuffer?> {
+        val needsCpuCopy = isCaptureRequested || webSocketManager.isReadyForFrame()
+        val pixelBuffer = if (!needsCpuCopy && glRenderer?.isUsingPixelBuffers() == true) {
+            NativeProcessor.uploaderAcquire()
+        } else {
+            null
+        }
+        return Pair(pixelBuffer ?: outputPool.writeBuffer(size), pixelBuffer)
+    }
+
+    /**
+     * Hand a processed frame to the renderer, WebSocket clients and a pending capture
+     */
+    private fun finishFrame(output: ByteBuffer, pixelBuffer: ByteBuffer?, written: Int,
+                            width: Int, height: Int, mode: Int) {
+        if (pixelBuffer != null) {
+            NativeProcessor.uploaderPublish(written > 0)
+        }
+
+        if (written > 0) {
+            if (pixelBuffer == null) {
+                // Renderer picks the frame up from the pool on its next draw
+                outputPool.publish()
+
+                // Packed natively straight from the pooled buffer, no ByteArray in between
+                if (webSocketManager.isReadyForFrame()) {
+                    webSocketManager.sendFrame(
+                        frame = output,
+                        width = width,
+                        height = height,
+                        mode = mode,
+                        fps = glRenderer?.getFPS() ?: 0.0
+                    )
+                }
+
+                if (isCaptureRequested) {
+                    isCaptureRequested = false
+                    runOnUiThread { saveCurrentFrame() }
+                }
+            }
+
+            // Log every 30th frame
+            if (frameCount % 30 == 0) {
+                Log.d(TAG, "Frame #$frameCount: Processed (${NativeProcessor.modeName(mode)}), output: $written bytes")
+            }
+        } else if (written < 0) {
+            Log.e(TAG, "Frame #$frameCount: Processing failed")
+        }
+    }
+
+    private fun publishFrame(processedData: ByteArray, width: Int, height: Int) {
+        // Update GL renderer with processed frame
+        glRenderer?.updateFrame(processedData)
+        sendWebSocketFrame(processedData, width, height)
+    }
+
+    private fun sendWebSocketFrame(processedData: ByteArray, width: Int, height: Int) {
+        // Send frame via WebSocket if server is running
+        val mode = processingMode
+        val fps = glRenderer?.getFPS() ?: 0.0
+        webSocketManager.sendFrame(
+            frameData = processedData,
+            width = width,
+            height = height,
+            mode = mode,
+            fps = fps
+        )
+    }
+
     private fun toggleProcessing() {
-        isEdgeDetectionEnabled = !isEdgeDetectionEnabled
-        val mode = if (isEdgeDetectionEnabled) "Edge Detection" else "Grayscale"
+        processingMode = nextProcessingMode(processingMode)
+        val mode = NativeProcessor.modeName(processingMode)
         Toast.makeText(this, "Switched to $mode", Toast.LENGTH_SHORT).show()
         Log.d(TAG, "Processing mode: $mode")
+        // The GPU backend only implements edge detection
+        applyProcessingBackend()
+    }
+
+    private fun toggleBackend() {
+        if (gpuSurface == null) {
+            Toast.makeText(this, "GPU backend unavailable", Toast.LENGTH_SHORT).show()
+            return
+        }
+        isGpuBackendEnabled = !isGpuBackendEnabled
+        applyProcessingBackend()
+        val backend = if (isGpuBackendEnabled) "GPU" else "CPU"
+        Toast.makeText(this, "Switched to $backend backend", Toast.LENGTH_SHORT).show()
+    }
+
+    /**
+     * Follow the native thermal scheduler: Canny moves to the GPU backend while the SoC is
+     * hot and back to the CPU once it has cooled down
+     */
+    private fun onThermalCheck() {
+        val preferGpu = NativeProcessor.thermalPrefersGpu() && gpuSurface != null
+        if (preferGpu == isThermalGpu) return
+        isThermalGpu = preferGpu
+        Log.i(TAG, "Thermal scheduler: ${if (preferGpu) "moving Canny to the GPU" else "back to the CPU"}")
+        applyProcessingBackend()
     }
 
     private fun toggleWebSocketServer() {
@@ -335,6 +586,16 @@ class MainActivity : ComponentActivity() {
     }
 
     private fun captureFrame() {
+        // Pixel buffers are write-only, so ask the next CPU frame to also land in the pool
+        if (glRenderer?.isUsingPixelBuffers() == true &&
+            NativeProcessor.processingBackend == NativeProcessor.BACKEND_CPU) {
+            isCaptureRequested = true
+            return
+        }
+        saveCurrentFrame()
+    }
+
+    private fun saveCurrentFrame() {
         // Get current frame from renderer
         glRenderer?.let { renderer ->
             renderer.captureCurrentFrame { bitmap ->
@@ -370,11 +631,15 @@ class MainActivity : ComponentActivity() {
 
     override fun onDestroy() {
         super.onDestroy()
+        thermalHandler.removeCallbacks(thermalCheck)
         webSocketManager.stopServer()
         captureManager.stopCapture()
         cameraController.closeCamera()
         frameReader?.close()
+        NativeProcessor.pipelineStop()
+        NativeProcessor.setResultListener(null)
         previewSurface?.release()
+        glSurfaceView?.queueEvent { glRenderer?.release() }
         glSurfaceView?.onPause()
     }
 
@@ -399,7 +664,23 @@ class MainActivity : ComponentActivity() {
         hasPermission = true
         cameraStatus = "Opening camera..."
         Toast.makeText(this, "Camera permission granted", Toast.LENGTH_SHORT).show()
-        cameraController.openCamera()
+        // Pay for native first-frame setup before the camera opens, not on its first frames
+        val mode = processingMode
+        thread(name = "EdgeVisionWarmUp", isDaemon = true) {
+            NativeProcessor.prepare(PREVIEW_SIZE.width, PREVIEW_SIZE.height, mode)
+            // Use the GPU for Canny only where it actually beats the CPU path on this device;
+            // timed while nothing else runs, so camera frames cannot skew the choice
+            val executionMode = NativeProcessor.probeExecutionBackend(PREVIEW_SIZE.width, PREVIEW_SIZE.height)
+            if (executionMode == NativeProcessor.EXECUTION_MODE_OPENCL) {
+                NativeProcessor.prepare(PREVIEW_SIZE.width, PREVIEW_SIZE.height, mode)
+            }
+            Log.i(TAG, "Native warm-up done, Canny execution mode $executionMode")
+            runOnUiThread {
+                if (!isDestroyed) {
+                    cameraController.openCamera()
+                }
+            }
+        }
     }
 
     private fun onCameraPermissionDenied() {
@@ -473,11 +754,13 @@ fun PermissionDeniedDialog(
 fun CameraScreen(
     status: String,
     frameCount: Int,
-    isEdgeDetectionEnabled: Boolean = true,
+    nextModeLabel: String = "Sobel",
+    isGpuBackendEnabled: Boolean = false,
     isWebSocketServerRunning: Boolean = false,
     webSocketUrl: String = "Not started",
     connectedClients: Int = 0,
     onToggleProcessing: () -> Unit = {},
+    onToggleBackend: () -> Unit = {},
     onCaptureFrame: () -> Unit = {},
     onToggleWebSocket: () -> Unit = {},
     onTextureViewCreated: (TextureView) -> Unit,
@@ -490,7 +773,9 @@ fun CameraScreen(
             AndroidView(
                 factory = { context ->
                     GLSurfaceView(context).apply {
+                        // ES2-renderable config; the factory asks for ES3 (PBO uploads) first
                         setEGLContextClientVersion(2)
+                        setEGLContextFactory(EglContextFactory())
                         onGLSurfaceViewCreated(this)
                     }
                 },
@@ -566,7 +851,10 @@ fun CameraScreen(
                 horizontalArrangement = Arrangement.SpaceEvenly
             ) {
                 Button(onClick = onToggleProcessing) {
-                    Text(if (isEdgeDetectionEnabled) "Grayscale" else "Edge Det")
+                    Text(nextModeLabel)
+                }
+                Button(onClick = onToggleBackend) {
+                    Text(if (isGpuBackendEnabled) "CPU" else "GPU")
                 }
                 Button(onClick = onCaptureFrame) {
                     Text("Capture")
@@ -39,11 +39,13 @@ class CameraCaptureManager {
         cameraDevice: CameraDevice,
         reader: ImageReader,
         onSessionConfigured: (CameraCaptureSession) -> Unit,
-        onSessionFailed: () -> Unit
+        onSessionFailed: () -> Unit,
+        extraSurfaces: List<Surface> = emptyList()
     ) {
         this.imageReader = reader
 
-        val surfaces = listOf(reader.surface)
+        // Extra outputs (e.g. the GPU backend's SurfaceTexture) must be known when the session is built
+        val surfaces = listOf(reader.surface) + extraSurfaces
 
         val stateCallback = object : CameraCaptureSession.StateCallback() {
             override fun onConfigured(session: CameraCaptureSession) {
@@ -66,7 +68,7 @@ class CameraCaptureManager {
         }
     }
 
-    fun startRepeatingCapture(cameraDevice: CameraDevice, surface: Surface) {
+    fun startRepeatingCapture(cameraDevice: CameraDevice, vararg surfaces: Surface) {
         val session = captureSession ?: run {
             Log.e(TAG, "Capture session not initialized")
             return
@@ -74,7 +76,7 @@ class CameraCaptureManager {
 
         try {
             val captureRequestBuilder = cameraDevice.createCaptureRequest(CameraDevice.TEMPLATE_PREVIEW)
-            captureRequestBuilder.addTarget(surface)
+            surfaces.forEach { captureRequestBuilder.addTarget(it) }
 
             // Set auto focus and auto exposure
             captureRequestBuilder.set(
@@ -11,6 +11,13 @@ class FrameBufferQueue(private val capacity: Int = 3) {
     private val bufferQueue = ArrayBlockingQueue<FrameBuffer>(capacity)
     private var isRunning = true
 
+    /**
+     * Luma rows [first, last] the processing ROIs need (see NativeProcessor.setRegions);
+     * null copies the whole frame. Rows outside stay zero and chroma rows are limited to match.
+     */
+    @Volatile
+    var regionRows: IntRange? = null
+
     companion object {
         private const val TAG = "FrameBufferQueue"
     }
@@ -82,6 +89,9 @@ class FrameBufferQueue(private val capacity: Int = 3) {
     fun size(): Int = bufferQueue.size
 
     private fun imageToByteArray(image: Image): ByteArray {
+        // Plane buffers appended as-is: tight I420 for planar images, and for semi-planar
+        // ones (pixelStride 2) each interleaved chroma view in full; native tells the two
+        // apart by length. Color output should prefer processColorPlanesInto on the Image.
         // Get YUV planes
         val planes = image.planes
         val yPlane = planes[0].buffer
@@ -94,6 +104,15 @@ class FrameBufferQueue(private val capacity: Int = 3) {
 
         val data = ByteArray(ySize + uSize + vSize)
 
+        val rows = regionRows
+        if (rows != null) {
+            // Chroma is subsampled 2x vertically, so its rows are half the luma ones
+            copyRows(planes[0], data, 0, ySize, rows.first, rows.last + 1)
+            copyRows(planes[1], data, ySize, uSize, rows.first / 2, rows.last / 2 + 1)
+            copyRows(planes[2], data, ySize + uSize, vSize, rows.first / 2, rows.last / 2 + 1)
+            return data
+        }
+
         // Copy Y plane
         yPlane.get(data, 0, ySize)
         // Copy U plane
@@ -103,4 +122,14 @@ class FrameBufferQueue(private val capacity: Int = 3) {
 
         return data
     }
+
+    private fun copyRows(plane: Image.Plane, data: ByteArray, offset: Int, size: Int,
+                         firstRow: Int, endRow: Int) {
+        // Same layout as the full copy: rows keep their stride, only the range is read
+        val start = (firstRow * plane.rowStride).coerceIn(0, size)
+        val end = (endRow * plane.rowStride).coerceIn(start, size)
+        val source = plane.buffer.duplicate()
+        source.position(source.position() + start)
+        source.get(data, offset + start, end - start)
+    }
 }
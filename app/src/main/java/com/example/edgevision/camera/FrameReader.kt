@@ -17,6 +17,10 @@ class FrameReader(size: Size) {
 
     var onFrameAvailable: (FrameBufferQueue.FrameBuffer) -> Unit = {}
 
+    // When set, images are handed over while still open so planes can be read in place
+    // (bypasses the FrameBufferQueue copy). The image is closed after the callback returns.
+    var onImageAvailable: ((Image) -> Unit)? = null
+
     companion object {
         private const val TAG = "FrameReader"
         private const val MAX_IMAGES = 3
@@ -40,7 +44,14 @@ class FrameReader(size: Size) {
                 // Use acquireLatestImage to drop old frames automatically
                 image = reader.acquireLatestImage()
 
-                if (image != null) {
+                val directConsumer = onImageAvailable
+                if (image != null && directConsumer != null) {
+                    try {
+                        directConsumer(image)
+                    } catch (e: Exception) {
+                        Log.e(TAG, "Error in image callback", e)
+                    }
+                } else if (image != null) {
                     // Add to buffer queue
                     if (frameBufferQueue.enqueue(image)) {
                         // Dequeue and process
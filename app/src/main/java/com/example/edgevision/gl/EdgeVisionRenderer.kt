@@ -5,6 +5,9 @@ import android.graphics.Bitmap
 import android.opengl.GLES20
 import android.opengl.GLSurfaceView
 import android.util.Log
+import android.view.Surface
+import com.example.edgevision.native.FrameOutputPool
+import com.example.edgevision.native.NativeProcessor
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import java.nio.FloatBuffer
@@ -13,8 +16,9 @@ import javax.microedition.khronos.egl.EGLConfig
 import javax.microedition.khronos.opengles.GL10
 
 /**
- * OpenGL ES 2.0 renderer for EdgeVision
- * Renders processed camera frames to screen
+ * OpenGL ES renderer for EdgeVision
+ * Renders processed camera frames to screen. Drawing only uses ES 2.0; on an ES 3.0 context
+ * (see EglContextFactory) frames are uploaded through the native PBO ring
  */
 class EdgeVisionRenderer(private val context: Context) : GLSurfaceView.Renderer {
 
@@ -28,15 +32,28 @@ class EdgeVisionRenderer(private val context: Context) : GLSurfaceView.Renderer
     private var shaderProgram: ShaderProgram? = null
     private var textureManager: TextureManager? = null
     private var currentFrameData: ByteArray? = null
+    private var hasNewFrameData = false
+    private var outputPool: FrameOutputPool? = null
+    private var gpuPipeline: GpuEdgePipeline? = null
+    private var surfaceWidth = 0
+    private var surfaceHeight = 0
     private val frameLock = Any()
     private var isRendering = false
 
+    // Read by the camera thread to decide where frames are written
+    @Volatile private var pixelBuffersEnabled = false
+
     // FPS tracking
     private var frameStartTime = 0L
     private var frameCount = 0
     private var fps = 0.0
     private var droppedFrames = 0
 
+    /**
+     * Invoked on the GL thread once the GPU backend's camera surface exists
+     */
+    var onCameraSurfaceReady: ((Surface) -> Unit)? = null
+
     // Vertex coordinates (full screen quad)
     private val vertexCoords = floatArrayOf(
         -1.0f,  1.0f,  // Top left
@@ -102,13 +119,29 @@ class EdgeVisionRenderer(private val context: Context) : GLSurfaceView.Renderer
         // Initialize texture manager
         textureManager = TextureManager().apply {
             createTexture(TEXTURE_WIDTH, TEXTURE_HEIGHT)
+            pixelBuffersEnabled = enablePixelBufferUpload()
+        }
+
+        // GPU backend: camera frames go straight into a texture and are processed in shaders
+        gpuPipeline?.release()
+        gpuPipeline = GpuEdgePipeline(context, TEXTURE_WIDTH, TEXTURE_HEIGHT).let { pipeline ->
+            if (pipeline.initialize()) {
+                pipeline
+            } else {
+                Log.e(TAG, "GPU edge pipeline unavailable, CPU backend only")
+                pipeline.release()
+                null
+            }
         }
+        gpuPipeline?.getSurface()?.let { surface -> onCameraSurfaceReady?.invoke(surface) }
 
-        Log.i(TAG, "OpenGL ES 2.0 context, shaders, and textures initialized successfully")
+        Log.i(TAG, "${GLES20.glGetString(GLES20.GL_VERSION)} context, shaders, and textures initialized successfully")
     }
 
     override fun onSurfaceChanged(gl: GL10?, width: Int, height: Int) {
         Log.d(TAG, "onSurfaceChanged: ${width}x${height}")
+        surfaceWidth = width
+        surfaceHeight = height
 
         // Set viewport to match surface dimensions
         GLES20.glViewport(0, 0, width, height)
@@ -141,13 +174,32 @@ class EdgeVisionRenderer(private val context: Context) : GLSurfaceView.Renderer
             frameStartTime = currentTime
         }
 
+        // GPU backend renders offscreen first, then restores the window viewport
+        val gpuTexture = if (NativeProcessor.processingBackend == NativeProcessor.BACKEND_GPU) {
+            gpuPipeline?.process() ?: 0
+        } else {
+            0
+        }
+        if (gpuTexture != 0) {
+            GLES20.glViewport(0, 0, surfaceWidth, surfaceHeight)
+        }
+
         // Clear screen
         GLES20.glClear(GLES20.GL_COLOR_BUFFER_BIT)
 
-        // Update texture with latest frame data
-        synchronized(frameLock) {
-            currentFrameData?.let { frameData ->
-                textureManager?.updateTexture(frameData, TEXTURE_WIDTH, TEXTURE_HEIGHT)
+        // Upload only frames that are new since the last draw: pixel buffers written in place
+        // by native code first, then pooled direct buffers, then legacy ByteArrays
+        if (gpuTexture == 0 && textureManager?.updateFromPixelBuffers() != true) {
+            val pooledFrame = outputPool?.latestIfNew()
+            if (pooledFrame != null) {
+                textureManager?.updateTexture(pooledFrame, TEXTURE_WIDTH, TEXTURE_HEIGHT)
+            } else {
+                synchronized(frameLock) {
+                    currentFrameData?.takeIf { hasNewFrameData }?.let { frameData ->
+                        textureManager?.updateTexture(frameData, TEXTURE_WIDTH, TEXTURE_HEIGHT)
+                        hasNewFrameData = false
+                    }
+                }
             }
         }
 
@@ -186,7 +238,12 @@ class EdgeVisionRenderer(private val context: Context) : GLSurfaceView.Renderer
         )
 
         // Bind texture
-        textureManager?.bind()
+        if (gpuTexture != 0) {
+            GLES20.glActiveTexture(GLES20.GL_TEXTURE0)
+            GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, gpuTexture)
+        } else {
+            textureManager?.bind()
+        }
         GLES20.glUniform1i(textureHandle, 0)
 
         // Draw quad
@@ -214,9 +271,35 @@ class EdgeVisionRenderer(private val context: Context) : GLSurfaceView.Renderer
 
         synchronized(frameLock) {
             currentFrameData = frameData
+            hasNewFrameData = true
         }
     }
 
+    /**
+     * True when frame producers should write into NativeProcessor.uploaderAcquire buffers
+     */
+    fun isUsingPixelBuffers(): Boolean = pixelBuffersEnabled
+
+    /**
+     * Release GL resources; call on the GL thread
+     */
+    fun release() {
+        pixelBuffersEnabled = false
+        textureManager?.release()
+        textureManager = null
+        gpuPipeline?.release()
+        gpuPipeline = null
+        shaderProgram?.release()
+        shaderProgram = null
+    }
+
+    /**
+     * Read frames from a native output pool instead of per-frame ByteArrays
+     */
+    fun setOutputPool(pool: FrameOutputPool?) {
+        outputPool = pool
+    }
+
     /**
      * Get current FPS
      */
@@ -224,23 +307,23 @@ class EdgeVisionRenderer(private val context: Context) : GLSurfaceView.Renderer
 
     /**
      * Capture current frame as bitmap
+     * @param reuse Bitmap to write into if it is a mutable ARGB_8888 of the texture size
      */
-    fun captureCurrentFrame(callback: (Bitmap?) -> Unit) {
+    fun captureCurrentFrame(reuse: Bitmap? = null, callback: (Bitmap?) -> Unit) {
         synchronized(frameLock) {
-            currentFrameData?.let { frameData ->
+            (outputPool?.snapshot() ?: currentFrameData)?.let { frameData ->
                 try {
-                    // Create bitmap from grayscale data
-                    val bitmap = Bitmap.createBitmap(TEXTURE_WIDTH, TEXTURE_HEIGHT, Bitmap.Config.ARGB_8888)
-                    val pixels = IntArray(TEXTURE_WIDTH * TEXTURE_HEIGHT)
-
-                    // Convert grayscale to ARGB
-                    for (i in frameData.indices) {
-                        val gray = frameData[i].toInt() and 0xFF
-                        pixels[i] = (0xFF shl 24) or (gray shl 16) or (gray shl 8) or gray
+                    val bitmap = reuse?.takeIf {
+                        it.isMutable && it.config == Bitmap.Config.ARGB_8888 &&
+                            it.width == TEXTURE_WIDTH && it.height == TEXTURE_HEIGHT
+                    } ?: Bitmap.createBitmap(TEXTURE_WIDTH, TEXTURE_HEIGHT, Bitmap.Config.ARGB_8888)
+
+                    // Gray to RGBA straight into the bitmap's pixels
+                    if (NativeProcessor.grayToBitmap(frameData, TEXTURE_WIDTH, TEXTURE_HEIGHT, bitmap)) {
+                        callback(bitmap)
+                    } else {
+                        callback(null)
                     }
-
-                    bitmap.setPixels(pixels, 0, TEXTURE_WIDTH, 0, 0, TEXTURE_WIDTH, TEXTURE_HEIGHT)
-                    callback(bitmap)
                 } catch (e: Exception) {
                     Log.e(TAG, "Error capturing frame", e)
                     callback(null)
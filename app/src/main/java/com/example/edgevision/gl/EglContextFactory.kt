@@ -0,0 +1,39 @@
+package com.example.edgevision.gl
+
+import android.opengl.GLSurfaceView
+import android.util.Log
+import javax.microedition.khronos.egl.EGL10
+import javax.microedition.khronos.egl.EGLConfig
+import javax.microedition.khronos.egl.EGLContext
+import javax.microedition.khronos.egl.EGLDisplay
+
+/**
+ * Requests an OpenGL ES 3.0 context, which the PBO texture upload ring needs, and falls back
+ * to ES 2.0 on devices without it (uploads then use plain glTexSubImage2D)
+ */
+class EglContextFactory : GLSurfaceView.EGLContextFactory {
+
+    companion object {
+        private const val TAG = "EglContextFactory"
+        private const val EGL_CONTEXT_CLIENT_VERSION = 0x3098
+    }
+
+    override fun createContext(egl: EGL10, display: EGLDisplay, config: EGLConfig): EGLContext {
+        for (version in intArrayOf(3, 2)) {
+            val attributes = intArrayOf(EGL_CONTEXT_CLIENT_VERSION, version, EGL10.EGL_NONE)
+            val context = egl.eglCreateContext(display, config, EGL10.EGL_NO_CONTEXT, attributes)
+            if (context != null && context != EGL10.EGL_NO_CONTEXT) {
+                Log.i(TAG, "Created OpenGL ES $version context")
+                return context
+            }
+            Log.w(TAG, "OpenGL ES $version context unavailable: 0x${Integer.toHexString(egl.eglGetError())}")
+        }
+        return EGL10.EGL_NO_CONTEXT
+    }
+
+    override fun destroyContext(egl: EGL10, display: EGLDisplay, context: EGLContext) {
+        if (!egl.eglDestroyContext(display, context)) {
+            Log.e(TAG, "eglDestroyContext failed: 0x${Integer.toHexString(egl.eglGetError())}")
+        }
+    }
+}
@@ -0,0 +1,277 @@
+package com.example.edgevision.gl
+
+import android.content.Context
+import android.graphics.SurfaceTexture
+import android.opengl.GLES11Ext
+import android.opengl.GLES20
+import android.opengl.Matrix
+import android.util.Log
+import android.view.Surface
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
+
+/**
+ * GPU edge detection backend.
+ *
+ * The camera renders into a SurfaceTexture bound to a GL_TEXTURE_EXTERNAL_OES texture and
+ * a chain of render-to-texture passes (luma, blur H/V, Sobel, NMS + threshold, hysteresis)
+ * produces the edge map without the frame ever reaching the CPU.
+ * Hysteresis runs a fixed number of passes, so unlike cv::Canny it only keeps weak pixels
+ * within HYSTERESIS_PASSES pixels of a strong one.
+ * All methods except getSurface() must be called on the GL thread.
+ */
+class GpuEdgePipeline(
+    private val context: Context,
+    private val width: Int,
+    private val height: Int
+) {
+
+    companion object {
+        private const val TAG = "GpuEdgePipeline"
+        private const val VERTEX_SHADER = "shaders/gpu/pass_vertex.glsl"
+
+        // CPU Canny thresholds are in L1 Sobel units of 8-bit input (max 4 * 2 * 255)
+        private const val MAX_SOBEL_MAGNITUDE = 2040f
+
+        // cv::Canny follows weak chains to any length; each pass here extends them by one
+        // pixel, so weak pixels further than this from a strong one are dropped
+        private const val HYSTERESIS_PASSES = 8
+    }
+
+    private class Pass(val program: ShaderProgram) {
+        val positionHandle = program.getAttribLocation("aPosition")
+        val texCoordHandle = program.getAttribLocation("aTexCoord")
+        val textureHandle = program.getUniformLocation("uTexture")
+        val texMatrixHandle = program.getUniformLocation("uTexMatrix")
+    }
+
+    private var cameraTextureId = 0
+    private var surfaceTexture: SurfaceTexture? = null
+    private var cameraSurface: Surface? = null
+    private val frameTextures = IntArray(2)
+    private val framebuffers = IntArray(2)
+
+    private var lumaPass: Pass? = null
+    private var blurPass: Pass? = null
+    private var sobelPass: Pass? = null
+    private var nmsPass: Pass? = null
+    private var hysteresisPass: Pass? = null
+
+    private val cameraMatrix = FloatArray(16)
+    private val identityMatrix = FloatArray(16).also { Matrix.setIdentityM(it, 0) }
+
+    @Volatile private var frameAvailable = false
+    @Volatile private var lowThreshold = 50f
+    @Volatile private var highThreshold = 150f
+
+    private val quadVertices: FloatBuffer = floatBuffer(
+        floatArrayOf(-1f, 1f, -1f, -1f, 1f, 1f, 1f, -1f)
+    )
+    private val quadTexCoords: FloatBuffer = floatBuffer(
+        floatArrayOf(0f, 1f, 0f, 0f, 1f, 1f, 1f, 0f)
+    )
+
+    /**
+     * Create the camera texture, offscreen targets and pass programs
+     */
+    fun initialize(): Boolean {
+        val textures = IntArray(1)
+        GLES20.glGenTextures(1, textures, 0)
+        cameraTextureId = textures[0]
+        GLES20.glBindTexture(GLES11Ext.GL_TEXTURE_EXTERNAL_OES, cameraTextureId)
+        setSamplingParameters(GLES11Ext.GL_TEXTURE_EXTERNAL_OES)
+        GLES20.glBindTexture(GLES11Ext.GL_TEXTURE_EXTERNAL_OES, 0)
+
+        surfaceTexture = SurfaceTexture(cameraTextureId).apply {
+            setDefaultBufferSize(width, height)
+            setOnFrameAvailableListener { frameAvailable = true }
+        }
+        cameraSurface = Surface(surfaceTexture)
+
+        // Ping-pong RGBA targets (LUMINANCE is not color-renderable in GLES 2.0)
+        GLES20.glGenTextures(2, frameTextures, 0)
+        GLES20.glGenFramebuffers(2, framebuffers, 0)
+        for (i in 0 until 2) {
+            GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, frameTextures[i])
+            setSamplingParameters(GLES20.GL_TEXTURE_2D)
+            GLES20.glTexImage2D(
+                GLES20.GL_TEXTURE_2D, 0, GLES20.GL_RGBA, width, height, 0,
+                GLES20.GL_RGBA, GLES20.GL_UNSIGNED_BYTE, null
+            )
+
+            GLES20.glBindFramebuffer(GLES20.GL_FRAMEBUFFER, framebuffers[i])
+            GLES20.glFramebufferTexture2D(
+                GLES20.GL_FRAMEBUFFER, GLES20.GL_COLOR_ATTACHMENT0,
+                GLES20.GL_TEXTURE_2D, frameTextures[i], 0
+            )
+            val status = GLES20.glCheckFramebufferStatus(GLES20.GL_FRAMEBUFFER)
+            if (status != GLES20.GL_FRAMEBUFFER_COMPLETE) {
+                Log.e(TAG, "Framebuffer $i incomplete: 0x${Integer.toHexString(status)}")
+                GLES20.glBindFramebuffer(GLES20.GL_FRAMEBUFFER, 0)
+                return false
+            }
+        }
+        GLES20.glBindFramebuffer(GLES20.GL_FRAMEBUFFER, 0)
+        GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, 0)
+
+        lumaPass = createPass("shaders/gpu/luma_fragment.glsl") ?: return false
+        blurPass = createPass("shaders/gpu/blur_fragment.glsl") ?: return false
+        sobelPass = createPass("shaders/gpu/sobel_fragment.glsl") ?: return false
+        nmsPass = createPass("shaders/gpu/nms_fragment.glsl") ?: return false
+        hysteresisPass = createPass("shaders/gpu/hysteresis_fragment.glsl") ?: return false
+
+        Log.i(TAG, "GPU edge pipeline initialized: ${width}x${height}")
+        return true
+    }
+
+    /**
+     * Surface the camera capture session should render into
+     */
+    fun getSurface(): Surface? = cameraSurface
+
+    /**
+     * Same threshold scale as EdgeProcessor::setCannyThresholds
+     */
+    fun setCannyThresholds(low: Float, high: Float) {
+        lowThreshold = low
+        highThreshold = high
+    }
+
+    /**
+     * Run all passes on the newest camera frame
+     * @return Texture holding the edge map, or 0 if no frame has arrived yet
+     */
+    fun process(): Int {
+        val texture = surfaceTexture ?: return 0
+        if (frameAvailable) {
+            frameAvailable = false
+            texture.updateTexImage()
+            texture.getTransformMatrix(cameraMatrix)
+        } else if (texture.timestamp == 0L) {
+            return 0
+        }
+
+        GLES20.glViewport(0, 0, width, height)
+        GLES20.glDisable(GLES20.GL_BLEND)
+
+        val texelWidth = 1f / width
+        val texelHeight = 1f / height
+
+        // Camera -> luma (0)
+        runPass(lumaPass!!, GLES11Ext.GL_TEXTURE_EXTERNAL_OES, cameraTextureId, 0, cameraMatrix)
+
+        // Separable blur: 0 -> 1 -> 0
+        runPass(blurPass!!, GLES20.GL_TEXTURE_2D, frameTextures[0], 1, identityMatrix) { program ->
+            GLES20.glUniform2f(program.getUniformLocation("uTexelStep"), texelWidth, 0f)
+        }
+        runPass(blurPass!!, GLES20.GL_TEXTURE_2D, frameTextures[1], 0, identityMatrix) { program ->
+            GLES20.glUniform2f(program.getUniformLocation("uTexelStep"), 0f, texelHeight)
+        }
+
+        // Sobel magnitude/direction: 0 -> 1
+        runPass(sobelPass!!, GLES20.GL_TEXTURE_2D, frameTextures[0], 1, identityMatrix) { program ->
+            GLES20.glUniform2f(program.getUniformLocation("uTexelSize"), texelWidth, texelHeight)
+        }
+
+        // Non-maximum suppression + double threshold: 1 -> 0
+        runPass(nmsPass!!, GLES20.GL_TEXTURE_2D, frameTextures[1], 0, identityMatrix) { program ->
+            GLES20.glUniform2f(program.getUniformLocation("uTexelSize"), texelWidth, texelHeight)
+            GLES20.glUniform1f(program.getUniformLocation("uLowThreshold"), lowThreshold / MAX_SOBEL_MAGNITUDE)
+            GLES20.glUniform1f(program.getUniformLocation("uHighThreshold"), highThreshold / MAX_SOBEL_MAGNITUDE)
+        }
+
+        // Hysteresis, ping-ponging from 0; the last pass writes the binary edge map
+        var input = 0
+        for (pass in 0 until HYSTERESIS_PASSES) {
+            val finalPass = if (pass == HYSTERESIS_PASSES - 1) 1f else 0f
+            runPass(hysteresisPass!!, GLES20.GL_TEXTURE_2D, frameTextures[input], 1 - input, identityMatrix) { program ->
+                GLES20.glUniform2f(program.getUniformLocation("uTexelSize"), texelWidth, texelHeight)
+                GLES20.glUniform1f(program.getUniformLocation("uFinalPass"), finalPass)
+            }
+            input = 1 - input
+        }
+
+        GLES20.glBindFramebuffer(GLES20.GL_FRAMEBUFFER, 0)
+        GLES20.glEnable(GLES20.GL_BLEND)
+        return frameTextures[input]
+    }
+
+    /**
+     * Release GL objects and the camera surface
+     */
+    fun release() {
+        listOfNotNull(lumaPass, blurPass, sobelPass, nmsPass, hysteresisPass).forEach { it.program.release() }
+        lumaPass = null
+        blurPass = null
+        sobelPass = null
+        nmsPass = null
+        hysteresisPass = null
+
+        GLES20.glDeleteFramebuffers(2, framebuffers, 0)
+        GLES20.glDeleteTextures(2, frameTextures, 0)
+        GLES20.glDeleteTextures(1, intArrayOf(cameraTextureId), 0)
+        cameraSurface?.release()
+        surfaceTexture?.release()
+        cameraSurface = null
+        surfaceTexture = null
+        Log.d(TAG, "GPU edge pipeline released")
+    }
+
+    private fun createPass(fragmentShaderPath: String): Pass? {
+        val program = ShaderProgram(context)
+        if (!program.loadShaders(VERTEX_SHADER, fragmentShaderPath) || !program.linkProgram()) {
+            Log.e(TAG, "Failed to build pass $fragmentShaderPath")
+            return null
+        }
+        return Pass(program)
+    }
+
+    private fun runPass(
+        pass: Pass,
+        inputTarget: Int,
+        inputTexture: Int,
+        outputIndex: Int,
+        texMatrix: FloatArray,
+        setUniforms: (ShaderProgram) -> Unit = {}
+    ) {
+        GLES20.glBindFramebuffer(GLES20.GL_FRAMEBUFFER, framebuffers[outputIndex])
+        pass.program.use()
+
+        GLES20.glActiveTexture(GLES20.GL_TEXTURE0)
+        GLES20.glBindTexture(inputTarget, inputTexture)
+        GLES20.glUniform1i(pass.textureHandle, 0)
+        GLES20.glUniformMatrix4fv(pass.texMatrixHandle, 1, false, texMatrix, 0)
+        setUniforms(pass.program)
+
+        GLES20.glEnableVertexAttribArray(pass.positionHandle)
+        GLES20.glEnableVertexAttribArray(pass.texCoordHandle)
+        quadVertices.position(0)
+        GLES20.glVertexAttribPointer(pass.positionHandle, 2, GLES20.GL_FLOAT, false, 0, quadVertices)
+        quadTexCoords.position(0)
+        GLES20.glVertexAttribPointer(pass.texCoordHandle, 2, GLES20.GL_FLOAT, false, 0, quadTexCoords)
+
+        GLES20.glDrawArrays(GLES20.GL_TRIANGLE_STRIP, 0, 4)
+
+        GLES20.glDisableVertexAttribArray(pass.positionHandle)
+        GLES20.glDisableVertexAttribArray(pass.texCoordHandle)
+        GLES20.glBindTexture(inputTarget, 0)
+    }
+
+    private fun setSamplingParameters(target: Int) {
+        // Nearest sampling keeps every tap on an exact texel; clamp gives replicate borders
+        GLES20.glTexParameteri(target, GLES20.GL_TEXTURE_MIN_FILTER, GLES20.GL_NEAREST)
+        GLES20.glTexParameteri(target, GLES20.GL_TEXTURE_MAG_FILTER, GLES20.GL_NEAREST)
+        GLES20.glTexParameteri(target, GLES20.GL_TEXTURE_WRAP_S, GLES20.GL_CLAMP_TO_EDGE)
+        GLES20.glTexParameteri(target, GLES20.GL_TEXTURE_WRAP_T, GLES20.GL_CLAMP_TO_EDGE)
+    }
+
+    private fun floatBuffer(values: FloatArray): FloatBuffer =
+        ByteBuffer.allocateDirect(values.size * 4)
+            .order(ByteOrder.nativeOrder())
+            .asFloatBuffer()
+            .apply {
+                put(values)
+                position(0)
+            }
+}
@@ -2,6 +2,7 @@ package com.example.edgevision.gl
 
 import android.opengl.GLES20
 import android.util.Log
+import com.example.edgevision.native.NativeProcessor
 import java.nio.ByteBuffer
 
 /**
@@ -16,6 +17,8 @@ class TextureManager {
     private var textureId: Int = 0
     private var textureWidth: Int = 0
     private var textureHeight: Int = 0
+    private var stagingBuffer: ByteBuffer? = null
+    private var usePixelBuffers = false
 
     /**
      * Create OpenGL texture
@@ -79,8 +82,10 @@ class TextureManager {
         // Bind texture
         GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, textureId)
 
-        // Create ByteBuffer from frame data
-        val buffer = ByteBuffer.allocateDirect(frameData.size)
+        // Reuse one staging buffer instead of allocating a direct buffer per frame
+        val buffer = stagingBuffer?.takeIf { it.capacity() == frameData.size }
+            ?: ByteBuffer.allocateDirect(frameData.size).also { stagingBuffer = it }
+        buffer.clear()
         buffer.put(frameData)
         buffer.position(0)
 
@@ -101,6 +106,65 @@ class TextureManager {
         GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, 0)
     }
 
+    /**
+     * Update texture straight from a direct buffer (no staging copy)
+     */
+    fun updateTexture(frameData: ByteBuffer, width: Int, height: Int) {
+        if (textureId == 0) {
+            Log.e(TAG, "Texture not initialized")
+            return
+        }
+
+        if (width != textureWidth || height != textureHeight) {
+            Log.w(TAG, "Frame size mismatch: expected ${textureWidth}x${textureHeight}, got ${width}x${height}")
+            return
+        }
+
+        GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, textureId)
+        GLES20.glTexSubImage2D(
+            GLES20.GL_TEXTURE_2D,
+            0,
+            0,
+            0,
+            width,
+            height,
+            GLES20.GL_LUMINANCE,
+            GLES20.GL_UNSIGNED_BYTE,
+            frameData
+        )
+        GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, 0)
+    }
+
+    /**
+     * Switch uploads to the native pixel buffer ring (OpenGL ES 3.0+ only)
+     * @return true if the ring was created
+     */
+    fun enablePixelBufferUpload(): Boolean {
+        if (textureId == 0) {
+            Log.e(TAG, "Texture not initialized")
+            return false
+        }
+        usePixelBuffers = NativeProcessor.uploaderInitialize(textureWidth, textureHeight)
+        Log.i(TAG, "Pixel buffer upload: ${if (usePixelBuffers) "enabled" else "unavailable"}")
+        return usePixelBuffers
+    }
+
+    /**
+     * True when producers should write frames via NativeProcessor.uploaderAcquire
+     */
+    fun isUsingPixelBuffers(): Boolean = usePixelBuffers
+
+    /**
+     * Upload the newest frame published to the pixel buffer ring, if any
+     * @return true if the texture changed
+     */
+    fun updateFromPixelBuffers(): Boolean {
+        if (!usePixelBuffers || textureId == 0) {
+            return false
+        }
+        return NativeProcessor.uploaderUpdate(textureId)
+    }
+
     /**
      * Bind texture for rendering
      */
@@ -125,6 +189,11 @@ class TextureManager {
      * Release texture resources
      */
     fun release() {
+        if (usePixelBuffers) {
+            NativeProcessor.uploaderRelease()
+            usePixelBuffers = false
+        }
+        stagingBuffer = null
         if (textureId != 0) {
             val textures = intArrayOf(textureId)
             GLES20.glDeleteTextures(1, textures, 0)
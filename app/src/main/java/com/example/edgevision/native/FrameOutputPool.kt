@@ -0,0 +1,83 @@
+package com.example.edgevision.native
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Triple-buffered pool of direct ByteBuffers that native code writes processed frames into.
+ *
+ * The producer always owns the back buffer, the consumer always owns the front buffer and
+ * the pending slot is handed between them under a lock, so a buffer is never written while
+ * it is being read and no per-frame allocation happens once the pool is sized.
+ */
+class FrameOutputPool {
+
+    private val lock = Any()
+    private var back: ByteBuffer? = null
+    private var pending: ByteBuffer? = null
+    private var front: ByteBuffer? = null
+    private var hasPending = false
+
+    /**
+     * Producer side: buffer to write the next frame into (reallocated only on size change)
+     */
+    fun writeBuffer(size: Int): ByteBuffer {
+        val current = back
+        if (current != null && current.capacity() == size) {
+            current.clear()
+            return current
+        }
+        return allocate(size).also { back = it }
+    }
+
+    /**
+     * Producer side: publish the back buffer as the latest frame
+     */
+    fun publish() {
+        synchronized(lock) {
+            val written = back
+            back = pending
+            pending = written
+            hasPending = true
+        }
+    }
+
+    /**
+     * Consumer side: latest published frame, or the previous one if nothing new arrived
+     */
+    fun latest(): ByteBuffer? {
+        synchronized(lock) {
+            if (hasPending) {
+                val ready = pending
+                pending = front
+                front = ready
+                hasPending = false
+            }
+            return front?.also { it.position(0) }
+        }
+    }
+
+    /**
+     * Consumer side: latest published frame only if it has not been returned before
+     */
+    fun latestIfNew(): ByteBuffer? {
+        synchronized(lock) {
+            return if (hasPending) latest() else null
+        }
+    }
+
+    /**
+     * Copy of the most recent frame for snapshot/export
+     */
+    fun snapshot(): ByteArray? {
+        synchronized(lock) {
+            val source = (if (hasPending) pending else front) ?: return null
+            val copy = ByteArray(source.capacity())
+            source.duplicate().apply { position(0) }.get(copy)
+            return copy
+        }
+    }
+
+    private fun allocate(size: Int): ByteBuffer =
+        ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder())
+}
@@ -1,6 +1,7 @@
 package com.example.edgevision.native
 
 import android.graphics.Bitmap
+import java.nio.ByteBuffer
 
 /**
  * JNI interface for native OpenCV image processing
@@ -11,6 +12,21 @@ object NativeProcessor {
         System.loadLibrary("edgevision")
     }
 
+    /**
+     * Process a frame in any grayscale-output mode (Canny, grayscale or one of the filters)
+     * @param inputData YUV frame data
+     * @param width Frame width
+     * @param height Frame height
+     * @param mode PROCESSING_TYPE_* other than PROCESSING_TYPE_ORIGINAL
+     * @return Processed frame data (width * height bytes), or null on failure
+     */
+    external fun processFrame(
+        inputData: ByteArray,
+        width: Int,
+        height: Int,
+        mode: Int
+    ): ByteArray?
+
     /**
      * Process frame with Canny edge detection
      * @param inputData YUV frame data
@@ -38,19 +54,479 @@ object NativeProcessor {
     ): ByteArray?
 
     /**
-     * Process frame and return as Bitmap
+     * Process the camera Y plane directly from its Image.Plane buffer (no input copy)
+     * @param yBuffer Direct ByteBuffer of the Y plane (Image.planes[0].buffer)
+     * @param rowStride Bytes between the starts of consecutive rows
+     * @param pixelStride Bytes between adjacent pixels in a row
+     * @param width Frame width
+     * @param height Frame height
+     * @param mode PROCESSING_TYPE_* other than PROCESSING_TYPE_ORIGINAL
+     * @return Processed frame data (tightly packed, width * height bytes)
+     */
+    external fun processPlanes(
+        yBuffer: ByteBuffer,
+        rowStride: Int,
+        pixelStride: Int,
+        width: Int,
+        height: Int,
+        mode: Int
+    ): ByteArray?
+
+    /**
+     * processFrame written into a caller-owned direct ByteBuffer (no output allocation)
+     * @param output Direct ByteBuffer with at least width * height bytes
+     * @return Number of bytes written, or -1 on failure
+     */
+    external fun processFrameInto(
+        inputData: ByteArray,
+        width: Int,
+        height: Int,
+        mode: Int,
+        output: ByteBuffer
+    ): Int
+
+    /**
+     * Canny edge detection written into a caller-owned direct ByteBuffer (no output allocation)
+     * @param inputData YUV frame data
+     * @param width Frame width
+     * @param height Frame height
+     * @param output Direct ByteBuffer with at least width * height bytes
+     * @return Number of bytes written, or -1 on failure
+     */
+    external fun processFrameCannyInto(
+        inputData: ByteArray,
+        width: Int,
+        height: Int,
+        output: ByteBuffer
+    ): Int
+
+    /**
+     * Grayscale conversion written into a caller-owned direct ByteBuffer (no output allocation)
      * @param inputData YUV frame data
      * @param width Frame width
      * @param height Frame height
+     * @param output Direct ByteBuffer with at least width * height bytes
+     * @return Number of bytes written, or -1 on failure
+     */
+    external fun processFrameGrayscaleInto(
+        inputData: ByteArray,
+        width: Int,
+        height: Int,
+        output: ByteBuffer
+    ): Int
+
+    /**
+     * Zero-copy in and out: process the Y plane in place into a caller-owned direct ByteBuffer
+     * @param output Direct ByteBuffer with at least width * height bytes (see FrameOutputPool)
+     * @return Number of bytes written, or -1 on failure
+     */
+    external fun processPlanesInto(
+        yBuffer: ByteBuffer,
+        rowStride: Int,
+        pixelStride: Int,
+        width: Int,
+        height: Int,
+        mode: Int,
+        output: ByteBuffer
+    ): Int
+
+    /**
+     * PROCESSING_TYPE_ORIGINAL from the camera planes: YUV_420_888 to RGBA without
+     * repacking, for both planar (uvPixelStride 1) and semi-planar NV12/NV21 (2) layouts
+     * @param uvRowStride Row stride of the U and V planes (Image.Plane.rowStride)
+     * @param uvPixelStride Pixel stride of the U and V planes (Image.Plane.pixelStride)
+     * @param output Direct ByteBuffer with at least width * height * 4 bytes
+     * @return Number of bytes written, or -1 on failure
+     */
+    external fun processColorPlanesInto(
+        yBuffer: ByteBuffer,
+        uBuffer: ByteBuffer,
+        vBuffer: ByteBuffer,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        width: Int,
+        height: Int,
+        output: ByteBuffer
+    ): Int
+
+    /**
+     * Create an independent native processing session with its own buffers, execution
+     * settings and core affinity, so several streams (e.g. front and back camera) can be
+     * processed concurrently. The handle-less functions use a shared default session.
+     * @return Opaque handle for the session* functions, or 0 on failure
+     */
+    external fun create(): Long
+
+    /**
+     * Free a session from create(); no call on it may still be running
+     */
+    external fun destroy(handle: Long)
+
+    /**
+     * processPlanesInto on a session from create(); calls on one session are serialized,
+     * calls on different sessions run in parallel
+     * @return Number of bytes written, or -1 on failure
+     */
+    external fun sessionProcessPlanesInto(
+        handle: Long,
+        yBuffer: ByteBuffer,
+        rowStride: Int,
+        pixelStride: Int,
+        width: Int,
+        height: Int,
+        mode: Int,
+        output: ByteBuffer
+    ): Int
+
+    /**
+     * setExecutionMode for one session
+     */
+    external fun sessionSetExecutionMode(handle: Long, mode: Int)
+
+    /**
+     * setAutoThreshold for one session
+     */
+    external fun sessionSetAutoThreshold(handle: Long, enabled: Boolean)
+
+    /**
+     * setThreadCount (tiled execution only) for one session: sets its band count, while
+     * the pool that runs the bands is sized by setThreadCount
+     */
+    external fun sessionSetThreadCount(handle: Long, threads: Int)
+
+    /**
+     * Run Canny only inside regions of interest, so cost scales with ROI area (handle-less
+     * calls; the staged pipeline always processes full frames)
+     * @param rects Flat [x, y, width, height, ...] in pixels, clipped to each frame; null = whole frame
+     * @param compact false: full frame with everything outside the ROIs zeroed;
+     *                true: the ROIs packed row by row, back to back in rects order
+     *                (the *Into calls then return the packed byte count)
+     * @return false if rects is not a multiple of 4 values
+     */
+    external fun setRegions(rects: IntArray?, compact: Boolean): Boolean
+
+    /**
+     * setRegions for a session from create()
+     */
+    external fun sessionSetRegions(handle: Long, rects: IntArray?, compact: Boolean): Boolean
+
+    /**
+     * Cores that threads run on while inside this session's calls; each call restores the
+     * calling thread's previous affinity when it returns
+     * @param affinity AFFINITY_ANY, AFFINITY_BIG or AFFINITY_LITTLE
+     */
+    external fun sessionSetCoreAffinity(handle: Long, affinity: Int)
+
+    /**
+     * Process a batch of frames (e.g. a recorded clip) in one native call, spread over
+     * worker threads (see setThreadCount)
+     * @param frames Direct ByteBuffers, each a width x height Y plane with rowStride
+     * @param mode PROCESSING_TYPE_* other than PROCESSING_TYPE_ORIGINAL
+     * @param output Direct ByteBuffer arena of at least frames.size * width * height bytes;
+     *               result i starts at i * width * height (see batchResult)
+     * @return Number of frames processed, or -1 on failure
+     */
+    external fun processBatch(
+        frames: Array<ByteBuffer>,
+        rowStride: Int,
+        width: Int,
+        height: Int,
+        mode: Int,
+        output: ByteBuffer
+    ): Int
+
+    /**
+     * View of result index in a processBatch output arena (shares memory, no copy)
+     */
+    fun batchResult(output: ByteBuffer, index: Int, width: Int, height: Int): ByteBuffer {
+        val frameBytes = width * height
+        val view = output.duplicate()
+        view.position(index * frameBytes)
+        view.limit((index + 1) * frameBytes)
+        return view.slice()
+    }
+
+    /**
+     * Do the first-frame work for handle-less calls ahead of time: size and fault in the
+     * native buffers, start OpenCV's worker threads and run dummy frames (compiling OpenCL
+     * kernels in EXECUTION_MODE_OPENCL); for Canny the pipeline's slots and stages are
+     * warmed the same way unless it is running. Blocks for tens of milliseconds, so call it
+     * off the main thread and before frames arrive (e.g. before opening the camera); the
+     * dummy frames are not counted in the stage stats.
+     * @param mode PROCESSING_TYPE_* the first frames will use
+     * @return false for an invalid size or mode
+     */
+    external fun prepare(width: Int, height: Int, mode: Int): Boolean
+
+    /**
+     * Derive Canny thresholds from the frame's median gradient magnitude (smoothed across
+     * frames, never below the fixed 50/150, so only noisy or busy scenes raise them);
+     * applies to handle-less calls, the pipeline and processBatch (per frame there)
+     * @param enabled true for automatic thresholds
+     */
+    external fun setAutoThreshold(enabled: Boolean)
+
+    /**
+     * Select how Canny runs natively; the pipeline's Canny stage follows OpenCL vs CPU
+     * (its CPU path is always OpenCV's)
+     * @param mode EXECUTION_MODE_OPENCV, EXECUTION_MODE_TILED, EXECUTION_MODE_FUSED or
+     *        EXECUTION_MODE_OPENCL (falls back to the CPU when the device has no OpenCL)
+     */
+    external fun setExecutionMode(mode: Int)
+
+    /**
+     * Time the current CPU execution mode against EXECUTION_MODE_OPENCL on synthetic frames
+     * and keep the faster one for the default session and the pipeline's Canny stage; the
+     * timings appear under "backend" in getStats.
+     * Blocks for up to a few seconds on first use (OpenCL kernel compilation), so call it off
+     * the main thread, and before the camera starts so live frames do not skew the timings.
+     * Probe frames are not counted in the stage histograms.
+     * @return Selected execution mode, or -1 on failure
+     */
+    external fun probeExecutionBackend(width: Int, height: Int): Int
+
+    /**
+     * Worker threads for parallel execution modes and processBatch; fewer threads trade latency for power.
+     * Also sizes OpenCV's shared thread pool, which every session runs on
+     * @param threads Thread count, 0 = one per CPU
+     */
+    external fun setThreadCount(threads: Int)
+
+    /**
+     * Frame budget for the native governors (pipeline and handle-less calls): over budget
+     * Canny runs on a 1/2 or 1/4 resolution pyramid level, then only on every Nth frame;
+     * decisions appear under "governor" in getStats
+     * @param fps Target frame rate, 0 = always full resolution, every frame
+     */
+    external fun setTargetFps(fps: Float)
+
+    /**
+     * Thermal scheduling: from AThermal status and headroom forecast, step Canny down to 1/2
+     * then 1/4 resolution and every 2nd frame, move the pipeline's blur/Canny stages to the
+     * little cores and recommend the GPU backend (thermalPrefersGpu), all before the SoC
+     * throttles; state appears under "thermal" in getStats
+     * @return false if the device has no AThermal (API < 30); scheduling stays off
+     */
+    external fun setThermalScheduling(enabled: Boolean): Boolean
+
+    /**
+     * Whether thermal scheduling currently recommends the GPU backend for Canny
+     */
+    external fun thermalPrefersGpu(): Boolean
+
+    /**
+     * Start the staged native Canny pipeline (ingest -> blur -> detect -> output)
+     * @param width Frame width
+     * @param height Frame height
+     * @return true if the pipeline is running
+     */
+    external fun pipelineStart(width: Int, height: Int): Boolean
+
+    /**
+     * Copy the Y plane into the pipeline and return immediately
+     * @param timestampNs Camera timestamp, returned again by pipelinePoll
+     * @return false if the frame was dropped because every slot is in flight
+     */
+    external fun pipelineSubmit(
+        yBuffer: ByteBuffer,
+        rowStride: Int,
+        pixelStride: Int,
+        width: Int,
+        height: Int,
+        timestampNs: Long
+    ): Boolean
+
+    /**
+     * Copy the newest completed frame into a direct ByteBuffer
+     * @return Timestamp of that frame, or -1 if nothing new is ready (always -1 while a
+     *         ResultListener is set, since results go to the listener instead)
+     */
+    external fun pipelinePoll(output: ByteBuffer): Long
+
+    /**
+     * Receives pipeline results on the native output thread as soon as they complete
+     */
+    fun interface ResultListener {
+        /**
+         * @param frame Direct ByteBuffer over the native result, only valid during the call;
+         *              it is reused for later frames, so rewind() before relative reads
+         * @param timestampNs Camera timestamp passed to pipelineSubmit
+         */
+        fun onFrameProcessed(frame: ByteBuffer, width: Int, height: Int, timestampNs: Long)
+    }
+
+    /**
+     * Deliver pipeline results to a listener instead of the pipelinePoll mailbox; only
+     * while the pipeline is stopped. Pass null to clear it (releases the listener reference).
+     * @return false if the pipeline is running or the listener could not be registered
+     */
+    external fun setResultListener(listener: ResultListener?): Boolean
+
+    /**
+     * Stop the pipeline threads
+     */
+    external fun pipelineStop()
+
+    /**
+     * Capture the exact input Y planes of grayscale-output processFrame*, processPlanes*
+     * and pipelineSubmit calls, with timestamps, into a preallocated memory-mapped file (no
+     * per-frame syscalls); replay it with replayOpen or the host benchmark's --input
+     * @param path Output file, truncated; space for maxFrames frames is reserved up front
+     * @return false if the file could not be created or reserved
+     */
+    external fun recordingStart(path: String, width: Int, height: Int, maxFrames: Int): Boolean
+
+    /**
+     * Finish the recording started by recordingStart
+     * @return Number of frames recorded
+     */
+    external fun recordingStop(): Int
+
+    /**
+     * Open a recording for replayNextInto
+     * @param paced true to replay at the recorded cadence, false as fast as frames are pulled
+     * @return [width, height, frameCount], or null if path is not a recording
+     */
+    external fun replayOpen(path: String, paced: Boolean): IntArray?
+
+    /**
+     * Process the next recorded frame with the given PROCESSING_TYPE_* into a direct
+     * ByteBuffer of width * height bytes, on the same native path as processPlanesInto
+     * (including automatic thresholds); blocks until its recorded time when paced
+     * @return Bytes written, 0 at the end of the recording, -1 on failure
+     */
+    external fun replayNextInto(processingType: Int, outputBuffer: ByteBuffer): Int
+
+    /**
+     * Release the recording opened by replayOpen
+     */
+    external fun replayClose()
+
+    /**
+     * Pack a processed frame into the binary WebSocket format (see FrameProtocol)
+     * @param frame Direct ByteBuffer with width * height processed bytes
+     * @param width Frame width
+     * @param height Frame height
+     * @param mode PROCESSING_TYPE_* the frame was produced with
+     * @param timestampMs Frame timestamp in milliseconds since the epoch
+     * @param fps Current FPS
+     * @param encoding FrameProtocol.ENCODING_* for the payload
+     * @param level Output pyramid level, 0..FrameProtocol.MAX_LEVEL (1/2^level per side); levels
+     *              are built once per frame (timestampMs) and shared by every call for it
+     * @param packet Direct ByteBuffer with at least FrameProtocol.maxPacketSize of the level's size
+     * @return Packet length in bytes, 0 when a video encoder (ENCODING_H264/HEVC) has no output
+     *         ready yet, or -1 on failure
+     */
+    external fun encodeFrame(
+        frame: ByteBuffer,
+        width: Int,
+        height: Int,
+        mode: Int,
+        timestampMs: Long,
+        fps: Float,
+        encoding: Int,
+        level: Int,
+        packet: ByteBuffer
+    ): Int
+
+    /**
+     * Make the next packet of one stream a keyframe for all of its clients: all tiles for
+     * ENCODING_TILE_DELTA, a sync frame for ENCODING_H264/HEVC (arrives a frame or two later)
+     * @param encoding FrameProtocol.ENCODING_TILE_DELTA, ENCODING_H264 or ENCODING_HEVC
+     * @param level Output pyramid level of the stream
+     */
+    external fun requestKeyframe(encoding: Int, level: Int)
+
+    /**
+     * Build an ENCODING_TILE_DELTA keyframe of the frame the level's delta stream encoded
+     * last (call after encodeFrame for that frame), for clients that lost their reference;
+     * the stream's other clients keep receiving deltas
+     * @param packet Direct ByteBuffer with at least FrameProtocol.maxPacketSize of the level's size
+     * @return Packet length, 0 if the stream has no frame yet, or -1 on failure
+     */
+    external fun encodeKeyframe(mode: Int, timestampMs: Long, fps: Float, level: Int, packet: ByteBuffer): Int
+
+    /**
+     * Free the hardware video encoders (ENCODING_H264/HEVC streams) that have not encoded
+     * a frame for idleMs; call periodically, since an unused stream is never fed again
+     * @param idleMs Idle time in milliseconds, 0 = release every encoder
+     */
+    external fun releaseIdleVideoEncoders(idleMs: Long)
+
+    /**
+     * Native latency statistics as JSON: frame and drop counters plus count, mean, p50, p95,
+     * p99 and max in microseconds per stage (copyIn, blur, canny, copyOut, encode, upload, total),
+     * plus the active governor's target, average latency, pyramid level and skip interval
+     */
+    external fun getStats(): String
+
+    /**
+     * Clear the native latency histograms and counters
+     */
+    external fun resetStats()
+
+    /**
+     * Create the pixel buffer (PBO) ring for the current GL context; call on the GL thread
+     * @param width Frame width
+     * @param height Frame height
+     * @return false if the context is not OpenGL ES 3.0+ (callers keep the client-memory upload)
+     */
+    external fun uploaderInitialize(width: Int, height: Int): Boolean
+
+    /**
+     * Upload the newest published pixel buffer into a GL_LUMINANCE texture; call on the GL thread
+     * @param textureId Texture created with the same size as the ring
+     * @return true if a new frame was uploaded
+     */
+    external fun uploaderUpdate(textureId: Int): Boolean
+
+    /**
+     * Delete the pixel buffer ring; call on the GL thread
+     */
+    external fun uploaderRelease()
+
+    /**
+     * Claim a mapped pixel buffer to write the next frame into (GPU-visible memory)
+     * @return Direct ByteBuffer valid until uploaderPublish, or null if no buffer is mapped
+     */
+    external fun uploaderAcquire(): ByteBuffer?
+
+    /**
+     * Hand the buffer from uploaderAcquire to the GL thread
+     * @param written false to return it without a new frame
+     */
+    external fun uploaderPublish(written: Boolean)
+
+    /**
+     * Process a frame straight into a reusable Bitmap (native pixel writes, no copies)
+     * @param inputData YUV frame data (I420, or FrameBufferQueue's semi-planar layout)
+     * @param width Frame width
+     * @param height Frame height
      * @param processingType 0=Canny, 1=Grayscale, 2=Original
-     * @return Processed bitmap
+     * @param output Mutable ARGB_8888 Bitmap of exactly width x height
+     * @return true if output now holds the frame
      */
     external fun processFrameToBitmap(
         inputData: ByteArray,
         width: Int,
         height: Int,
-        processingType: Int
-    ): Bitmap?
+        processingType: Int,
+        output: Bitmap
+    ): Boolean
+
+    /**
+     * Expand an already processed gray frame into a reusable Bitmap (snapshot/export)
+     * @param grayData At least width * height bytes
+     * @param output Mutable ARGB_8888 Bitmap of exactly width x height
+     * @return true if output now holds the frame
+     */
+    external fun grayToBitmap(
+        grayData: ByteArray,
+        width: Int,
+        height: Int,
+        output: Bitmap
+    ): Boolean
 
     /**
      * Test native library connection
@@ -62,4 +538,48 @@ object NativeProcessor {
     const val PROCESSING_TYPE_CANNY = 0
     const val PROCESSING_TYPE_GRAYSCALE = 1
     const val PROCESSING_TYPE_ORIGINAL = 2
+    const val PROCESSING_TYPE_SOBEL = 3 // 3x3 blur + gradient magnitude
+    const val PROCESSING_TYPE_LAPLACIAN = 4 // 3x3 blur + |Laplacian|
+    const val PROCESSING_TYPE_THRESHOLD = 5 // 5x5 blur + binary threshold
+
+    /**
+     * Whether a mode produces a binary 0/255 map (bit-packed WebSocket codecs are lossless)
+     */
+    fun isBinaryOutput(mode: Int): Boolean =
+        mode == PROCESSING_TYPE_CANNY || mode == PROCESSING_TYPE_THRESHOLD
+
+    /**
+     * Display name of a processing mode
+     */
+    fun modeName(mode: Int): String = when (mode) {
+        PROCESSING_TYPE_CANNY -> "Edge Detection"
+        PROCESSING_TYPE_GRAYSCALE -> "Grayscale"
+        PROCESSING_TYPE_ORIGINAL -> "Original"
+        PROCESSING_TYPE_SOBEL -> "Sobel"
+        PROCESSING_TYPE_LAPLACIAN -> "Laplacian"
+        PROCESSING_TYPE_THRESHOLD -> "Threshold"
+        else -> "Mode $mode"
+    }
+
+    // Execution mode constants
+    const val EXECUTION_MODE_OPENCV = 0
+    const val EXECUTION_MODE_TILED = 1
+    const val EXECUTION_MODE_FUSED = 2
+    const val EXECUTION_MODE_OPENCL = 3
+
+    // Session core affinity constants
+    const val AFFINITY_ANY = 0
+    const val AFFINITY_BIG = 1
+    const val AFFINITY_LITTLE = 2
+
+    // Processing backend constants
+    const val BACKEND_CPU = 0
+    const val BACKEND_GPU = 1
+
+    /**
+     * Backend used for edge detection. BACKEND_GPU runs the GLSL passes in
+     * GpuEdgePipeline on camera textures and bypasses the JNI calls above.
+     */
+    @Volatile
+    var processingBackend = BACKEND_CPU
 }
@@ -0,0 +1,166 @@
+package com.example.edgevision.websocket
+
+import android.util.Log
+import org.java_websocket.WebSocket
+import java.nio.ByteBuffer
+import java.util.Locale
+import java.util.concurrent.ScheduledExecutorService
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.atomic.AtomicReference
+
+/**
+ * Send stage for one WebSocket client.
+ *
+ * Frames go into a one-packet mailbox that a shared sender pool drains, so the camera
+ * thread never waits on a socket. A frame arriving before the previous one left replaces
+ * it ("latest frame wins"), and nothing new is handed to the socket while it still has
+ * buffered data, so a slow viewer drops its own frames instead of growing send queues or
+ * delaying the other clients.
+ *
+ * Tile-delta and video packets only decode on top of the previous one, so for those a lost
+ * packet is never papered over: the queued packet is kept, the newer one discarded, and
+ * nothing but a keyframe is accepted until the client has a reference again.
+ */
+internal class ClientSender(
+    val connection: WebSocket,
+    val level: Int,
+    private val executor: ScheduledExecutorService
+) {
+
+    companion object {
+        private const val TAG = "ClientSender"
+        private const val BACKOFF_MS = 5L // Re-check a congested socket this often
+    }
+
+    // Payload encoding the client selected (FrameProtocol.ENCODING_*)
+    @Volatile var encoding = FrameProtocol.ENCODING_RAW
+
+    // Frames per second the client asked for; 0 = every frame the server sends
+    @Volatile var maxFps = 0f
+
+    // A tile-delta or video client has no valid reference (just joined, or lost a packet):
+    // it is only sent keyframes until one arrives
+    @Volatile var needsKeyframe = false
+
+    private val pending = AtomicReference<ByteBuffer?>(null)
+    private val drainScheduled = AtomicBoolean(false)
+    @Volatile private var lastAcceptedNs = 0L
+
+    private val sentFrames = AtomicLong(0)
+    private val droppedFrames = AtomicLong(0)
+    private val skippedFrames = AtomicLong(0)
+    private val sentBytes = AtomicLong(0)
+
+    /**
+     * Whether the client's fps budget allows a frame now; a refusal counts as skipped.
+     * Video streams are not capped: skipping a P-frame would break the decoder.
+     */
+    fun wantsFrame(nowNs: Long): Boolean {
+        val fps = maxFps
+        val currentEncoding = encoding
+        if (fps > 0f && !FrameProtocol.isVideo(currentEncoding) &&
+            nowNs - lastAcceptedNs < (1_000_000_000 / fps).toLong()) {
+            skippedFrames.incrementAndGet()
+            if (currentEncoding == FrameProtocol.ENCODING_TILE_DELTA) {
+                // The shared delta stream moves on without this client; it resyncs from its
+                // own keyframe (FrameWebSocketServer) on the next frame it accepts
+                needsKeyframe = true
+            }
+            return false
+        }
+        lastAcceptedNs = nowNs
+        return true
+    }
+
+    /**
+     * Queue a packet for sending (called on the frame thread). The packet must not be
+     * modified afterwards; it may be shared with other clients.
+     * @param keyframe Whether the packet decodes on its own (see FrameProtocol.isKeyframe)
+     */
+    fun offer(packet: ByteBuffer, keyframe: Boolean) {
+        val copy = packet.duplicate()
+        if (!FrameProtocol.needsReference(encoding) || keyframe) {
+            // Self-contained, so it can replace whatever is still queued
+            if (pending.getAndSet(copy) != null) {
+                droppedFrames.incrementAndGet()
+            }
+            needsKeyframe = false
+        } else if (needsKeyframe) {
+            // Depends on a packet this client never got
+            droppedFrames.incrementAndGet()
+            return
+        } else if (!pending.compareAndSet(null, copy)) {
+            // Depends on the queued packet: send that one, drop this and wait for a keyframe
+            droppedFrames.incrementAndGet()
+            needsKeyframe = true
+            return
+        }
+        scheduleDrain(0)
+    }
+
+    /**
+     * Per-client counters as a JSON object
+     */
+    fun toJson(): String =
+        "{\"address\":\"${connection.remoteSocketAddress}\",\"encoding\":$encoding,\"level\":$level," +
+                "\"maxFps\":${"%.1f".format(Locale.US, maxFps)},\"sent\":${sentFrames.get()}," +
+                "\"dropped\":${droppedFrames.get()},\"skipped\":${skippedFrames.get()}," +
+                "\"bytes\":${sentBytes.get()}}"
+
+    private fun scheduleDrain(delayMs: Long) {
+        if (drainScheduled.compareAndSet(false, true)) {
+            submitDrain(delayMs)
+        }
+    }
+
+    /**
+     * Only the owner of drainScheduled calls this, so at most one drain runs at a time and
+     * packets leave in the order they were queued
+     */
+    private fun submitDrain(delayMs: Long) {
+        try {
+            executor.schedule(::drain, delayMs, TimeUnit.MILLISECONDS)
+        } catch (e: Exception) {
+            // Sender pool shut down with the server
+            drainScheduled.set(false)
+        }
+    }
+
+    private fun drain() {
+        if (!connection.isOpen) {
+            pending.set(null)
+            drainScheduled.set(false)
+            return
+        }
+
+        // Leave the newest frame in the mailbox until the socket catches up
+        if (connection.hasBufferedData()) {
+            submitDrain(BACKOFF_MS)
+            return
+        }
+
+        val packet = pending.getAndSet(null)
+        if (packet != null) {
+            try {
+                val size = packet.remaining()
+                connection.send(packet)
+                sentFrames.incrementAndGet()
+                sentBytes.addAndGet(size.toLong())
+            } catch (e: Exception) {
+                Log.e(TAG, "Error sending frame to ${connection.remoteSocketAddress}", e)
+                if (FrameProtocol.needsReference(encoding)) {
+                    needsKeyframe = true
+                }
+            }
+        }
+
+        // Release only after the send; a packet offered meanwhile did not schedule its own
+        // drain, so pick it up here
+        drainScheduled.set(false)
+        if (pending.get() != null) {
+            scheduleDrain(0)
+        }
+    }
+}
@@ -0,0 +1,129 @@
+package com.example.edgevision.websocket
+
+import java.nio.ByteBuffer
+
+/**
+ * Binary frame format sent to WebSocket clients.
+ *
+ * Each message is a fixed little-endian header followed by the pixel payload; packets are
+ * built natively by NativeProcessor.encodeFrame (see frame_encoder.h for the field layout,
+ * mirrored in web/src/websocket.ts).
+ */
+object FrameProtocol {
+    const val MAGIC = 0x31465645 // "EVF1"
+    const val VERSION = 1
+    const val HEADER_SIZE = 32
+    private const val ENCODING_OFFSET = 7
+
+    // First payload byte of tile-delta and video packets
+    private const val PAYLOAD_FLAG_KEYFRAME = 0x01
+
+    // Pixel formats
+    const val FORMAT_GRAY8 = 0
+
+    // Payload encodings (bit-packed ones are only used for binary edge maps)
+    const val ENCODING_RAW = 0
+    const val ENCODING_BITPACK = 1
+    const val ENCODING_BITPACK_RLE = 2
+    const val ENCODING_TILE_DELTA = 3
+    const val ENCODING_H264 = 4 // Hardware video streams: flags byte, 3 reserved, Annex-B access unit
+    const val ENCODING_HEVC = 5
+    const val ENCODING_CONTOURS = 6 // Polylines: u32 count, then u16 points, u16 flags, u16 x/y pairs
+
+    // Video payloads: keyframe flag in the first byte; keyframes carry the codec config
+    const val VIDEO_PAYLOAD_HEADER_SIZE = 4
+    private const val VIDEO_MAX_CONFIG_BYTES = 4096
+
+    // Tile-delta payloads: 8-byte payload header, then 4 bytes of tile position per tile
+    const val TILE_SIZE = 32
+
+    // Text message pushed to clients periodically: {"type":"stats","fps":..,"native":{..}}
+    const val STATS_MESSAGE_TYPE = "stats"
+
+    // Text command a client sends to select its codec, e.g. "codec:rle"
+    const val CODEC_COMMAND_PREFIX = "codec:"
+
+    // Text command a client sends to cap its frame rate, e.g. "fps:5" (0 = no cap)
+    const val FPS_COMMAND_PREFIX = "fps:"
+
+    // Output pyramid level a client subscribes to in its handshake URL, e.g. "ws://host:8888/?level=2"
+    const val LEVEL_QUERY_PARAM = "level"
+    const val MAX_LEVEL = 2 // 1/4 resolution per side
+
+    /**
+     * Frame dimension at a pyramid level (each level halves it, dropping an odd pixel)
+     */
+    fun levelSize(size: Int, level: Int): Int = size shr level
+
+    /**
+     * Level requested in a handshake resource descriptor such as "/?level=1", clamped to
+     * 0..MAX_LEVEL; 0 when absent or malformed
+     */
+    fun levelForResource(resource: String?): Int {
+        val query = resource?.substringAfter('?', "") ?: return 0
+        val value = query.split('&')
+            .map { it.split('=', limit = 2) }
+            .firstOrNull { it.size == 2 && it[0] == LEVEL_QUERY_PARAM }
+            ?.get(1)?.toIntOrNull() ?: return 0
+        return value.coerceIn(0, MAX_LEVEL)
+    }
+
+    private val codecNames = mapOf(
+        "raw" to ENCODING_RAW,
+        "bitpack" to ENCODING_BITPACK,
+        "rle" to ENCODING_BITPACK_RLE,
+        "delta" to ENCODING_TILE_DELTA,
+        "h264" to ENCODING_H264,
+        "hevc" to ENCODING_HEVC,
+        "contours" to ENCODING_CONTOURS
+    )
+
+    /**
+     * Encoding for a codec name from a client command, or null if unknown
+     */
+    fun encodingForName(name: String): Int? = codecNames[name.trim().lowercase()]
+
+    /**
+     * Whether an encoding is one of the hardware video streams
+     */
+    fun isVideo(encoding: Int): Boolean = encoding == ENCODING_H264 || encoding == ENCODING_HEVC
+
+    /**
+     * Whether packets in an encoding depend on the previous ones, so a client that misses
+     * one needs a keyframe before it can decode again
+     */
+    fun needsReference(encoding: Int): Boolean = encoding == ENCODING_TILE_DELTA || isVideo(encoding)
+
+    /**
+     * Whether a packet (position at its header) can be decoded without earlier packets:
+     * anything but a tile-delta or video packet without its keyframe flag
+     */
+    fun isKeyframe(packet: ByteBuffer): Boolean {
+        val start = packet.position()
+        val encoding = packet.get(start + ENCODING_OFFSET).toInt() and 0xFF
+        if (!needsReference(encoding)) {
+            return true
+        }
+        return packet.remaining() > HEADER_SIZE &&
+                (packet.get(start + HEADER_SIZE).toInt() and PAYLOAD_FLAG_KEYFRAME) != 0
+    }
+
+    /**
+     * Worst-case packet size for a frame in the given encoding (protocol::maxFrameSize)
+     */
+    fun maxPacketSize(width: Int, height: Int, encoding: Int): Int {
+        val packedBytes = (width + 7) / 8 * height
+        return HEADER_SIZE + when (encoding) {
+            ENCODING_BITPACK -> packedBytes
+            ENCODING_BITPACK_RLE -> packedBytes + (packedBytes + 127) / 128
+            ENCODING_TILE_DELTA -> {
+                val tiles = ((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE)
+                8 + tiles * 4 + packedBytes
+            }
+            ENCODING_H264, ENCODING_HEVC -> VIDEO_PAYLOAD_HEADER_SIZE + width * height + VIDEO_MAX_CONFIG_BYTES
+            // Polylines never cost more than the packed frame; busier frames go out as bitpack
+            ENCODING_CONTOURS -> packedBytes
+            else -> width * height
+        }
+    }
+}
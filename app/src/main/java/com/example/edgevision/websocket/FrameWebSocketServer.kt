@@ -1,29 +1,47 @@
 package com.example.edgevision.websocket
 
 import android.util.Log
+import com.example.edgevision.native.NativeProcessor
 import org.java_websocket.WebSocket
 import org.java_websocket.handshake.ClientHandshake
 import org.java_websocket.server.WebSocketServer
 import java.net.InetSocketAddress
 import java.nio.ByteBuffer
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.Executors
+import java.util.concurrent.ScheduledExecutorService
+import java.util.concurrent.TimeUnit
 
 /**
- * WebSocket server for streaming processed camera frames
+ * WebSocket server for streaming processed camera frames.
+ *
+ * Frames are encoded on the caller's thread once per codec in use, then handed to each
+ * client's ClientSender; the sockets are written from a small sender pool, so slow
+ * viewers drop frames rather than stalling the caller.
  */
 class FrameWebSocketServer(port: Int) : WebSocketServer(InetSocketAddress(port)) {
 
     companion object {
         private const val TAG = "FrameWebSocketServer"
         const val DEFAULT_PORT = 8888
+        private const val SENDER_THREADS = 2
+        private const val VIDEO_IDLE_MS = 5000L // Hardware encoders nobody watches are freed after this
     }
 
-    private val connectedClients = mutableSetOf<WebSocket>()
+    private val connectedClients = ConcurrentHashMap<WebSocket, ClientSender>()
+    private val senderPool: ScheduledExecutorService =
+        Executors.newScheduledThreadPool(SENDER_THREADS) { task ->
+            Thread(task, "FrameSender").apply { isDaemon = true }
+        }
+
     var onClientCountChanged: ((Int) -> Unit)? = null
 
     override fun onOpen(conn: WebSocket, handshake: ClientHandshake) {
-        connectedClients.add(conn)
+        // Thumbnail viewers subscribe to a reduced stream with "?level=n" in the URL
+        val level = FrameProtocol.levelForResource(handshake.resourceDescriptor)
+        connectedClients[conn] = ClientSender(conn, level, senderPool)
         val clientAddress = conn.remoteSocketAddress.toString()
-        Log.i(TAG, "New client connected: $clientAddress")
+        Log.i(TAG, "New client connected: $clientAddress (level $level)")
         Log.i(TAG, "Total connected clients: ${connectedClients.size}")
         onClientCountChanged?.invoke(connectedClients.size)
     }
@@ -37,8 +55,42 @@ class FrameWebSocketServer(port: Int) : WebSocketServer(InetSocketAddress(port))
     }
 
     override fun onMessage(conn: WebSocket, message: String) {
-        // Echo message back to client (for testing)
         Log.d(TAG, "Received message from ${conn.remoteSocketAddress}: $message")
+
+        val sender = connectedClients[conn] ?: return
+
+        // Codec selection: "codec:<raw|bitpack|rle|delta|h264|hevc|contours>", acknowledged with the same string
+        if (message.startsWith(FrameProtocol.CODEC_COMMAND_PREFIX)) {
+            val name = message.removePrefix(FrameProtocol.CODEC_COMMAND_PREFIX)
+            val encoding = FrameProtocol.encodingForName(name)
+            if (encoding != null) {
+                sender.encoding = encoding
+                if (FrameProtocol.needsReference(encoding)) {
+                    // No reference frame yet
+                    sender.needsKeyframe = true
+                }
+                Log.i(TAG, "Client ${conn.remoteSocketAddress} selected codec $name")
+                conn.send(message)
+            } else {
+                conn.send("error: unknown codec $name")
+            }
+            return
+        }
+
+        // Frame rate cap: "fps:<n>" (0 = every frame), acknowledged with the same string
+        if (message.startsWith(FrameProtocol.FPS_COMMAND_PREFIX)) {
+            val fps = message.removePrefix(FrameProtocol.FPS_COMMAND_PREFIX).trim().toFloatOrNull()
+            if (fps != null && fps >= 0f) {
+                sender.maxFps = fps
+                Log.i(TAG, "Client ${conn.remoteSocketAddress} limited to $fps fps")
+                conn.send(message)
+            } else {
+                conn.send("error: invalid fps $message")
+            }
+            return
+        }
+
+        // Echo message back to client (for testing)
         conn.send("Echo: $message")
     }
 
@@ -55,33 +107,82 @@ class FrameWebSocketServer(port: Int) : WebSocketServer(InetSocketAddress(port))
         Log.i(TAG, "WebSocket server started on port $port")
         connectionLostTimeout = 30 // 30 seconds timeout
         isReuseAddr = true
+
+        // Encoders are only fed while a client watches their stream, so release them from a timer
+        senderPool.scheduleWithFixedDelay({
+            NativeProcessor.releaseIdleVideoEncoders(VIDEO_IDLE_MS)
+        }, VIDEO_IDLE_MS, VIDEO_IDLE_MS / 5, TimeUnit.MILLISECONDS)
     }
 
     /**
-     * Broadcast frame message to all connected clients
+     * Broadcast a frame to all connected clients, encoding it once per codec and level in use
+     * @param encode Builds the packet for an encoding at a pyramid level (position 0, limit = length),
+     *               or null on failure or when a video encoder has no output yet. The packet may be
+     *               reused between calls. requestSync is true when a video client of the stream has
+     *               no valid reference, so the encoder should produce a keyframe soon.
+     * @param encodeKeyframe Builds a standalone tile-delta keyframe of the frame just encoded at a
+     *                       level, for clients that lost their reference (same buffer rules)
      */
-    fun broadcastFrame(frameMessage: FrameMessage) {
-        if (connectedClients.isEmpty()) {
+    fun broadcastFrame(
+        encode: (encoding: Int, level: Int, requestSync: Boolean) -> ByteBuffer?,
+        encodeKeyframe: (level: Int) -> ByteBuffer?
+    ) {
+        val nowNs = System.nanoTime()
+        val recipients = connectedClients.values.filter { it.connection.isOpen && it.wantsFrame(nowNs) }
+        if (recipients.isEmpty()) {
             return
         }
 
-        val json = frameMessage.toJson()
-        val sentCount = connectedClients.count { client ->
-            try {
-                if (client.isOpen) {
-                    client.send(json)
-                    true
-                } else {
-                    false
-                }
-            } catch (e: Exception) {
-                Log.e(TAG, "Error sending frame to client ${client.remoteSocketAddress}", e)
-                false
+        recipients.groupBy { it.encoding to it.level }.forEach { (stream, clients) ->
+            val (encoding, level) = stream
+            val lagging = if (FrameProtocol.needsReference(encoding)) clients.filter { it.needsKeyframe } else emptyList()
+
+            val packet = encode(encoding, level, FrameProtocol.isVideo(encoding) && lagging.isNotEmpty())
+                ?: return@forEach
+            val shared = sharedCopy(packet)
+            val keyframe = FrameProtocol.isKeyframe(shared)
+
+            // The delta stream is not reset for a late client; it gets its own keyframe of this frame
+            if (encoding == FrameProtocol.ENCODING_TILE_DELTA && !keyframe && lagging.isNotEmpty()) {
+                (clients - lagging.toSet()).forEach { it.offer(shared, false) }
+                val resync = encodeKeyframe(level) ?: return@forEach
+                val sharedKeyframe = sharedCopy(resync)
+                lagging.forEach { it.offer(sharedKeyframe, true) }
+            } else {
+                // Video clients without a reference skip P-frames until the requested keyframe
+                clients.forEach { it.offer(shared, keyframe) }
             }
+            Log.d(TAG, "Queued frame for ${clients.size} client(s), " +
+                    "encoding $encoding, level $level, size: ${shared.remaining()} bytes")
         }
+    }
+
+    // The encoder reuses its buffer; the clients share one copy until they have sent it
+    private fun sharedCopy(packet: ByteBuffer): ByteBuffer {
+        val shared = ByteBuffer.allocate(packet.remaining())
+        shared.put(packet)
+        shared.flip()
+        return shared
+    }
+
+    /**
+     * Per-client send counters (sent, dropped, fps-skipped, bytes) as a JSON array
+     */
+    fun clientStatsJson(): String =
+        connectedClients.values.joinToString(",", "[", "]") { it.toJson() }
 
-        if (sentCount > 0) {
-            Log.d(TAG, "Broadcasted frame to $sentCount client(s), size: ${frameMessage.frameSize} bytes")
+    /**
+     * Send a text message to all open clients
+     */
+    fun broadcastText(message: String) {
+        val openClients = connectedClients.keys.filter { it.isOpen }
+        if (openClients.isEmpty()) {
+            return
+        }
+        try {
+            broadcast(message, openClients)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error broadcasting text message", e)
         }
     }
 
@@ -101,7 +202,9 @@ class FrameWebSocketServer(port: Int) : WebSocketServer(InetSocketAddress(port))
     fun shutdown() {
         Log.i(TAG, "Shutting down WebSocket server...")
         try {
-            connectedClients.forEach { client ->
+            senderPool.shutdownNow()
+            NativeProcessor.releaseIdleVideoEncoders(0)
+            connectedClients.keys.forEach { client ->
                 try {
                     client.close(1000, "Server shutting down")
                 } catch (e: Exception) {
@@ -2,7 +2,11 @@ package com.example.edgevision.websocket
 
 import android.content.Context
 import android.util.Log
+import com.example.edgevision.native.NativeProcessor
 import com.example.edgevision.utils.NetworkUtils
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.Locale
 import java.util.concurrent.atomic.AtomicLong
 
 /**
@@ -14,11 +18,17 @@ class WebSocketManager(private val context: Context) {
         private const val TAG = "WebSocketManager"
         private const val DEFAULT_PORT = 8888
         private const val FRAME_THROTTLE_MS = 100 // Send frame every 100ms (10 FPS)
+        private const val STATS_INTERVAL_MS = 1000 // Push native stats once per second
     }
 
     private var server: FrameWebSocketServer? = null
     private var isRunning = false
     private val lastFrameSentTime = AtomicLong(0)
+    private var lastStatsSentTime = 0L
+
+    // Reused across frames; only the sending (camera) thread touches these
+    private var packetBuffer: ByteBuffer? = null
+    private var stagingBuffer: ByteBuffer? = null
 
     var onServerStateChanged: ((Boolean) -> Unit)? = null
     var onClientCountChanged: ((Int) -> Unit)? = null
@@ -79,27 +89,26 @@ class WebSocketManager(private val context: Context) {
 
     /**
      * Send a frame to all connected clients with throttling
-     * @param frameData Raw frame bytes
+     * @param frame Direct ByteBuffer holding width * height processed bytes
      * @param width Frame width
      * @param height Frame height
-     * @param format Frame format (e.g., "Grayscale")
-     * @param processingMode Processing mode (e.g., "Canny Edge Detection")
+     * @param mode NativeProcessor.PROCESSING_TYPE_* of the frame
      * @param fps Current FPS
      * @return true if frame was sent, false if throttled or no clients
      */
     fun sendFrame(
-        frameData: ByteArray,
+        frame: ByteBuffer,
         width: Int,
         height: Int,
-        format: String,
-        processingMode: String,
+        mode: Int,
         fps: Double
     ): Boolean {
-        if (!isRunning || server == null) {
+        val currentServer = server
+        if (!isRunning || currentServer == null) {
             return false
         }
 
-        if (!server!!.hasClients()) {
+        if (!currentServer.hasClients()) {
             return false
         }
 
@@ -111,17 +120,54 @@ class WebSocketManager(private val context: Context) {
         }
 
         try {
-            val frameMessage = FrameMessage.create(
-                width = width,
-                height = height,
-                format = format,
-                processingMode = processingMode,
-                fps = fps,
-                frameData = frameData
-            )
-
-            server?.broadcastFrame(frameMessage)
+            // Bit-packing is only lossless for binary maps (Canny, threshold); video streams take any mode
+            val isEdgeMap = NativeProcessor.isBinaryOutput(mode)
+            currentServer.broadcastFrame({ requested, level, requestSync ->
+                val isVideo = FrameProtocol.isVideo(requested)
+                val encoding = if (isEdgeMap || isVideo) requested else FrameProtocol.ENCODING_RAW
+                if (requested == FrameProtocol.ENCODING_TILE_DELTA && !isEdgeMap) {
+                    // Raw frames replace the delta client's image, so the next delta must be complete
+                    NativeProcessor.requestKeyframe(requested, level)
+                } else if (requestSync) {
+                    NativeProcessor.requestKeyframe(requested, level)
+                }
+                val packet = packetBuffer(FrameProtocol.maxPacketSize(
+                    FrameProtocol.levelSize(width, level), FrameProtocol.levelSize(height, level), encoding
+                ))
+                val length = NativeProcessor.encodeFrame(
+                    frame, width, height, mode, currentTime, fps.toFloat(), encoding, level, packet
+                )
+                if (length < 0) {
+                    Log.e(TAG, "Failed to encode frame (encoding $encoding)")
+                    null
+                } else if (length == 0) {
+                    // Hardware encoder output lags the input by a frame or two
+                    null
+                } else {
+                    packet.position(0)
+                    packet.limit(length)
+                    packet
+                }
+            }, { level ->
+                val packet = packetBuffer(FrameProtocol.maxPacketSize(
+                    FrameProtocol.levelSize(width, level), FrameProtocol.levelSize(height, level),
+                    FrameProtocol.ENCODING_TILE_DELTA
+                ))
+                val length = NativeProcessor.encodeKeyframe(mode, currentTime, fps.toFloat(), level, packet)
+                if (length > 0) {
+                    packet.position(0)
+                    packet.limit(length)
+                    packet
+                } else {
+                    null
+                }
+            })
             lastFrameSentTime.set(currentTime)
+
+            if (currentTime - lastStatsSentTime >= STATS_INTERVAL_MS) {
+                lastStatsSentTime = currentTime
+                sendStats(currentServer, fps)
+            }
             return true
         } catch (e: Exception) {
             Log.e(TAG, "Error sending frame", e)
@@ -129,6 +175,54 @@ class WebSocketManager(private val context: Context) {
         }
     }
 
+    /**
+     * Send a frame held in a ByteArray (legacy copy-based processing path)
+     */
+    fun sendFrame(
+        frameData: ByteArray,
+        width: Int,
+        height: Int,
+        mode: Int,
+        fps: Double
+    ): Boolean {
+        if (!isReadyForFrame()) {
+            return false
+        }
+
+        val staging = stagingBuffer?.takeIf { it.capacity() == frameData.size }
+            ?: ByteBuffer.allocateDirect(frameData.size).also { stagingBuffer = it }
+        staging.clear()
+        staging.put(frameData)
+        return sendFrame(staging, width, height, mode, fps)
+    }
+
+    private fun sendStats(server: FrameWebSocketServer, fps: Double) {
+        val message = "{\"type\":\"${FrameProtocol.STATS_MESSAGE_TYPE}\"," +
+                "\"fps\":${"%.1f".format(Locale.US, fps)}," +
+                "\"native\":${NativeProcessor.getStats()}," +
+                "\"clients\":${server.clientStatsJson()}}"
+        server.broadcastText(message)
+    }
+
+    private fun packetBuffer(size: Int): ByteBuffer {
+        val current = packetBuffer
+        if (current != null && current.capacity() >= size) {
+            current.clear()
+            return current
+        }
+        return ByteBuffer.allocateDirect(size).order(ByteOrder.LITTLE_ENDIAN).also { packetBuffer = it }
+    }
+
+    /**
+     * Check whether sendFrame would currently send, so callers can skip building the payload
+     */
+    fun isReadyForFrame(): Boolean {
+        if (!isRunning || server?.hasClients() != true) {
+            return false
+        }
+        return System.currentTimeMillis() - lastFrameSentTime.get() >= FRAME_THROTTLE_MS
+    }
+
     /**
      * Get server running state
      */
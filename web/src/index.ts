@@ -1,5 +1,5 @@
 import { FrameViewer } from './viewer.js';
-import { WebSocketClient, ConnectionStatus } from './websocket.js';
+import { WebSocketClient, ConnectionStatus, FrameCodec, StatsMessage } from './websocket.js';
 
 /**
  * EdgeVision Web Viewer Entry Point
@@ -19,6 +19,9 @@ let connectBtn: HTMLButtonElement;
 let disconnectBtn: HTMLButtonElement;
 let serverIpInput: HTMLInputElement;
 let serverPortInput: HTMLInputElement;
+let codecSelect: HTMLSelectElement;
+let fpsSelect: HTMLSelectElement;
+let levelSelect: HTMLSelectElement;
 let connectionStatusEl: HTMLElement;
 
 // Load saved connection settings
@@ -83,6 +86,9 @@ const handleConnect = (): void => {
     }
 
     saveConnectionSettings();
+    if (levelSelect) {
+        wsClient.setLevel(Number(levelSelect.value));
+    }
     console.log(`Connecting to ${host}:${port}...`);
     wsClient.connect(host, port);
 };
@@ -94,6 +100,80 @@ const handleDisconnect = (): void => {
     viewer.clear();
 };
 
+// Microseconds as a short human-readable duration
+const formatMicros = (micros: number): string =>
+    micros >= 1000 ? `${(micros / 1000).toFixed(1)} ms` : `${micros} µs`;
+
+// Show the native latency stats pushed by the app
+const updateNativeStats = (stats: StatsMessage): void => {
+    const deviceFpsEl = document.getElementById('deviceFps');
+    const latencyEl = document.getElementById('latency');
+    const droppedEl = document.getElementById('droppedFrames');
+    const stagesEl = document.getElementById('stageStats');
+    const governorEl = document.getElementById('governor');
+    const thermalEl = document.getElementById('thermal');
+    const backendEl = document.getElementById('backend');
+    const viewerEl = document.getElementById('viewerStats');
+
+    if (deviceFpsEl) deviceFpsEl.textContent = stats.fps.toFixed(1);
+
+    const total = stats.native.stages.total ?? stats.native.stages.canny;
+    if (latencyEl && total) {
+        latencyEl.textContent = `${formatMicros(total.p50Us)} / ${formatMicros(total.p95Us)} / ${formatMicros(total.p99Us)}`;
+    }
+
+    if (droppedEl) {
+        droppedEl.textContent = `${stats.native.dropped.toLocaleString()} of ${stats.native.frames.toLocaleString()}`;
+    }
+
+    if (stagesEl) {
+        stagesEl.textContent = Object.entries(stats.native.stages)
+            .filter(([name]) => name !== 'total')
+            .map(([name, stage]) => `${name} ${formatMicros(stage!.p50Us)} / ${formatMicros(stage!.p99Us)}`)
+            .join(', ') || '-';
+    }
+
+    if (viewerEl && stats.clients) {
+        const dropped = stats.clients.reduce((sum, client) => sum + client.dropped, 0);
+        const skipped = stats.clients.reduce((sum, client) => sum + client.skipped, 0);
+        viewerEl.textContent = `${stats.clients.length} (${dropped.toLocaleString()} / ${skipped.toLocaleString()})`;
+    }
+
+    const governor = stats.native.governor;
+    if (governorEl && governor) {
+        if (governor.targetUs === 0 && governor.minimumStep === 0) {
+            governorEl.textContent = 'off';
+        } else {
+            const scale = governor.pyramidLevel === 0 ? 'full' : `1/${1 << governor.pyramidLevel}`;
+            const cadence = governor.skipInterval === 1 ? 'every frame' : `1 in ${governor.skipInterval}`;
+            governorEl.textContent = `${scale} res, ${cadence} (${formatMicros(governor.averageUs)} / ${formatMicros(governor.targetUs)})`;
+        }
+    }
+
+    const thermal = stats.native.thermal;
+    if (thermalEl && thermal) {
+        if (!thermal.enabled) {
+            thermalEl.textContent = 'off';
+        } else {
+            const names = ['nominal', 'warm', 'hot', 'critical'];
+            const headroom = thermal.headroom >= 0 ? `, headroom ${thermal.headroom.toFixed(2)}` : '';
+            const actions = [
+                thermal.efficiencyCores && thermal.littleCores > 0 ? 'little cores' : '',
+                thermal.preferGpu ? 'GPU' : '',
+            ].filter(Boolean).join(', ');
+            thermalEl.textContent = `${names[thermal.level] ?? thermal.level}${headroom}${actions ? ` (${actions})` : ''}`;
+        }
+    }
+
+    const backend = stats.native.backend;
+    if (backendEl && backend) {
+        const selected = backend.selectedMode === 3 ? 'OpenCL' : 'CPU';
+        backendEl.textContent = backend.openClAvailable
+            ? `${selected} (CPU ${formatMicros(backend.cpuUs)} / OpenCL ${formatMicros(backend.openClUs)})`
+            : `CPU ${formatMicros(backend.cpuUs)}, no OpenCL`;
+    }
+};
+
 // Setup WebSocket event handlers
 const setupWebSocketHandlers = (): void => {
     wsClient.onConnectionStatusChanged = (status: ConnectionStatus) => {
@@ -114,6 +194,10 @@ const setupWebSocketHandlers = (): void => {
         viewer.displayWebSocketFrame(frame);
     };
 
+    wsClient.onStatsReceived = (stats) => {
+        updateNativeStats(stats);
+    };
+
     wsClient.onError = (error) => {
         console.error('WebSocket error:', error);
         // Don't alert on every error - just log it
@@ -128,6 +212,9 @@ window.addEventListener('DOMContentLoaded', () => {
     // Get UI elements
     connectBtn = document.getElementById('connectBtn') as HTMLButtonElement;
     disconnectBtn = document.getElementById('disconnectBtn') as HTMLButtonElement;
+    codecSelect = document.getElementById('codecSelect') as HTMLSelectElement;
+    fpsSelect = document.getElementById('fpsSelect') as HTMLSelectElement;
+    levelSelect = document.getElementById('levelSelect') as HTMLSelectElement;
     serverIpInput = document.getElementById('serverIp') as HTMLInputElement;
     serverPortInput = document.getElementById('serverPort') as HTMLInputElement;
     connectionStatusEl = document.getElementById('connectionStatus') as HTMLElement;
@@ -147,6 +234,31 @@ window.addEventListener('DOMContentLoaded', () => {
         disconnectBtn.addEventListener('click', handleDisconnect);
     }
 
+    // Codec preference is re-sent by the client on every (re)connect
+    if (codecSelect) {
+        wsClient.setCodec(codecSelect.value as FrameCodec);
+        codecSelect.addEventListener('change', () => {
+            wsClient.setCodec(codecSelect.value as FrameCodec);
+        });
+    }
+
+    // Resolution is chosen in the handshake, so reconnect to switch streams
+    if (levelSelect) {
+        levelSelect.addEventListener('change', () => {
+            if (wsClient.isConnected()) {
+                wsClient.disconnect();
+                handleConnect();
+            }
+        });
+    }
+
+    if (fpsSelect) {
+        wsClient.setMaxFps(Number(fpsSelect.value));
+        fpsSelect.addEventListener('change', () => {
+            wsClient.setMaxFps(Number(fpsSelect.value));
+        });
+    }
+
     // Allow Enter key to connect
     if (serverIpInput) {
         serverIpInput.addEventListener('keypress', (e) => {
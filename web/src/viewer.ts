@@ -1,4 +1,38 @@
-import { FrameMessage } from './websocket.js';
+import {
+    FrameMessage, ENCODING_BITPACK, ENCODING_BITPACK_RLE, ENCODING_TILE_DELTA, ENCODING_H264, ENCODING_HEVC,
+    ENCODING_CONTOURS
+} from './websocket.js';
+
+// Tile-delta payload constants (see tile_delta.h)
+const TILE_FLAG_KEYFRAME = 0x01;
+const TILE_PAYLOAD_HEADER_SIZE = 8;
+const TILE_HEADER_SIZE = 4;
+
+// Video payload constants (see video_encoder.h): flags byte, 3 reserved, Annex-B access unit
+const VIDEO_FLAG_KEYFRAME = 0x01;
+const VIDEO_PAYLOAD_HEADER_SIZE = 4;
+
+// Contour payload constants (see contour_codec.h)
+const CONTOUR_FLAG_CLOSED = 0x01;
+const CONTOUR_PAYLOAD_HEADER_SIZE = 4;
+const CONTOUR_POLYLINE_HEADER_SIZE = 4;
+const CONTOUR_POINT_SIZE = 4;
+
+// WebCodecs codec strings: H.264 Baseline 3.1, HEVC Main 3.1 (what phone encoders emit by default)
+const VIDEO_CODEC_STRINGS: Record<number, string> = {
+    [ENCODING_H264]: 'avc1.42E01F',
+    [ENCODING_HEVC]: 'hvc1.1.6.L93.B0'
+};
+
+/**
+ * Region of the frame changed by the last decoded payload
+ */
+interface DirtyRect {
+    x: number;
+    y: number;
+    width: number;
+    height: number;
+}
 
 /**
  * FrameViewer class for displaying processed EdgeVision frames
@@ -13,6 +47,19 @@ export class FrameViewer {
     private lastFrameTime: number = 0;
     private frameCount: number = 0;
 
+    // Reused across WebSocket frames so steady-state decoding allocates nothing
+    private frameImageData: ImageData | null = null;
+    private frameCanvas: HTMLCanvasElement | null = null;
+    private frameCtx: CanvasRenderingContext2D | null = null;
+    private unpackBuffer: Uint8Array = new Uint8Array(0);
+    private hasDeltaReference = false; // frameImageData holds the last tile-delta frame
+
+    // WebCodecs decoder for the video encodings, (re)created per codec and frame size
+    private videoDecoder: VideoDecoder | null = null;
+    private videoDecoderKey = '';
+    private videoNeedsKeyframe = true; // Deltas are dropped until the decoder has a keyframe
+    private pendingVideoFrames: FrameMessage[] = []; // Metadata for chunks still in the decoder
+
     constructor(canvasId: string) {
         const canvas = document.getElementById(canvasId) as HTMLCanvasElement;
         if (!canvas) {
@@ -153,22 +200,23 @@ export class FrameViewer {
                 this.canvas.height = frame.width;
             }
 
-            // Decode base64 frame data
-            const binaryString = atob(frame.frameData);
-            const bytes = new Uint8Array(binaryString.length);
-            for (let i = 0; i < binaryString.length; i++) {
-                bytes[i] = binaryString.charCodeAt(i);
+            if (frame.encoding === ENCODING_H264 || frame.encoding === ENCODING_HEVC) {
+                this.decodeVideoFrame(frame);
+                return;
             }
+            this.closeVideoDecoder();
 
-            // Create image data from original frame
-            const tempImageData = this.ctx.createImageData(frame.width, frame.height);
-            for (let i = 0; i < bytes.length; i++) {
-                const gray = bytes[i];
-                const idx = i * 4;
-                tempImageData.data[idx] = gray;
-                tempImageData.data[idx + 1] = gray;
-                tempImageData.data[idx + 2] = gray;
-                tempImageData.data[idx + 3] = 255;
+            if (frame.encoding === ENCODING_CONTOURS) {
+                this.drawContours(frame);
+                return;
+            }
+
+            // Decode straight into the reused RGBA buffer (one 32-bit store per pixel)
+            const imageData = this.getFrameImageData(frame.width, frame.height);
+            const rgba = new Uint32Array(imageData.data.buffer);
+            const dirty = this.decodePayload(frame, rgba);
+            if (!dirty) {
+                return;
             }
 
             // Clear canvas and rotate 90 degrees clockwise
@@ -179,13 +227,11 @@ export class FrameViewer {
             this.ctx.translate(this.width, 0);
             this.ctx.rotate(Math.PI / 2);
 
-            // Draw the rotated image
-            const tempCanvas = document.createElement('canvas');
-            tempCanvas.width = frame.width;
-            tempCanvas.height = frame.height;
-            const tempCtx = tempCanvas.getContext('2d')!;
-            tempCtx.putImageData(tempImageData, 0, 0);
-            this.ctx.drawImage(tempCanvas, 0, 0);
+            // Draw the rotated image; the offscreen canvas keeps pixels outside the dirty region
+            if (dirty.width > 0 && dirty.height > 0) {
+                this.frameCtx!.putImageData(imageData, 0, 0, dirty.x, dirty.y, dirty.width, dirty.height);
+            }
+            this.ctx.drawImage(this.frameCanvas!, 0, 0);
 
             this.ctx.restore();
             this.hideNoFrameMessage();
@@ -200,6 +246,330 @@ export class FrameViewer {
         }
     }
 
+    /**
+     * Stroke a polyline payload straight onto the canvas (no pixel buffer involved),
+     * rotated like the raster frames
+     */
+    private drawContours(frame: FrameMessage): void {
+        const payload = frame.payload;
+        if (payload.length < CONTOUR_PAYLOAD_HEADER_SIZE) {
+            console.error('Contour payload too short');
+            return;
+        }
+        // Tile deltas after this need a fresh keyframe, like after any other encoding
+        this.hasDeltaReference = false;
+
+        const view = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+        const polylineCount = view.getUint32(0, true);
+        const path = new Path2D();
+        let offset = CONTOUR_PAYLOAD_HEADER_SIZE;
+
+        for (let p = 0; p < polylineCount; p++) {
+            if (offset + CONTOUR_POLYLINE_HEADER_SIZE > payload.length) {
+                console.error('Truncated contour payload');
+                return;
+            }
+            const pointCount = view.getUint16(offset, true);
+            const flags = view.getUint16(offset + 2, true);
+            offset += CONTOUR_POLYLINE_HEADER_SIZE;
+            if (offset + pointCount * CONTOUR_POINT_SIZE > payload.length) {
+                console.error('Truncated contour payload');
+                return;
+            }
+
+            // Pixel centres, so one-pixel strokes land on the pixels the raster would light
+            for (let i = 0; i < pointCount; i++) {
+                const x = view.getUint16(offset, true) + 0.5;
+                const y = view.getUint16(offset + 2, true) + 0.5;
+                if (i === 0) {
+                    path.moveTo(x, y);
+                } else {
+                    path.lineTo(x, y);
+                }
+                offset += CONTOUR_POINT_SIZE;
+            }
+            if (flags & CONTOUR_FLAG_CLOSED) {
+                path.closePath();
+            }
+        }
+
+        this.ctx.save();
+        this.ctx.fillStyle = '#000';
+        this.ctx.fillRect(0, 0, this.width, this.height);
+        this.ctx.translate(this.width, 0);
+        this.ctx.rotate(Math.PI / 2);
+        this.ctx.strokeStyle = '#fff';
+        this.ctx.lineWidth = 1;
+        this.ctx.stroke(path);
+        this.ctx.restore();
+
+        this.hideNoFrameMessage();
+        this.calculateFps();
+        this.updateStatsFromFrame(frame);
+    }
+
+    /**
+     * Queue a video access unit on the WebCodecs decoder; the picture is drawn when it
+     * comes out (see drawVideoFrame). Deltas before the first keyframe are dropped.
+     */
+    private decodeVideoFrame(frame: FrameMessage): void {
+        if (typeof VideoDecoder === 'undefined') {
+            console.error('WebCodecs VideoDecoder is not available in this browser');
+            return;
+        }
+        const payload = frame.payload;
+        if (payload.length <= VIDEO_PAYLOAD_HEADER_SIZE) {
+            console.error('Video payload too short');
+            return;
+        }
+        const keyframe = (payload[0] & VIDEO_FLAG_KEYFRAME) !== 0;
+
+        const key = `${frame.encoding}:${frame.width}x${frame.height}`;
+        if (!this.videoDecoder || this.videoDecoder.state === 'closed' || this.videoDecoderKey !== key) {
+            this.closeVideoDecoder();
+            this.videoDecoder = new VideoDecoder({
+                output: (videoFrame) => this.drawVideoFrame(videoFrame),
+                error: (error) => {
+                    console.error('Video decode error:', error);
+                    this.videoNeedsKeyframe = true;
+                    this.pendingVideoFrames = [];
+                }
+            });
+            // Annex-B stream with in-band parameter sets, so no description is needed
+            this.videoDecoder.configure({
+                codec: VIDEO_CODEC_STRINGS[frame.encoding],
+                codedWidth: frame.width,
+                codedHeight: frame.height,
+                optimizeForLatency: true
+            });
+            this.videoDecoderKey = key;
+            this.videoNeedsKeyframe = true;
+        }
+
+        if (!keyframe && this.videoNeedsKeyframe) {
+            return;
+        }
+        this.videoNeedsKeyframe = false;
+        this.pendingVideoFrames.push(frame);
+        this.videoDecoder.decode(new EncodedVideoChunk({
+            type: keyframe ? 'key' : 'delta',
+            timestamp: frame.timestamp * 1000,
+            data: payload.subarray(VIDEO_PAYLOAD_HEADER_SIZE)
+        }));
+    }
+
+    /**
+     * Draw a decoded picture with the same 90 degree rotation as the pixel path, then free it
+     */
+    private drawVideoFrame(videoFrame: VideoFrame): void {
+        const frame = this.pendingVideoFrames.shift();
+        try {
+            this.ctx.save();
+            this.ctx.clearRect(0, 0, this.width, this.height);
+            this.ctx.translate(this.width, 0);
+            this.ctx.rotate(Math.PI / 2);
+            this.ctx.drawImage(videoFrame, 0, 0);
+            this.ctx.restore();
+        } finally {
+            videoFrame.close();
+        }
+        this.hideNoFrameMessage();
+        this.calculateFps();
+        if (frame) {
+            this.updateStatsFromFrame(frame);
+        }
+    }
+
+    private closeVideoDecoder(): void {
+        if (this.videoDecoder && this.videoDecoder.state !== 'closed') {
+            this.videoDecoder.close();
+        }
+        this.videoDecoder = null;
+        this.videoDecoderKey = '';
+        this.pendingVideoFrames = [];
+    }
+
+    /**
+     * Expand a frame payload into opaque RGBA pixels
+     * @returns the region that changed, or null if the frame could not be decoded
+     */
+    private decodePayload(frame: FrameMessage, rgba: Uint32Array): DirtyRect | null {
+        const pixelCount = frame.width * frame.height;
+        const fullFrame: DirtyRect = { x: 0, y: 0, width: frame.width, height: frame.height };
+
+        if (frame.encoding === ENCODING_TILE_DELTA) {
+            return this.applyTileDelta(frame, rgba);
+        }
+        this.hasDeltaReference = false;
+
+        if (frame.encoding === ENCODING_BITPACK || frame.encoding === ENCODING_BITPACK_RLE) {
+            const rowBytes = (frame.width + 7) >> 3;
+            let packed = frame.payload;
+            if (frame.encoding === ENCODING_BITPACK_RLE) {
+                const length = this.runLengthDecode(frame.payload, rowBytes * frame.height);
+                if (length < 0) {
+                    return null;
+                }
+                packed = this.unpackBuffer;
+            }
+            if (packed.length < rowBytes * frame.height) {
+                console.error(`Bit-packed payload too short: ${packed.length} bytes`);
+                return null;
+            }
+            this.unpackBits(packed, rowBytes, frame.width, frame.height, rgba);
+            return fullFrame;
+        }
+
+        const pixels = frame.payload;
+        if (pixels.length !== pixelCount) {
+            console.error(`Raw payload is ${pixels.length} bytes, expected ${pixelCount}`);
+            return null;
+        }
+        for (let i = 0; i < pixelCount; i++) {
+            const gray = pixels[i];
+            rgba[i] = 0xFF000000 | (gray << 16) | (gray << 8) | gray;
+        }
+        return fullFrame;
+    }
+
+    /**
+     * Patch the changed 32x32 bit-packed tiles into the persistent image. Deltas are
+     * dropped until a keyframe arrives, since they only make sense on top of one.
+     */
+    private applyTileDelta(frame: FrameMessage, rgba: Uint32Array): DirtyRect | null {
+        const payload = frame.payload;
+        if (payload.length < TILE_PAYLOAD_HEADER_SIZE) {
+            console.error('Tile-delta payload too short');
+            return null;
+        }
+
+        const view = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+        const keyframe = (payload[0] & TILE_FLAG_KEYFRAME) !== 0;
+        const tileSize = payload[1];
+        const tileCount = view.getUint32(4, true);
+        if (!keyframe && !this.hasDeltaReference) {
+            return null;
+        }
+
+        const white = 0xFFFFFFFF;
+        const black = 0xFF000000;
+        let minX = frame.width;
+        let minY = frame.height;
+        let maxX = 0;
+        let maxY = 0;
+        let offset = TILE_PAYLOAD_HEADER_SIZE;
+
+        for (let t = 0; t < tileCount; t++) {
+            if (offset + TILE_HEADER_SIZE > payload.length) {
+                console.error('Truncated tile-delta payload');
+                this.hasDeltaReference = false;
+                return null;
+            }
+            const x0 = view.getUint16(offset, true) * tileSize;
+            const y0 = view.getUint16(offset + 2, true) * tileSize;
+            offset += TILE_HEADER_SIZE;
+
+            const tileWidth = Math.min(tileSize, frame.width - x0);
+            const tileHeight = Math.min(tileSize, frame.height - y0);
+            const rowBytes = (tileWidth + 7) >> 3;
+            if (tileWidth <= 0 || tileHeight <= 0 || offset + rowBytes * tileHeight > payload.length) {
+                console.error('Corrupt tile-delta payload');
+                this.hasDeltaReference = false;
+                return null;
+            }
+
+            for (let y = 0; y < tileHeight; y++) {
+                const outStart = (y0 + y) * frame.width + x0;
+                for (let x = 0; x < tileWidth; x++) {
+                    const bit = payload[offset + (x >> 3)] & (0x80 >> (x & 7));
+                    rgba[outStart + x] = bit ? white : black;
+                }
+                offset += rowBytes;
+            }
+
+            minX = Math.min(minX, x0);
+            minY = Math.min(minY, y0);
+            maxX = Math.max(maxX, x0 + tileWidth);
+            maxY = Math.max(maxY, y0 + tileHeight);
+        }
+
+        this.hasDeltaReference = true;
+        if (tileCount === 0) {
+            return { x: 0, y: 0, width: 0, height: 0 };
+        }
+        return { x: minX, y: minY, width: maxX - minX, height: maxY - minY };
+    }
+
+    /**
+     * Bit-packed rows (MSB first, rows byte-aligned) to white-on-black RGBA
+     */
+    private unpackBits(packed: Uint8Array, rowBytes: number, width: number, height: number, rgba: Uint32Array): void {
+        const white = 0xFFFFFFFF;
+        const black = 0xFF000000;
+        for (let y = 0; y < height; y++) {
+            const rowStart = y * rowBytes;
+            const outStart = y * width;
+            for (let x = 0; x < width; x++) {
+                const bit = packed[rowStart + (x >> 3)] & (0x80 >> (x & 7));
+                rgba[outStart + x] = bit ? white : black;
+            }
+        }
+    }
+
+    /**
+     * PackBits decode into unpackBuffer: control c < 128 copies c + 1 literals,
+     * c >= 128 repeats the next byte c - 125 times. Returns decoded length or -1.
+     */
+    private runLengthDecode(input: Uint8Array, expectedLength: number): number {
+        if (this.unpackBuffer.length !== expectedLength) {
+            this.unpackBuffer = new Uint8Array(expectedLength);
+        }
+        const out = this.unpackBuffer;
+        let i = 0;
+        let o = 0;
+        while (i < input.length) {
+            const control = input[i++];
+            if (control < 128) {
+                const count = control + 1;
+                if (o + count > out.length || i + count > input.length) {
+                    console.error('Corrupt run-length payload (literal overflow)');
+                    return -1;
+                }
+                out.set(input.subarray(i, i + count), o);
+                i += count;
+                o += count;
+            } else {
+                const count = control - 125;
+                if (o + count > out.length || i >= input.length) {
+                    console.error('Corrupt run-length payload (run overflow)');
+                    return -1;
+                }
+                out.fill(input[i++], o, o + count);
+                o += count;
+            }
+        }
+        if (o !== expectedLength) {
+            console.error(`Run-length payload decoded to ${o} bytes, expected ${expectedLength}`);
+            return -1;
+        }
+        return o;
+    }
+
+    /**
+     * ImageData and offscreen canvas for frames of this size, (re)created on size change
+     */
+    private getFrameImageData(width: number, height: number): ImageData {
+        if (!this.frameImageData || this.frameImageData.width !== width || this.frameImageData.height !== height) {
+            this.frameCanvas = document.createElement('canvas');
+            this.frameCanvas.width = width;
+            this.frameCanvas.height = height;
+            this.frameCtx = this.frameCanvas.getContext('2d')!;
+            this.frameImageData = this.frameCtx.createImageData(width, height);
+            this.hasDeltaReference = false;
+        }
+        return this.frameImageData;
+    }
+
     /**
      * Calculate FPS from incoming frames
      */
@@ -267,6 +637,7 @@ export class FrameViewer {
      * Clear the canvas
      */
     public clear(): void {
+        this.closeVideoDecoder();
         this.ctx.clearRect(0, 0, this.width, this.height);
         this.showNoFrameMessage();
     }
@@ -2,15 +2,130 @@
  * WebSocket client for receiving real-time frames from EdgeVision Android app
  */
 
+/**
+ * Binary frame protocol (little-endian), mirrors frame_encoder.h on the Android side:
+ * magic u32, version u8, format u8, mode u8, encoding u8, width u32, height u32,
+ * timestamp i64 (ms), fps f32, payload length u32, then the payload.
+ */
+export const FRAME_MAGIC = 0x31465645; // "EVF1"
+export const FRAME_VERSION = 1;
+export const FRAME_HEADER_SIZE = 32;
+
+const PIXEL_FORMATS: Record<number, string> = { 0: 'Grayscale' };
+const PROCESSING_MODES: Record<number, string> = {
+    0: 'Canny Edge Detection',
+    1: 'Grayscale',
+    2: 'Original',
+    3: 'Sobel',
+    4: 'Laplacian',
+    5: 'Threshold'
+};
+
+// Payload encodings; bit-packed frames are decoded in FrameViewer
+export const ENCODING_RAW = 0;
+export const ENCODING_BITPACK = 1;
+export const ENCODING_BITPACK_RLE = 2;
+export const ENCODING_TILE_DELTA = 3;
+export const ENCODING_H264 = 4;     // Hardware video streams, decoded with WebCodecs
+export const ENCODING_HEVC = 5;
+export const ENCODING_CONTOURS = 6; // Edge polylines, drawn as canvas paths
+
+export type FrameCodec = 'raw' | 'bitpack' | 'rle' | 'delta' | 'h264' | 'hevc' | 'contours';
+
 export interface FrameMessage {
-    timestamp: string;
+    timestamp: number;  // ms since epoch
     width: number;
     height: number;
     format: string;
     processingMode: string;
     fps: number;
-    frameData: string;  // Base64 encoded
-    frameSize: number;
+    frameSize: number;  // payload bytes on the wire
+    encoding: number;   // ENCODING_* of payload
+    payload: Uint8Array; // view into the received buffer
+}
+
+/**
+ * Latency summary for one native stage, in microseconds
+ */
+export interface StageStats {
+    count: number;
+    meanUs: number;
+    p50Us: number;
+    p95Us: number;
+    p99Us: number;
+    maxUs: number;
+}
+
+/**
+ * Native resolution / frame-skip governor state
+ */
+export interface GovernorStats {
+    targetUs: number;      // 0 = governor disabled
+    averageUs: number;
+    pyramidLevel: number;  // Canny runs at 1 / 2^pyramidLevel resolution
+    skipInterval: number;  // every skipInterval-th frame is processed
+    minimumStep: number;   // floor imposed by the thermal scheduler
+    skipped: number;
+}
+
+/**
+ * Native thermal scheduler state (ThermalScheduler::toJson)
+ */
+export interface ThermalStats {
+    enabled: boolean;
+    level: number;            // 0 nominal, 1 warm, 2 hot, 3 critical
+    status: number;           // AThermal status, -1 unknown
+    headroom: number;         // 10 s forecast, 1.0 = throttling; negative if unknown
+    minimumStep: number;
+    efficiencyCores: boolean; // pipeline stages on the little cores
+    preferGpu: boolean;
+    littleCores: number;
+    changes: number;
+}
+
+/**
+ * Startup CPU vs OpenCL timing (BackendProbe::toJson)
+ */
+export interface BackendStats {
+    openClAvailable: boolean;
+    device: string;
+    width: number;
+    height: number;
+    cpuMode: number;          // execution mode timed on the CPU
+    cpuUs: number;            // median frame time
+    openClUs: number;         // median frame time, 0 without OpenCL
+    selectedMode: number;
+}
+
+/**
+ * Send-stage counters for one connected viewer (FrameWebSocketServer.clientStatsJson())
+ */
+export interface ClientStats {
+    address: string;
+    encoding: number;
+    level: number;         // Output pyramid level (1 / 2^level per side)
+    maxFps: number;        // 0 = no cap
+    sent: number;
+    dropped: number;       // replaced by a newer frame before the socket took it
+    skipped: number;       // withheld by the viewer's fps cap
+    bytes: number;
+}
+
+/**
+ * Periodic stats message pushed by the Android app (NativeProcessor.getStats())
+ */
+export interface StatsMessage {
+    type: 'stats';
+    fps: number;
+    native: {
+        frames: number;
+        dropped: number;
+        stages: Partial<Record<'copyIn' | 'blur' | 'canny' | 'copyOut' | 'encode' | 'upload' | 'total', StageStats>>;
+        governor?: GovernorStats;
+        thermal?: ThermalStats;
+        backend?: BackendStats;
+    };
+    clients?: ClientStats[];
 }
 
 export type ConnectionStatus = 'disconnected' | 'connecting' | 'connected' | 'error';
@@ -22,10 +137,14 @@ export class WebSocketClient {
     private reconnectDelay = 1000; // Start with 1 second
     private reconnectTimer: number | null = null;
     private isManuallyDisconnected = false;
+    private codec: FrameCodec = 'raw';
+    private maxFps = 0;
+    private level = 0;
 
     // Event callbacks
     public onConnectionStatusChanged: ((status: ConnectionStatus) => void) | null = null;
     public onFrameReceived: ((frame: FrameMessage) => void) | null = null;
+    public onStatsReceived: ((stats: StatsMessage) => void) | null = null;
     public onError: ((error: string) => void) | null = null;
 
     private currentStatus: ConnectionStatus = 'disconnected';
@@ -44,18 +163,22 @@ export class WebSocketClient {
         }
 
         this.isManuallyDisconnected = false;
-        const url = `ws://${host}:${port}`;
+        // The pyramid level is part of the handshake, so changing it needs a reconnect
+        const url = this.level > 0 ? `ws://${host}:${port}/?level=${this.level}` : `ws://${host}:${port}`;
         console.log(`Connecting to WebSocket: ${url}`);
 
         try {
             this.updateStatus('connecting');
             this.ws = new WebSocket(url);
+            this.ws.binaryType = 'arraybuffer';
 
             this.ws.onopen = () => {
                 console.log('WebSocket connected');
                 this.reconnectAttempts = 0;
                 this.reconnectDelay = 1000;
                 this.updateStatus('connected');
+                this.sendCodec();
+                this.sendMaxFps();
             };
 
             this.ws.onmessage = (event) => {
@@ -100,6 +223,44 @@ export class WebSocketClient {
         this.updateStatus('disconnected');
     }
 
+    /**
+     * Select the payload codec the server should use for this client (applies immediately
+     * when connected and again after every reconnect)
+     */
+    public setCodec(codec: FrameCodec): void {
+        this.codec = codec;
+        this.sendCodec();
+    }
+
+    private sendCodec(): void {
+        if (this.isConnected()) {
+            this.ws!.send(`codec:${this.codec}`);
+        }
+    }
+
+    /**
+     * Subscribe to a reduced stream: 0 = full resolution, 1 = 1/2, 2 = 1/4 per side.
+     * Takes effect on the next connect().
+     */
+    public setLevel(level: number): void {
+        this.level = level;
+    }
+
+    /**
+     * Cap the frame rate the server sends this client (0 = every frame); like the codec it
+     * is re-sent after every reconnect
+     */
+    public setMaxFps(fps: number): void {
+        this.maxFps = fps;
+        this.sendMaxFps();
+    }
+
+    private sendMaxFps(): void {
+        if (this.isConnected()) {
+            this.ws!.send(`fps:${this.maxFps}`);
+        }
+    }
+
     /**
      * Check if connected
      */
@@ -117,48 +278,34 @@ export class WebSocketClient {
     /**
      * Handle incoming WebSocket message
      */
-    private handleMessage(data: string): void {
+    private handleMessage(data: string | ArrayBuffer): void {
         try {
-            // Check if it's an echo message (for testing)
-            if (data.startsWith('Echo:')) {
-                console.log('Received echo:', data);
+            if (typeof data === 'string') {
+                // Text messages are stats (JSON) or control/echo traffic, frames are always binary
+                if (data.startsWith('{')) {
+                    const message = JSON.parse(data);
+                    if (message.type === 'stats') {
+                        this.onStatsReceived?.(message as StatsMessage);
+                        return;
+                    }
+                }
+                console.log('Received text message:', data);
                 return;
             }
 
-            // Parse frame message
-            const frame: FrameMessage = JSON.parse(data);
-
-            // Validate frame structure
-            if (!this.isValidFrame(frame)) {
-                console.error('Invalid frame structure:', frame);
+            const frame = decodeFrame(data);
+            if (!frame) {
                 return;
             }
 
             // Emit frame to listeners
             this.onFrameReceived?.(frame);
         } catch (error) {
-            console.error('Error parsing WebSocket message:', error);
-            this.onError?.(`Failed to parse frame: ${error}`);
+            console.error('Error decoding WebSocket message:', error);
+            this.onError?.(`Failed to decode frame: ${error}`);
         }
     }
 
-    /**
-     * Validate frame message structure
-     */
-    private isValidFrame(frame: any): frame is FrameMessage {
-        return (
-            typeof frame === 'object' &&
-            typeof frame.timestamp === 'string' &&
-            typeof frame.width === 'number' &&
-            typeof frame.height === 'number' &&
-            typeof frame.format === 'string' &&
-            typeof frame.processingMode === 'string' &&
-            typeof frame.fps === 'number' &&
-            typeof frame.frameData === 'string' &&
-            typeof frame.frameSize === 'number'
-        );
-    }
-
     /**
      * Schedule reconnection attempt
      */
@@ -196,3 +343,51 @@ export class WebSocketClient {
         }
     }
 }
+
+/**
+ * Decode a binary frame packet header; the returned payload aliases the input buffer (no copy)
+ */
+export function decodeFrame(buffer: ArrayBuffer): FrameMessage | null {
+    if (buffer.byteLength < FRAME_HEADER_SIZE) {
+        console.error(`Frame packet too short: ${buffer.byteLength} bytes`);
+        return null;
+    }
+
+    const view = new DataView(buffer);
+    const magic = view.getUint32(0, true);
+    const version = view.getUint8(4);
+    if (magic !== FRAME_MAGIC || version !== FRAME_VERSION) {
+        console.error(`Unsupported frame packet (magic 0x${magic.toString(16)}, version ${version})`);
+        return null;
+    }
+
+    const format = view.getUint8(5);
+    const mode = view.getUint8(6);
+    const encoding = view.getUint8(7);
+    const width = view.getUint32(8, true);
+    const height = view.getUint32(12, true);
+    const timestamp = Number(view.getBigInt64(16, true));
+    const fps = view.getFloat32(24, true);
+    const payloadLength = view.getUint32(28, true);
+
+    if (encoding < ENCODING_RAW || encoding > ENCODING_CONTOURS) {
+        console.error(`Unsupported payload encoding: ${encoding}`);
+        return null;
+    }
+    if (FRAME_HEADER_SIZE + payloadLength > buffer.byteLength) {
+        console.error(`Truncated payload: ${payloadLength} bytes for ${width}x${height}`);
+        return null;
+    }
+
+    return {
+        timestamp,
+        width,
+        height,
+        format: PIXEL_FORMATS[format] ?? `Format ${format}`,
+        processingMode: PROCESSING_MODES[mode] ?? `Mode ${mode}`,
+        fps,
+        frameSize: payloadLength,
+        encoding,
+        payload: new Uint8Array(buffer, FRAME_HEADER_SIZE, payloadLength)
+    };
+}